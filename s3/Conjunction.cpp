@@ -0,0 +1,420 @@
+#include "Conjunction.h"
+#include "Random.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+// Constants
+const double DEG = 3.14159265358979323846 / 180.0;
+const double MIN_PERIGEE_KM = 6550.0;
+const double COPLANAR_LIMIT = 2.0 * DEG;
+
+static Satellite makeSatellite(const OrbitalElements& el)
+{
+    Satellite sat;
+    sat.orbit = el;
+    sat.perigee = el.periapsis();
+    sat.apogee = el.apoapsis();
+
+    double cO = std::cos(el.longAscendingNode), sO = std::sin(el.longAscendingNode);
+    double cw = std::cos(el.argPeriapsis), sw = std::sin(el.argPeriapsis);
+    double ci = std::cos(el.inclination), si = std::sin(el.inclination);
+    sat.normal = glm::dvec3(sO * si, -cO * si, ci);
+    sat.periapsisDirection = glm::dvec3(cO * cw - sO * sw * ci, sO * cw + cO * sw * ci, sw * si);
+    return sat;
+}
+
+std::vector<Satellite> ConjunctionScreening::generatePopulation(int count, uint64_t seed)
+{
+    Random rng(seed);
+    std::vector<Satellite> satellites;
+    satellites.reserve(std::max(count, 0));
+    const double earthRadius = 6378.137;
+    for (int i = 0; i < count; ++i)
+    {
+        OrbitalElements el;
+        el.mu = EARTH_MU;
+        double kind = rng.uniform();
+        if (kind < 0.70)
+        {
+            // LEO, clustered on the common constellation and sun-synchronous inclinations
+            double altitude = 350.0 + 1050.0 * std::pow(rng.uniform(), 1.5);
+            el.semiMajorAxis = earthRadius + altitude;
+            el.eccentricity = std::min(0.02, std::abs(rng.normal()) * 0.003);
+            double plane = rng.uniform();
+            double inclination = plane < 0.3 ? 53.0 : plane < 0.6 ? 97.5 : plane < 0.7 ? 86.4 : rng.uniform(0.0, 100.0);
+            el.inclination = (inclination + rng.normal() * 0.2) * DEG;
+        }
+        else if (kind < 0.78)
+        {
+            // navigation constellations
+            el.semiMajorAxis = 26560.0 + rng.normal() * 50.0;
+            el.eccentricity = std::abs(rng.normal()) * 0.005;
+            el.inclination = (55.0 + rng.normal()) * DEG;
+        }
+        else if (kind < 0.85)
+        {
+            // transfer orbits and rocket bodies
+            double perigee = earthRadius + rng.uniform(250.0, 600.0);
+            double apogee = 42164.0 + rng.normal() * 200.0;
+            el.semiMajorAxis = 0.5 * (perigee + apogee);
+            el.eccentricity = (apogee - perigee) / (apogee + perigee);
+            el.inclination = rng.uniform(0.0, 28.5) * DEG;
+        }
+        else
+        {
+            // geostationary belt
+            el.semiMajorAxis = 42164.0 + rng.normal() * 20.0;
+            el.eccentricity = std::abs(rng.normal()) * 0.0003;
+            el.inclination = std::abs(rng.normal()) * 0.5 * DEG;
+        }
+        if (el.periapsis() < MIN_PERIGEE_KM)
+            el.eccentricity = 1.0 - MIN_PERIGEE_KM / el.semiMajorAxis;
+        el.longAscendingNode = rng.uniform(0.0, 360.0) * DEG;
+        el.argPeriapsis = rng.uniform(0.0, 360.0) * DEG;
+        el.meanAnomalyAtEpoch = rng.uniform(0.0, 360.0) * DEG;
+        satellites.push_back(makeSatellite(el));
+    }
+    return satellites;
+}
+
+// radius of an orbit in the direction d, which must lie in the orbit's plane
+static double radiusAlong(const Satellite& sat, const glm::dvec3& d)
+{
+    double cosNu = glm::dot(sat.periapsisDirection, d);
+    double sinNu = glm::dot(glm::cross(sat.periapsisDirection, d), sat.normal);
+    double e = sat.orbit.eccentricity;
+    double p = sat.orbit.semiMajorAxis * (1.0 - e * e);
+    return p / (1.0 + e * (cosNu / std::max(1e-12, std::sqrt(cosNu * cosNu + sinNu * sinNu))));
+}
+
+// Orbit path sieve: two non-coplanar orbits can only meet close to the line where their
+// planes intersect. Around each node, over the arc where the out-of-plane separation is
+// below the threshold, compare the radial band each orbit sweeps. Returns true if the pair
+// can be dropped.
+static bool orbitPathClear(const Satellite& a, const Satellite& b, double threshold)
+{
+    glm::dvec3 nodeLine = glm::cross(a.normal, b.normal);
+    double sinRelative = glm::length(nodeLine);
+    if (sinRelative < std::sin(COPLANAR_LIMIT))
+        return false;
+    nodeLine /= sinRelative;
+
+    for (int side = 0; side < 2; ++side)
+    {
+        glm::dvec3 node = side == 0 ? nodeLine : -nodeLine;
+        double r = std::min(radiusAlong(a, node), radiusAlong(b, node));
+        // conservative arc: twice the angle at which the planes separate by the threshold
+        double arc = std::min(glm::pi<double>() / 2.0, 2.0 * std::asin(std::min(1.0, threshold / (r * sinRelative))) + 0.01);
+        glm::dvec3 tangentA = glm::cross(a.normal, node);
+        glm::dvec3 tangentB = glm::cross(b.normal, node);
+        double minA = 1e30, maxA = 0.0, minB = 1e30, maxB = 0.0;
+        const int samples = 9;
+        for (int s = 0; s < samples; ++s)
+        {
+            double phi = -arc + 2.0 * arc * s / (samples - 1);
+            double c = std::cos(phi), sn = std::sin(phi);
+            double ra = radiusAlong(a, node * c + tangentA * sn);
+            double rb = radiusAlong(b, node * c + tangentB * sn);
+            minA = std::min(minA, ra); maxA = std::max(maxA, ra);
+            minB = std::min(minB, rb); maxB = std::max(maxB, rb);
+        }
+        // the bands are sampled, so pad them by the largest step between samples
+        double padA = (maxA - minA) / (samples - 1) + threshold;
+        double padB = (maxB - minB) / (samples - 1) + threshold;
+        if (minA - padA <= maxB + padB && minB - padB <= maxA + padA)
+            return false;
+    }
+    return true;
+}
+
+static double rangeRate(const Satellite& a, const Satellite& b, double t, double& distance, double& speed)
+{
+    glm::dvec3 ra, va, rb, vb;
+    orbitalState(a.orbit, t, ra, va);
+    orbitalState(b.orbit, t, rb, vb);
+    glm::dvec3 dr = ra - rb;
+    glm::dvec3 dv = va - vb;
+    distance = glm::length(dr);
+    speed = glm::length(dv);
+    return glm::dot(dr, dv);
+}
+
+// time of closest approach: root of dot(dr, dv) bracketed in [lo, hi] (Illinois false position)
+static double findTCA(const Satellite& a, const Satellite& b, double lo, double hi, double guess)
+{
+    double d, v;
+    double flo = rangeRate(a, b, lo, d, v);
+    double fhi = rangeRate(a, b, hi, d, v);
+    if (flo > 0.0 || fhi < 0.0)
+        return guess;
+    int side = 0;
+    double t = guess;
+    for (int i = 0; i < 40; ++i)
+    {
+        t = (lo * fhi - hi * flo) / (fhi - flo);
+        double f = rangeRate(a, b, t, d, v);
+        if (std::abs(f) < 1e-9 || hi - lo < 1e-4)
+            break;
+        if (f < 0.0)
+        {
+            lo = t; flo = f;
+            if (side == -1) fhi *= 0.5;
+            side = -1;
+        }
+        else
+        {
+            hi = t; fhi = f;
+            if (side == 1) flo *= 0.5;
+            side = 1;
+        }
+    }
+    return t;
+}
+
+ConjunctionScreening::ConjunctionScreening(ThreadPool& pool) :
+    pool(pool), running(false)
+{
+}
+
+ConjunctionScreening::~ConjunctionScreening()
+{
+    if (pending.valid())
+        pending.wait();
+}
+
+void ConjunctionScreening::run(const ConjunctionSettings& requested)
+{
+    if (running)
+        return;
+    running = true;
+    pending = std::async(std::launch::async, [this, requested] {
+        std::vector<Satellite> satellites = generatePopulation(requested.objectCount, static_cast<uint64_t>(requested.seed));
+        return screen(satellites, requested);
+    });
+}
+
+ConjunctionScreening::Result ConjunctionScreening::screen(const std::vector<Satellite>& satellites, const ConjunctionSettings& config)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const size_t n = satellites.size();
+    const double threshold = std::max(config.thresholdKm, 0.001f);
+    const double step = std::max(config.stepSeconds, 1.0f);
+    const double halfStep = step * 0.5;
+    const size_t steps = static_cast<size_t>(std::ceil(config.windowHours * 3600.0 / step));
+
+    // how far a pair can close in half a step bounds the cell size
+    double lowestPerigee = 1e30, fastest = 0.0;
+    for (const Satellite& sat : satellites)
+    {
+        lowestPerigee = std::min(lowestPerigee, sat.perigee);
+        fastest = std::max(fastest, std::sqrt(EARTH_MU * (2.0 / sat.perigee - 1.0 / sat.orbit.semiMajorAxis)));
+    }
+    const double maxRelativeAccel = 2.0 * EARTH_MU / (lowestPerigee * lowestPerigee);
+    const double curvature = 0.5 * maxRelativeAccel * halfStep * halfStep;
+    const double reach = threshold + 2.0 * fastest * halfStep + curvature;
+    const double cell = reach;
+
+    Result result;
+    result.stats.bruteForcePairs = static_cast<uint64_t>(n) * (n > 0 ? n - 1 : 0) / 2 * steps;
+    std::mutex resultMutex;
+
+    pool.parallelFor(0, steps, [&](size_t k) {
+        const double t = k * step + halfStep;
+        ConjunctionStats local;
+        std::vector<Conjunction> found;
+
+        thread_local std::vector<glm::dvec3> position, velocity;
+        thread_local std::vector<std::pair<uint64_t, int>> keyed;
+        thread_local std::unordered_map<uint64_t, std::pair<int, int>> cells;
+        position.resize(n);
+        velocity.resize(n);
+        keyed.resize(n);
+        cells.clear();
+
+        auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+            const int64_t bias = 1 << 20;
+            return (static_cast<uint64_t>(x + bias) << 42) | (static_cast<uint64_t>(y + bias) << 21) | static_cast<uint64_t>(z + bias);
+        };
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            orbitalState(satellites[i].orbit, t, position[i], velocity[i]);
+            keyed[i] = { cellKey(static_cast<int64_t>(std::floor(position[i].x / cell)),
+                static_cast<int64_t>(std::floor(position[i].y / cell)),
+                static_cast<int64_t>(std::floor(position[i].z / cell))), static_cast<int>(i) };
+        }
+        std::sort(keyed.begin(), keyed.end());
+        for (size_t i = 0; i < n;)
+        {
+            size_t j = i;
+            while (j < n && keyed[j].first == keyed[i].first)
+                ++j;
+            cells.emplace(keyed[i].first, std::make_pair(static_cast<int>(i), static_cast<int>(j)));
+            i = j;
+        }
+
+        auto testPair = [&](int a, int b) {
+            local.gridPairs++;
+            const Satellite& sa = satellites[a];
+            const Satellite& sb = satellites[b];
+
+            // 1. apogee/perigee
+            if (std::max(sa.perigee, sb.perigee) - std::min(sa.apogee, sb.apogee) > threshold)
+            {
+                local.apogeePerigeeRejected++;
+                return;
+            }
+            glm::dvec3 dr = position[a] - position[b];
+            if (glm::dot(dr, dr) > reach * reach)
+            {
+                local.distanceRejected++;
+                return;
+            }
+            // 2. orbit path
+            if (orbitPathClear(sa, sb, threshold))
+            {
+                local.orbitPathRejected++;
+                return;
+            }
+            // 3. time window: the linearised approach must happen inside this step
+            glm::dvec3 dv = velocity[a] - velocity[b];
+            double dv2 = std::max(glm::dot(dv, dv), 1e-12);
+            double tmin = -glm::dot(dr, dv) / dv2;
+            double linearMiss = glm::length(dr + dv * tmin);
+            double bend = 0.5 * maxRelativeAccel * tmin * tmin;
+            if (tmin < -halfStep || tmin >= halfStep || linearMiss > threshold + bend)
+            {
+                local.timeWindowRejected++;
+                return;
+            }
+
+            local.tcaSolved++;
+            double tca = findTCA(sa, sb, t - step, t + step, t + tmin);
+            double distance, speed;
+            rangeRate(sa, sb, tca, distance, speed);
+            if (distance <= threshold)
+                found.push_back({ std::min(a, b), std::max(a, b), tca, distance, speed });
+        };
+
+        for (const auto& entry : cells)
+        {
+            const uint64_t key = entry.first;
+            const int begin = entry.second.first, end = entry.second.second;
+            // pairs inside the cell
+            for (int i = begin; i < end; ++i)
+                for (int j = i + 1; j < end; ++j)
+                    testPair(keyed[i].second, keyed[j].second);
+            // the 13 forward neighbours, so each cell pair is visited once
+            int64_t cx = static_cast<int64_t>(key >> 42) - (1 << 20);
+            int64_t cy = static_cast<int64_t>((key >> 21) & 0x1FFFFF) - (1 << 20);
+            int64_t cz = static_cast<int64_t>(key & 0x1FFFFF) - (1 << 20);
+            for (int dx = -1; dx <= 1; ++dx)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dz = -1; dz <= 1; ++dz)
+                    {
+                        if (dx < 0 || (dx == 0 && dy < 0) || (dx == 0 && dy == 0 && dz <= 0))
+                            continue;
+                        auto other = cells.find(cellKey(cx + dx, cy + dy, cz + dz));
+                        if (other == cells.end())
+                            continue;
+                        for (int i = begin; i < end; ++i)
+                            for (int j = other->second.first; j < other->second.second; ++j)
+                                testPair(keyed[i].second, keyed[j].second);
+                    }
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result.stats.gridPairs += local.gridPairs;
+        result.stats.apogeePerigeeRejected += local.apogeePerigeeRejected;
+        result.stats.distanceRejected += local.distanceRejected;
+        result.stats.orbitPathRejected += local.orbitPathRejected;
+        result.stats.timeWindowRejected += local.timeWindowRejected;
+        result.stats.tcaSolved += local.tcaSolved;
+        result.conjunctions.insert(result.conjunctions.end(), found.begin(), found.end());
+    });
+
+    // an encounter right on a step boundary can be picked up by both neighbouring steps
+    std::sort(result.conjunctions.begin(), result.conjunctions.end(), [](const Conjunction& a, const Conjunction& b) {
+        if (a.first != b.first) return a.first < b.first;
+        if (a.second != b.second) return a.second < b.second;
+        return a.tca < b.tca;
+    });
+    std::vector<Conjunction> unique;
+    for (const Conjunction& c : result.conjunctions)
+    {
+        if (!unique.empty() && unique.back().first == c.first && unique.back().second == c.second &&
+            c.tca - unique.back().tca < step)
+        {
+            if (c.missDistance < unique.back().missDistance)
+                unique.back() = c;
+            continue;
+        }
+        unique.push_back(c);
+    }
+    std::sort(unique.begin(), unique.end(), [](const Conjunction& a, const Conjunction& b) {
+        return a.missDistance < b.missDistance;
+    });
+    result.conjunctions.swap(unique);
+
+    result.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void ConjunctionScreening::update()
+{
+    if (!running || !pending.valid())
+        return;
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    Result result = pending.get();
+    conjunctions = std::move(result.conjunctions);
+    stats = result.stats;
+    running = false;
+}
+
+void ConjunctionScreening::drawPanel()
+{
+    ImGui::Begin("Conjunction Screening");
+
+    ImGui::InputInt("Objects", &settings.objectCount, 1000, 10000);
+    ImGui::SliderFloat("Window (hours)", &settings.windowHours, 1.0f, 72.0f);
+    ImGui::SliderFloat("Step (s)", &settings.stepSeconds, 5.0f, 120.0f);
+    ImGui::SliderFloat("Threshold (km)", &settings.thresholdKm, 0.1f, 50.0f);
+    ImGui::InputInt("Seed", &settings.seed);
+    settings.objectCount = std::max(settings.objectCount, 2);
+
+    if (running)
+        ImGui::Text("Screening...");
+    else if (ImGui::Button("Screen"))
+        run(settings);
+
+    if (stats.seconds > 0.0 && !running)
+    {
+        ImGui::Text("Finished in %.2f s", stats.seconds);
+        ImGui::Text("Brute force pair-steps: %.3g", double(stats.bruteForcePairs));
+        ImGui::Text("Grid neighbour pairs:   %.3g", double(stats.gridPairs));
+        ImGui::Text("  apogee/perigee sieve: -%.3g", double(stats.apogeePerigeeRejected));
+        ImGui::Text("  distance at step:     -%.3g", double(stats.distanceRejected));
+        ImGui::Text("  orbit path sieve:     -%.3g", double(stats.orbitPathRejected));
+        ImGui::Text("  time window sieve:    -%.3g", double(stats.timeWindowRejected));
+        ImGui::Text("TCA root finds: %llu, conjunctions: %d", (unsigned long long)stats.tcaSolved, (int)conjunctions.size());
+
+        ImGui::BeginChild("Conjunctions", ImVec2(0, 200), true);
+        for (size_t i = 0; i < conjunctions.size() && i < 200; ++i)
+        {
+            const Conjunction& c = conjunctions[i];
+            ImGui::Text("#%d x #%d  TCA +%.1f s  miss %.3f km  %.2f km/s", c.first, c.second, c.tca, c.missDistance, c.relativeSpeed);
+        }
+        ImGui::EndChild();
+    }
+
+    ImGui::End();
+}
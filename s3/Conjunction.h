@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Orbit.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+// Geocentric satellite for conjunction screening (km, seconds)
+struct Satellite
+{
+    OrbitalElements orbit;
+    double perigee;        // radius, km
+    double apogee;         // radius, km
+    glm::dvec3 normal;     // orbit plane normal
+    glm::dvec3 periapsisDirection;
+};
+
+struct Conjunction
+{
+    int first;
+    int second;
+    double tca;            // seconds from the start of the window
+    double missDistance;   // km
+    double relativeSpeed;  // km/s
+};
+
+struct ConjunctionSettings
+{
+    int objectCount = 30000;
+    float windowHours = 24.0f;
+    float stepSeconds = 20.0f;
+    float thresholdKm = 10.0f;
+    int seed = 1;
+};
+
+// Counters for each stage of the screening pipeline
+struct ConjunctionStats
+{
+    uint64_t gridPairs = 0;          // pairs sharing neighbouring grid cells
+    uint64_t apogeePerigeeRejected = 0;
+    uint64_t distanceRejected = 0;   // farther than the cell reach at the sample time
+    uint64_t orbitPathRejected = 0;
+    uint64_t timeWindowRejected = 0;
+    uint64_t tcaSolved = 0;
+    uint64_t bruteForcePairs = 0;    // N(N-1)/2 * steps, for comparison
+    double seconds = 0.0;
+};
+
+// All-on-all close approach screening. Each time step is propagated in parallel and binned
+// into a uniform grid whose cells are as wide as the threshold plus the distance a pair can
+// close in half a step; only pairs in neighbouring cells reach the sieves:
+//   1. apogee/perigee: radial shells that can't come within the threshold
+//   2. orbit path: the orbits' geometric separation around the line of mutual nodes
+//   3. time window: the linearised closest approach must fall inside this step
+// Survivors get a bracketed root find of d/dt |r1 - r2|^2 = 0 on the two-body propagation.
+class ConjunctionScreening
+{
+public:
+    explicit ConjunctionScreening(ThreadPool& pool);
+    ~ConjunctionScreening();
+
+    void run(const ConjunctionSettings& settings);
+    bool isRunning() const { return running; }
+    void update();
+
+    void drawPanel();
+    const ConjunctionStats& getStats() const { return stats; }
+
+    const std::vector<Conjunction>& getConjunctions() const { return conjunctions; }
+
+    // seeded population of LEO, MEO, GTO and GEO objects
+    static std::vector<Satellite> generatePopulation(int count, uint64_t seed);
+
+private:
+    struct Result
+    {
+        std::vector<Conjunction> conjunctions;
+        ConjunctionStats stats;
+    };
+
+    Result screen(const std::vector<Satellite>& satellites, const ConjunctionSettings& settings);
+
+    ThreadPool& pool;
+    ConjunctionSettings settings;
+    std::future<Result> pending;
+    std::atomic<bool> running;
+
+    std::vector<Conjunction> conjunctions;
+    ConjunctionStats stats;
+};
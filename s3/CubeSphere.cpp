@@ -0,0 +1,79 @@
+#include "CubeSphere.h"
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+// Constants
+const int MIN_SEGMENT_COUNT = 1;
+const int MAX_SEGMENT_COUNT = 512;
+
+CubeSphere::CubeSphere(float radius, int segments, bool cacheOptimized) :
+    SphereMesh(radius, cacheOptimized), segments(segments)
+{
+    if (this->segments < MIN_SEGMENT_COUNT) this->segments = MIN_SEGMENT_COUNT;
+    if (this->segments > MAX_SEGMENT_COUNT) this->segments = MAX_SEGMENT_COUNT;
+    rebuild();
+}
+
+void CubeSphere::set(float radius, int segments)
+{
+    this->segments = glm::clamp(segments, MIN_SEGMENT_COUNT, MAX_SEGMENT_COUNT);
+    this->radius = radius;
+    rebuild();
+}
+
+void CubeSphere::setSegmentCount(int segments)
+{
+    if (segments != this->segments)
+        set(radius, segments);
+}
+
+void CubeSphere::buildUnitSphere()
+{
+    const int n = segments;
+    // vertices are keyed by their integer cube lattice position so the faces share edges
+    std::unordered_map<uint64_t, unsigned int> lattice;
+    auto vertex = [&](int l[3]) {
+        uint64_t key = (uint64_t(l[0]) << 40) | (uint64_t(l[1]) << 20) | uint64_t(l[2]);
+        auto found = lattice.find(key);
+        if (found != lattice.end())
+            return found->second;
+        glm::vec3 c(2.0f * l[0] / n - 1.0f, 2.0f * l[1] / n - 1.0f, 2.0f * l[2] / n - 1.0f);
+        unsigned int index = addPosition(cubeToSphere(c));
+        lattice.emplace(key, index);
+        return index;
+    };
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        // (b, c) span the face with b x c = +axis, so (00, 10, 11) faces outward on the + side
+        int b = (axis + 1) % 3, c = (axis + 2) % 3;
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                for (int j = 0; j < n; ++j)
+                {
+                    int l00[3], l10[3], l11[3], l01[3];
+                    l00[axis] = l10[axis] = l11[axis] = l01[axis] = side * n;
+                    l00[b] = i;     l00[c] = j;
+                    l10[b] = i + 1; l10[c] = j;
+                    l11[b] = i + 1; l11[c] = j + 1;
+                    l01[b] = i;     l01[c] = j + 1;
+                    unsigned int v00 = vertex(l00), v10 = vertex(l10), v11 = vertex(l11), v01 = vertex(l01);
+                    if (side == 1)
+                    {
+                        addTriangle(v00, v10, v11);
+                        addTriangle(v00, v11, v01);
+                    }
+                    else
+                    {
+                        addTriangle(v00, v11, v10);
+                        addTriangle(v00, v01, v11);
+                    }
+                }
+            }
+        }
+    }
+}
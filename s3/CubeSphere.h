@@ -0,0 +1,38 @@
+#pragma once
+
+#include "SphereMesh.h"
+
+#include <cmath>
+
+// maps a point on the [-1, 1] cube onto the unit sphere (float or double vectors)
+template <typename Vec>
+Vec cubeToSphere(const Vec& c)
+{
+    Vec c2 = c * c;
+    return Vec(c.x * std::sqrt(1 - c2.y / 2 - c2.z / 2 + c2.y * c2.z / 3),
+               c.y * std::sqrt(1 - c2.z / 2 - c2.x / 2 + c2.z * c2.x / 3),
+               c.z * std::sqrt(1 - c2.x / 2 - c2.y / 2 + c2.x * c2.y / 3));
+}
+
+// Sphere built from a cube whose faces are split into segments x segments quads and then
+// projected onto the surface. Uses the area-preserving-ish mapping
+// x' = x * sqrt(1 - y^2/2 - z^2/2 + y^2 z^2 / 3) rather than plain normalisation, which
+// keeps the quads near the cube corners from shrinking. 12 * segments^2 triangles.
+class CubeSphere : public SphereMesh
+{
+public:
+    CubeSphere(float radius = 1.0f, int segments = 8, bool cacheOptimized = true);
+
+    // Getters
+    int getSegmentCount() const { return segments; }
+
+    // Setters
+    void set(float radius, int segments);
+    void setSegmentCount(int segments);
+
+protected:
+    void buildUnitSphere() override;
+
+private:
+    int segments;
+};
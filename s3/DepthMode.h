@@ -0,0 +1,109 @@
+#ifndef DEPTH_MODE_H
+#define DEPTH_MODE_H
+
+#include <glad/glad.h>
+#include "GLState.h"
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+enum DepthMode {
+    DEPTH_STANDARD,       // [-1, 1] clip depth, near 0.1, far 5000
+    DEPTH_REVERSED_Z,     // float depth with 1 at the near plane and 0 at infinity
+    DEPTH_LOGARITHMIC,    // depth written as log(w) by the shaders built with LOG_DEPTH
+    DEPTH_MODE_COUNT
+};
+
+// How the solar-system view maps distance to depth.
+//
+// Standard depth puts nearly all of its precision right in front of the near plane, so the
+// near plane has to stay far out and distant bodies still fight. Reversed-Z maps the near
+// plane to 1 and infinity to 0 in a 32-bit float depth buffer (see SceneFramebuffer); the
+// float exponent then cancels the 1/z falloff and the relative precision is about the same
+// at every distance, with no far plane at all. It needs glClipControl (GL 4.5) to keep
+// clip-space depth in [0, 1] instead of [-1, 1]. Without it, logarithmic depth gets a
+// similar spread in any depth format, at the cost of writing gl_FragDepth, which turns off
+// early depth testing for those programs.
+class SceneDepth
+{
+public:
+    DepthMode mode;
+
+    SceneDepth() : mode(DEPTH_STANDARD) {}
+
+    static bool reversedZSupported()
+    {
+        return GLAD_GL_VERSION_4_5 && glClipControl != NULL;
+    }
+
+    // the mode in use: reversed-Z falls back to logarithmic depth without glClipControl
+    DepthMode activeMode() const
+    {
+        if (mode == DEPTH_REVERSED_Z && !reversedZSupported())
+            return DEPTH_LOGARITHMIC;
+        return mode;
+    }
+
+    // scene units are a tenth of an AU (about 1.5e7 km): 1e-6 is about 15 km, 1e7 about 16
+    // light-years. Positions are float world coordinates, whose spacing is already ~15 km
+    // around 1 AU and ~450 km at Neptune, so a closer near plane would buy nothing; getting
+    // down to metres would take camera-relative rendering
+    float nearPlane() const { return activeMode() == DEPTH_STANDARD ? 0.1f : 1e-6f; }
+    float farPlane() const { return activeMode() == DEPTH_STANDARD ? 5000.0f : 1e7f; }
+
+    glm::mat4 projection(float fovY, float aspect) const
+    {
+        if (activeMode() != DEPTH_REVERSED_Z)
+            return glm::perspective(fovY, aspect, nearPlane(), farPlane());
+
+        // infinite far plane: z_clip = near, w_clip = -z_eye, so depth = near / distance
+        float f = 1.0f / std::tan(fovY * 0.5f);
+        glm::mat4 result(0.0f);
+        result[0][0] = f / aspect;
+        result[1][1] = f;
+        result[2][3] = -1.0f;
+        result[3][2] = nearPlane();
+        return result;
+    }
+
+    // depthParams.x of the Frame block
+    float logCoefficient() const
+    {
+        return activeMode() == DEPTH_LOGARITHMIC ? 2.0f / std::log2(farPlane() + 1.0f) : 0.0f;
+    }
+
+    // defines for the programs that draw into the solar-system view
+    std::vector<std::string> shaderDefines() const
+    {
+        std::vector<std::string> defines;
+        if (activeMode() == DEPTH_LOGARITHMIC)
+            defines.push_back("LOG_DEPTH");
+        return defines;
+    }
+
+    float clearDepth() const { return activeMode() == DEPTH_REVERSED_Z ? 0.0f : 1.0f; }
+
+    // clip control, depth function and clear value for the mode
+    void apply() const
+    {
+        bool reversed = activeMode() == DEPTH_REVERSED_Z;
+        if (reversedZSupported())
+            glClipControl(GL_LOWER_LEFT, reversed ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+        GLState::get().depthFunc(reversed ? GL_GREATER : GL_LESS);
+        glClearDepth(clearDepth());
+    }
+
+    // back to conventional depth, for passes with their own projection
+    static void restore()
+    {
+        if (reversedZSupported())
+            glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+        GLState::get().depthFunc(GL_LESS);
+        glClearDepth(1.0f);
+    }
+};
+
+#endif // DEPTH_MODE_H
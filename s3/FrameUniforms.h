@@ -0,0 +1,36 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm.hpp>
+
+// binding point of the per-frame block; Shader links every program's "Frame" block to it
+const unsigned int FRAME_UNIFORM_BINDING = 0;
+
+// CPU mirror of the std140 block declared in the shaders:
+//
+//   layout (std140) uniform Frame {
+//       mat4 view;
+//       mat4 projection;
+//       mat4 viewProjection;
+//       vec4 cameraPosition;   // xyz
+//       vec4 lightPosition;    // xyz
+//       vec4 lightColor;       // rgb, w = intensity
+//       vec4 depthParams;      // x = logarithmic depth coefficient, 0 when off
+//   };
+//
+// mat4 and vec4 members are 16-byte aligned in std140, so the plain struct already matches.
+// It is written into the StreamBuffer once per frame and bound to FRAME_UNIFORM_BINDING from
+// there, one upload instead of a glUniform call per program.
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition;
+    glm::vec4 lightPosition;
+    glm::vec4 lightColor;
+    glm::vec4 depthParams;
+};
+
+#endif // FRAME_UNIFORMS_H
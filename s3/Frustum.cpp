@@ -0,0 +1,79 @@
+#include "Frustum.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_USE_SSE
+#endif
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // row 3 +- rows 0, 1, 2 (glm is column-major: m[column][row])
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int sign = 0; sign < 2; ++sign)
+        {
+            glm::vec4 plane;
+            for (int column = 0; column < 4; ++column)
+                plane[column] = viewProjection[column][3] + (sign ? -1.0f : 1.0f) * viewProjection[column][i];
+            planes[i * 2 + sign] = plane / glm::length(glm::vec3(plane));
+        }
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    return true;
+}
+
+void BoundingSpheres::resize(size_t count)
+{
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+}
+
+size_t cullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, size_t begin, size_t end, unsigned char* visible)
+{
+    size_t count = 0;
+    size_t i = begin;
+#ifdef FRUSTUM_USE_SSE
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres.x[i]), y = _mm_loadu_ps(&spheres.y[i]), z = _mm_loadu_ps(&spheres.z[i]);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+                _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            unsigned char inside = (mask >> lane) & 1 ? 0 : 1;
+            visible[i + lane] = inside;
+            count += inside;
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        bool inside = frustum.intersectsSphere(glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]);
+        visible[i] = inside ? 1 : 0;
+        count += inside ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// The six clip planes of a view-projection matrix (Gribb-Hartmann), normals pointing inwards
+// and normalised, so plane . (p, 1) is the signed distance of p from the plane.
+struct Frustum
+{
+    glm::vec4 planes[6];    // left, right, bottom, top, near, far
+
+    Frustum() {}
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+// Bounding spheres kept as structure-of-arrays so four of them are tested per instruction.
+struct BoundingSpheres
+{
+    std::vector<float> x, y, z, radius;
+
+    size_t size() const { return x.size(); }
+    void resize(size_t count);
+    void set(size_t index, const glm::vec3& center, float r)
+    {
+        x[index] = center.x;
+        y[index] = center.y;
+        z[index] = center.z;
+        radius[index] = r;
+    }
+};
+
+// tests spheres [begin, end) against the frustum; visible[i] is set to 1 for spheres inside
+// or crossing it and 0 for the rest. Returns the number of visible spheres.
+size_t cullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, size_t begin, size_t end, unsigned char* visible);
@@ -0,0 +1,254 @@
+#include "GLState.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+GLState& GLState::get()
+{
+    static GLState state;
+    return state;
+}
+
+// the defaults of a new context, which is when the first call comes in
+GLState::GLState() :
+    program(0), vertexArray(0), activeUnit(0),
+    face(GL_BACK), depth(GL_LESS), depthWrite(GL_TRUE), blendSource(GL_ONE), blendDestination(GL_ZERO),
+    colorWrite(GL_TRUE), polygon(GL_FILL),
+    issued(0), saved(0), lastIssued(0), lastSaved(0)
+{
+    for (unsigned int unit = 0; unit < MAX_UNITS; ++unit)
+        for (int target = 0; target < TARGET_COUNT; ++target)
+            textures[unit][target] = 0;
+    for (int capability = 0; capability < CAP_COUNT; ++capability)
+        capabilities[capability] = GL_FALSE;
+    capabilities[CAP_MULTISAMPLE] = GL_TRUE;
+}
+
+int GLState::capabilityIndex(unsigned int capability)
+{
+    switch (capability)
+    {
+    case GL_CULL_FACE: return CAP_CULL_FACE;
+    case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+    case GL_BLEND: return CAP_BLEND;
+    case GL_MULTISAMPLE: return CAP_MULTISAMPLE;
+    case GL_PROGRAM_POINT_SIZE: return CAP_PROGRAM_POINT_SIZE;
+    default: return -1;
+    }
+}
+
+int GLState::targetIndex(unsigned int target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D: return TARGET_2D;
+    case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+    case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+    case GL_TEXTURE_3D: return TARGET_3D;
+    case GL_TEXTURE_2D_MULTISAMPLE: return TARGET_2D_MULTISAMPLE;
+    default: return -1;
+    }
+}
+
+bool GLState::change(unsigned int& shadow, unsigned int value)
+{
+    if (shadow == value)
+    {
+        ++saved;
+        return false;
+    }
+    shadow = value;
+    ++issued;
+    return true;
+}
+
+void GLState::useProgram(unsigned int id)
+{
+    if (change(program, id))
+        glUseProgram(id);
+}
+
+void GLState::bindVertexArray(unsigned int id)
+{
+    if (change(vertexArray, id))
+        glBindVertexArray(id);
+}
+
+void GLState::activeTexture(unsigned int unit)
+{
+    if (change(activeUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    int index = targetIndex(target);
+    if (unit >= MAX_UNITS || index < 0)
+    {
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        ++issued;
+        return;
+    }
+    if (textures[unit][index] == texture)
+    {
+        ++saved;
+        return;
+    }
+    activeTexture(unit);
+    change(textures[unit][index], texture);
+    glBindTexture(target, texture);
+}
+
+void GLState::bindTexture(unsigned int target, unsigned int texture)
+{
+    if (activeUnit == UNKNOWN)
+    {
+        // the unit is unknown, so is what's bound on it
+        glBindTexture(target, texture);
+        ++issued;
+        return;
+    }
+    bindTexture(activeUnit, target, texture);
+}
+
+void GLState::deleteProgram(unsigned int id)
+{
+    if (program == id)
+        program = UNKNOWN;
+    glDeleteProgram(id);
+}
+
+void GLState::deleteVertexArrays(int count, const unsigned int* ids)
+{
+    // GL falls back to vertex array 0 when the bound one goes
+    for (int i = 0; i < count; ++i)
+        if (ids[i] != 0 && vertexArray == ids[i])
+            vertexArray = 0;
+    glDeleteVertexArrays(count, ids);
+}
+
+void GLState::deleteTextures(int count, const unsigned int* ids)
+{
+    // and unbinds deleted textures from every unit
+    for (int i = 0; i < count; ++i)
+    {
+        if (ids[i] == 0)
+            continue;
+        for (unsigned int unit = 0; unit < MAX_UNITS; ++unit)
+            for (int target = 0; target < TARGET_COUNT; ++target)
+                if (textures[unit][target] == ids[i])
+                    textures[unit][target] = 0;
+    }
+    glDeleteTextures(count, ids);
+}
+
+void GLState::enable(unsigned int capability, bool enabled)
+{
+    int index = capabilityIndex(capability);
+    if (index < 0)
+    {
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+        ++issued;
+        return;
+    }
+    if (!change(capabilities[index], enabled ? GL_TRUE : GL_FALSE))
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::cullFace(unsigned int mode)
+{
+    if (change(face, mode))
+        glCullFace(mode);
+}
+
+void GLState::depthFunc(unsigned int func)
+{
+    if (change(depth, func))
+        glDepthFunc(func);
+}
+
+void GLState::depthMask(bool write)
+{
+    if (change(depthWrite, write ? GL_TRUE : GL_FALSE))
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::blendFunc(unsigned int source, unsigned int destination)
+{
+    if (blendSource == source && blendDestination == destination)
+    {
+        ++saved;
+        return;
+    }
+    blendSource = source;
+    blendDestination = destination;
+    ++issued;
+    glBlendFunc(source, destination);
+}
+
+void GLState::colorMask(bool write)
+{
+    const GLboolean value = write ? GL_TRUE : GL_FALSE;
+    if (change(colorWrite, value))
+        glColorMask(value, value, value, value);
+}
+
+void GLState::polygonMode(unsigned int mode)
+{
+    if (change(polygon, mode))
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+bool GLState::isEnabled(unsigned int capability)
+{
+    int index = capabilityIndex(capability);
+    if (index < 0)
+        return glIsEnabled(capability) == GL_TRUE;
+    if (capabilities[index] == UNKNOWN)
+        capabilities[index] = glIsEnabled(capability) == GL_TRUE ? GL_TRUE : GL_FALSE;
+    return capabilities[index] == GL_TRUE;
+}
+
+unsigned int GLState::getPolygonMode()
+{
+    if (polygon == UNKNOWN)
+    {
+        GLint modes[2];
+        glGetIntegerv(GL_POLYGON_MODE, modes);
+        polygon = static_cast<unsigned int>(modes[0]);
+    }
+    return polygon;
+}
+
+void GLState::invalidate()
+{
+    program = vertexArray = activeUnit = UNKNOWN;
+    for (unsigned int unit = 0; unit < MAX_UNITS; ++unit)
+        for (int target = 0; target < TARGET_COUNT; ++target)
+            textures[unit][target] = UNKNOWN;
+    for (int capability = 0; capability < CAP_COUNT; ++capability)
+        capabilities[capability] = UNKNOWN;
+    face = depth = depthWrite = blendSource = blendDestination = colorWrite = polygon = UNKNOWN;
+}
+
+void GLState::beginFrame()
+{
+    lastIssued = issued;
+    lastSaved = saved;
+    issued = saved = 0;
+}
+
+void GLState::drawStats()
+{
+    const size_t total = lastIssued + lastSaved;
+    ImGui::Text("GL state calls: %zu issued, %zu skipped (%.0f%%)", lastIssued, lastSaved,
+        total > 0 ? 100.0 * lastSaved / total : 0.0);
+}
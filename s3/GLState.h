@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+
+// Shadow of the GL state the renderer switches most: the bound program, vertex array and
+// textures per unit, face culling, depth and blend state, colour mask and polygon mode. Every
+// setter compares against the shadow and only calls GL when the value actually changes, so
+// callers can set what they need before each draw without tracking what was set before.
+//
+// The shadow is only right if these are never changed behind its back: all code in the tree
+// goes through it (Dear ImGui's renderer saves and restores what it touches). A freshly
+// created or unknown state counts as different from everything, so the first call always
+// goes through; invalidate() forgets the shadow after foreign code changed the state.
+// Deleting a program, vertex array or texture has to go through here too, since GL unbinds
+// deleted objects and may hand the name out again.
+class GLState
+{
+public:
+    static GLState& get();
+
+    void useProgram(unsigned int program);
+    void bindVertexArray(unsigned int vertexArray);
+    // binds on the given unit, selecting it first if needed
+    void bindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+    // binds on the currently active unit (texture creation and uploads)
+    void bindTexture(unsigned int target, unsigned int texture);
+    void activeTexture(unsigned int unit);
+
+    void deleteProgram(unsigned int program);
+    void deleteVertexArrays(int count, const unsigned int* vertexArrays);
+    void deleteTextures(int count, const unsigned int* textures);
+
+    // GL_CULL_FACE, GL_DEPTH_TEST, GL_BLEND, GL_MULTISAMPLE or GL_PROGRAM_POINT_SIZE; other
+    // capabilities go straight to GL
+    void enable(unsigned int capability, bool enabled = true);
+    void disable(unsigned int capability) { enable(capability, false); }
+    void cullFace(unsigned int face);
+    void depthFunc(unsigned int func);
+    void depthMask(bool write);
+    void blendFunc(unsigned int source, unsigned int destination);
+    void colorMask(bool write);
+    void polygonMode(unsigned int mode);
+
+    // read back from GL the first time if the shadow doesn't know them yet
+    bool isEnabled(unsigned int capability);
+    unsigned int getPolygonMode();
+
+    void invalidate();
+
+    // starts the counters of a new frame; the last frame's stay readable
+    void beginFrame();
+    void drawStats();
+
+    size_t getIssued() const { return lastIssued; }
+    size_t getSaved() const { return lastSaved; }
+
+private:
+    GLState();
+
+    enum Capability { CAP_CULL_FACE, CAP_DEPTH_TEST, CAP_BLEND, CAP_MULTISAMPLE, CAP_PROGRAM_POINT_SIZE, CAP_COUNT };
+    enum Target { TARGET_2D, TARGET_2D_ARRAY, TARGET_CUBE_MAP, TARGET_3D, TARGET_2D_MULTISAMPLE, TARGET_COUNT };
+    static const unsigned int MAX_UNITS = 32;
+    static const unsigned int UNKNOWN = ~0u;
+
+    static int capabilityIndex(unsigned int capability);
+    static int targetIndex(unsigned int target);
+    // true if the call has to be made; counts it either way
+    bool change(unsigned int& shadow, unsigned int value);
+
+    unsigned int program, vertexArray, activeUnit;
+    unsigned int textures[MAX_UNITS][TARGET_COUNT];
+    unsigned int capabilities[CAP_COUNT];
+    unsigned int face, depth, depthWrite, blendSource, blendDestination, colorWrite, polygon;
+
+    size_t issued, saved, lastIssued, lastSaved;
+};
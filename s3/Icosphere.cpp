@@ -0,0 +1,89 @@
+#include "Icosphere.h"
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+// Constants
+const int MIN_SUBDIVISIONS = 0;
+const int MAX_SUBDIVISIONS = 8;     // 1.3M triangles
+
+Icosphere::Icosphere(float radius, int subdivisions, bool cacheOptimized) :
+    SphereMesh(radius, cacheOptimized), subdivisions(subdivisions)
+{
+    if (this->subdivisions < MIN_SUBDIVISIONS) this->subdivisions = MIN_SUBDIVISIONS;
+    if (this->subdivisions > MAX_SUBDIVISIONS) this->subdivisions = MAX_SUBDIVISIONS;
+    rebuild();
+}
+
+void Icosphere::set(float radius, int subdivisions)
+{
+    this->subdivisions = glm::clamp(subdivisions, MIN_SUBDIVISIONS, MAX_SUBDIVISIONS);
+    this->radius = radius;
+    rebuild();
+}
+
+void Icosphere::setSubdivisionCount(int subdivisions)
+{
+    if (subdivisions != this->subdivisions)
+        set(radius, subdivisions);
+}
+
+void Icosphere::buildUnitSphere()
+{
+    // icosahedron with two vertices on the poles (y = +-1) and the rest on two rings
+    const float PI = acos(-1.0f);
+    const float ringY = 1.0f / sqrtf(5.0f);
+    const float ringRadius = 2.0f / sqrtf(5.0f);
+
+    addPosition(glm::vec3(0.0f, 1.0f, 0.0f));
+    for (int i = 0; i < 5; ++i)
+    {
+        float angle = i * 2.0f * PI / 5.0f;
+        addPosition(glm::vec3(ringRadius * cosf(angle), ringY, ringRadius * sinf(angle)));
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        float angle = (i + 0.5f) * 2.0f * PI / 5.0f;
+        addPosition(glm::vec3(ringRadius * cosf(angle), -ringY, ringRadius * sinf(angle)));
+    }
+    addPosition(glm::vec3(0.0f, -1.0f, 0.0f));
+
+    // counter-clockwise seen from outside
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        unsigned int upper = 1 + i, upperNext = 1 + (i + 1) % 5;
+        unsigned int lower = 6 + i, lowerNext = 6 + (i + 1) % 5;
+        addTriangle(0, upperNext, upper);
+        addTriangle(upper, upperNext, lower);
+        addTriangle(upperNext, lowerNext, lower);
+        addTriangle(11, lower, lowerNext);
+    }
+
+    for (int level = 0; level < subdivisions; ++level)
+    {
+        std::unordered_map<uint64_t, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            uint64_t key = a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+                return found->second;
+            unsigned int index = addPosition(positions[a] + positions[b]);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<unsigned int> coarse;
+        coarse.swap(indices);
+        indices.reserve(coarse.size() * 4);
+        for (size_t t = 0; t < coarse.size(); t += 3)
+        {
+            unsigned int a = coarse[t], b = coarse[t + 1], c = coarse[t + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            addTriangle(a, ab, ca);
+            addTriangle(ab, b, bc);
+            addTriangle(ca, bc, c);
+            addTriangle(ab, bc, ca);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "SphereMesh.h"
+
+// Sphere built by repeatedly splitting the faces of an icosahedron into four and pushing
+// the new vertices out to the surface. Triangles stay nearly equilateral everywhere, so
+// unlike the UV sphere no vertices are spent on slivers around the poles.
+// Subdivision level n gives 20 * 4^n triangles.
+class Icosphere : public SphereMesh
+{
+public:
+    Icosphere(float radius = 1.0f, int subdivisions = 3, bool cacheOptimized = true);
+
+    // Getters
+    int getSubdivisionCount() const { return subdivisions; }
+
+    // Setters
+    void set(float radius, int subdivisions);
+    void setSubdivisionCount(int subdivisions);
+
+protected:
+    void buildUnitSphere() override;
+
+private:
+    int subdivisions;
+};
@@ -0,0 +1,356 @@
+#include "Lambert.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <gtc/constants.hpp>
+
+// Constants
+const int LAMBERT_MAX_ITERATIONS = 35;
+const double LAMBERT_ATOL = 1e-10;
+const double LAMBERT_RTOL = 1e-10;
+
+// Gauss hypergeometric series 2F1(3, 1, 5/2, x), used near the parabolic case
+static double hyp2f1b(double x)
+{
+    if (x >= 1.0)
+        return std::numeric_limits<double>::infinity();
+    double result = 1.0;
+    double term = 1.0;
+    for (int i = 0; i < 200; ++i)
+    {
+        term = term * (3.0 + i) * (1.0 + i) / (2.5 + i) * x / (i + 1.0);
+        double previous = result;
+        result += term;
+        if (previous == result)
+            break;
+    }
+    return result;
+}
+
+static double computeY(double x, double l)
+{
+    return std::sqrt(1.0 - l * l * (1.0 - x * x));
+}
+
+static double computePsi(double x, double y, double l)
+{
+    if (x >= -1.0 && x < 1.0)
+        return std::acos(std::clamp(x * y + l * (1.0 - x * x), -1.0, 1.0));
+    if (x > 1.0)
+        return std::asinh((y - x * l) * std::sqrt(x * x - 1.0));
+    return 0.0;
+}
+
+// non-dimensional time of flight as a function of x (Izzo 2015, eq. 18 and the series form near x = 1)
+static double timeOfFlight(double x, double y, double l, int M)
+{
+    const double pi = glm::pi<double>();
+    if (M == 0 && x > std::sqrt(0.6) && x < std::sqrt(1.4))
+    {
+        double eta = y - l * x;
+        double S1 = (1.0 - l - x * eta) * 0.5;
+        double Q = 4.0 / 3.0 * hyp2f1b(S1);
+        return (eta * eta * eta * Q + 4.0 * l * eta) * 0.5;
+    }
+    double psi = computePsi(x, y, l);
+    double oneMinusX2 = 1.0 - x * x;
+    return ((psi + M * pi) / std::sqrt(std::abs(oneMinusX2)) - x + l * y) / oneMinusX2;
+}
+
+static void timeOfFlightDerivatives(double x, double y, double T, double l, double& d1, double& d2, double& d3)
+{
+    double oneMinusX2 = 1.0 - x * x;
+    double l2 = l * l;
+    double l3 = l2 * l;
+    double l5 = l3 * l2;
+    double y3 = y * y * y;
+    d1 = (3.0 * T * x - 2.0 + 2.0 * l3 * x / y) / oneMinusX2;
+    d2 = (3.0 * T + 5.0 * x * d1 + 2.0 * (1.0 - l2) * l3 / y3) / oneMinusX2;
+    d3 = (7.0 * x * d2 + 8.0 * d1 - 6.0 * (1.0 - l2) * l5 * x / (y3 * y * y)) / oneMinusX2;
+}
+
+// minimum non-dimensional time of flight reachable with M full revolutions
+static bool computeTmin(double l, int M, double& Tmin)
+{
+    if (M == 0)
+    {
+        Tmin = 0.0;
+        return true;
+    }
+    double x = 0.1;
+    for (int i = 0; i < LAMBERT_MAX_ITERATIONS; ++i)
+    {
+        double y = computeY(x, l);
+        double T = timeOfFlight(x, y, l, M);
+        double d1, d2, d3;
+        timeOfFlightDerivatives(x, y, T, l, d1, d2, d3);
+        double denominator = 2.0 * d2 * d2 - d1 * d3;
+        if (denominator == 0.0)
+            return false;
+        double xNew = x - 2.0 * d1 * d2 / denominator;
+        bool converged = std::abs(xNew - x) < LAMBERT_RTOL * std::abs(x) + LAMBERT_ATOL;
+        x = xNew;
+        if (converged)
+        {
+            Tmin = timeOfFlight(x, computeY(x, l), l, M);
+            return true;
+        }
+    }
+    return false;
+}
+
+static double initialGuess(double T, double l, int M, bool lowPath)
+{
+    const double pi = glm::pi<double>();
+    if (M == 0)
+    {
+        double T0 = std::acos(l) + l * std::sqrt(1.0 - l * l);
+        double T1 = 2.0 * (1.0 - l * l * l) / 3.0;
+        if (T >= T0)
+            return std::pow(T0 / T, 2.0 / 3.0) - 1.0;
+        if (T < T1)
+            return 2.5 * T1 / T * (T1 - T) / (1.0 - std::pow(l, 5.0)) + 1.0;
+        return std::exp(std::log(2.0) * std::log(T / T0) / std::log(T1 / T0)) - 1.0;
+    }
+    double a = std::pow((M * pi + pi) / (8.0 * T), 2.0 / 3.0);
+    double b = std::pow((8.0 * T) / (M * pi), 2.0 / 3.0);
+    double xLeft = (a - 1.0) / (a + 1.0);
+    double xRight = (b - 1.0) / (b + 1.0);
+    return lowPath ? std::max(xLeft, xRight) : std::min(xLeft, xRight);
+}
+
+static bool householder(double& x, double T0, double l, int M)
+{
+    for (int i = 0; i < LAMBERT_MAX_ITERATIONS; ++i)
+    {
+        double y = computeY(x, l);
+        double T = timeOfFlight(x, y, l, M);
+        double f = T - T0;
+        double d1, d2, d3;
+        timeOfFlightDerivatives(x, y, T, l, d1, d2, d3);
+        double denominator = d1 * (d1 * d1 - f * d2) + d3 * f * f / 6.0;
+        if (denominator == 0.0 || !std::isfinite(denominator))
+            return false;
+        double xNew = x - f * ((d1 * d1 - f * d2 / 2.0) / denominator);
+        bool converged = std::abs(xNew - x) < LAMBERT_RTOL * std::abs(x) + LAMBERT_ATOL;
+        x = xNew;
+        if (converged)
+            return std::isfinite(x);
+    }
+    return false;
+}
+
+// highest revolution count that is feasible for the given non-dimensional time of flight
+static int maxFeasibleRevolutions(double T, double l, int requested)
+{
+    const double pi = glm::pi<double>();
+    int Mmax = static_cast<int>(std::floor(T / pi));
+    Mmax = std::min(Mmax, requested);
+    double T00 = std::acos(l) + l * std::sqrt(1.0 - l * l);
+    if (Mmax > 0 && T < T00 + Mmax * pi)
+    {
+        double Tmin;
+        if (!computeTmin(l, Mmax, Tmin) || T < Tmin)
+            --Mmax;
+    }
+    return std::max(Mmax, 0);
+}
+
+// Geometry common to the scalar and batched paths
+struct LambertGeometry
+{
+    double lambda;
+    double T;
+    double s;
+    double cNorm;
+    glm::dvec3 it1, it2;
+};
+
+static bool lambertGeometry(const glm::dvec3& r1, double r1n, const glm::dvec3& r2, double r2n,
+    double tof, double mu, bool prograde, LambertGeometry& g)
+{
+    glm::dvec3 c = r2 - r1;
+    g.cNorm = glm::length(c);
+    g.s = (r1n + r2n + g.cNorm) * 0.5;
+    glm::dvec3 ir1 = r1 / r1n;
+    glm::dvec3 ir2 = r2 / r2n;
+    glm::dvec3 ih = glm::cross(ir1, ir2);
+    double ihn = glm::length(ih);
+    if (tof <= 0.0 || ihn < 1e-12 || g.cNorm <= 0.0)
+        return false;
+    ih /= ihn;
+    g.lambda = std::sqrt(1.0 - std::min(1.0, g.cNorm / g.s));
+    if (ih.z < 0.0)
+    {
+        g.lambda = -g.lambda;
+        g.it1 = glm::cross(ir1, ih);
+        g.it2 = glm::cross(ir2, ih);
+    }
+    else
+    {
+        g.it1 = glm::cross(ih, ir1);
+        g.it2 = glm::cross(ih, ir2);
+    }
+    if (!prograde)
+    {
+        g.lambda = -g.lambda;
+        g.it1 = -g.it1;
+        g.it2 = -g.it2;
+    }
+    g.T = std::sqrt(2.0 * mu / (g.s * g.s * g.s)) * tof;
+    return true;
+}
+
+static void reconstruct(double x, const LambertGeometry& g, const glm::dvec3& r1, double r1n,
+    const glm::dvec3& r2, double r2n, double mu, glm::dvec3& v1, glm::dvec3& v2)
+{
+    double l = g.lambda;
+    double y = computeY(x, l);
+    double gamma = std::sqrt(mu * g.s / 2.0);
+    double rho = (r1n - r2n) / g.cNorm;
+    double sigma = std::sqrt(std::max(0.0, 1.0 - rho * rho));
+    double vr1 = gamma * ((l * y - x) - rho * (l * y + x)) / r1n;
+    double vr2 = -gamma * ((l * y - x) + rho * (l * y + x)) / r2n;
+    double vt1 = gamma * sigma * (y + l * x) / r1n;
+    double vt2 = gamma * sigma * (y + l * x) / r2n;
+    v1 = vr1 * (r1 / r1n) + vt1 * g.it1;
+    v2 = vr2 * (r2 / r2n) + vt2 * g.it2;
+}
+
+int solveLambert(const glm::dvec3& r1, const glm::dvec3& r2, double timeOfFlight, double mu,
+    int maxRevolutions, bool prograde, std::vector<LambertSolution>& solutions)
+{
+    double r1n = glm::length(r1);
+    double r2n = glm::length(r2);
+    LambertGeometry g;
+    if (!lambertGeometry(r1, r1n, r2, r2n, timeOfFlight, mu, prograde, g))
+        return 0;
+
+    int found = 0;
+    int Mmax = maxFeasibleRevolutions(g.T, g.lambda, maxRevolutions);
+    for (int M = 0; M <= Mmax; ++M)
+    {
+        for (int branch = 0; branch < (M == 0 ? 1 : 2); ++branch)
+        {
+            bool lowPath = branch == 0;
+            double x = initialGuess(g.T, g.lambda, M, lowPath);
+            if (!householder(x, g.T, g.lambda, M))
+                continue;
+            LambertSolution solution;
+            reconstruct(x, g, r1, r1n, r2, r2n, mu, solution.v1, solution.v2);
+            solution.revolutions = M;
+            solution.lowPath = lowPath;
+            solutions.push_back(solution);
+            ++found;
+        }
+    }
+    return found;
+}
+
+void LambertBatch::setArrivals(const std::vector<glm::dvec3>& positions, const std::vector<glm::dvec3>& velocities)
+{
+    count = positions.size();
+    r2x.resize(count); r2y.resize(count); r2z.resize(count);
+    v2x.resize(count); v2y.resize(count); v2z.resize(count);
+    r2n.resize(count);
+    for (size_t j = 0; j < count; ++j)
+    {
+        r2x[j] = positions[j].x; r2y[j] = positions[j].y; r2z[j] = positions[j].z;
+        v2x[j] = velocities[j].x; v2y[j] = velocities[j].y; v2z[j] = velocities[j].z;
+    }
+    for (size_t j = 0; j < count; ++j)
+        r2n[j] = std::sqrt(r2x[j] * r2x[j] + r2y[j] * r2y[j] + r2z[j] * r2z[j]);
+
+    lambda.resize(count); T.resize(count); s.resize(count); cNorm.resize(count);
+    it1x.resize(count); it1y.resize(count); it1z.resize(count);
+    it2x.resize(count); it2y.resize(count); it2z.resize(count);
+    bestCost.resize(count); bestC3.resize(count); bestVinf.resize(count);
+}
+
+void LambertBatch::solveRow(const glm::dvec3& r1, const glm::dvec3& v1Body, double t1,
+    const std::vector<double>& arrivalTimes, double mu, int maxRevolutions,
+    float* c3, float* vInfArrival)
+{
+    const double r1n = glm::length(r1);
+    const double ir1x = r1.x / r1n, ir1y = r1.y / r1n, ir1z = r1.z / r1n;
+
+    // pass 1: transfer geometry for the whole row (branch-free so it vectorizes)
+    for (size_t j = 0; j < count; ++j)
+    {
+        double cx = r2x[j] - r1.x, cy = r2y[j] - r1.y, cz = r2z[j] - r1.z;
+        double cn = std::sqrt(cx * cx + cy * cy + cz * cz);
+        double sj = (r1n + r2n[j] + cn) * 0.5;
+        double ir2x = r2x[j] / r2n[j], ir2y = r2y[j] / r2n[j], ir2z = r2z[j] / r2n[j];
+        double hx = ir1y * ir2z - ir1z * ir2y;
+        double hy = ir1z * ir2x - ir1x * ir2z;
+        double hz = ir1x * ir2y - ir1y * ir2x;
+        double hn = std::sqrt(hx * hx + hy * hy + hz * hz);
+        double hinv = hn > 1e-12 ? 1.0 / hn : 0.0;
+        // flipping the angular momentum for retrograde-looking geometry keeps the transfer prograde
+        double sign = hz < 0.0 ? -1.0 : 1.0;
+        hx *= hinv * sign; hy *= hinv * sign; hz *= hinv * sign;
+
+        lambda[j] = sign * std::sqrt(1.0 - std::min(1.0, cn / sj));
+        it1x[j] = hy * ir1z - hz * ir1y;
+        it1y[j] = hz * ir1x - hx * ir1z;
+        it1z[j] = hx * ir1y - hy * ir1x;
+        it2x[j] = hy * ir2z - hz * ir2y;
+        it2y[j] = hz * ir2x - hx * ir2z;
+        it2z[j] = hx * ir2y - hy * ir2x;
+
+        double tof = arrivalTimes[j] - t1;
+        s[j] = sj;
+        cNorm[j] = cn;
+        T[j] = tof > 0.0 && hinv > 0.0 ? std::sqrt(2.0 * mu / (sj * sj * sj)) * tof : -1.0;
+        bestCost[j] = std::numeric_limits<double>::infinity();
+    }
+
+    // pass 2: root finding per cell, keeping the cheapest branch
+    for (size_t j = 0; j < count; ++j)
+    {
+        if (T[j] <= 0.0)
+            continue;
+        LambertGeometry g;
+        g.lambda = lambda[j];
+        g.T = T[j];
+        g.s = s[j];
+        g.cNorm = cNorm[j];
+        g.it1 = glm::dvec3(it1x[j], it1y[j], it1z[j]);
+        g.it2 = glm::dvec3(it2x[j], it2y[j], it2z[j]);
+        glm::dvec3 r2(r2x[j], r2y[j], r2z[j]);
+        glm::dvec3 v2Body(v2x[j], v2y[j], v2z[j]);
+
+        int Mmax = maxFeasibleRevolutions(g.T, g.lambda, maxRevolutions);
+        for (int M = 0; M <= Mmax; ++M)
+        {
+            for (int branch = 0; branch < (M == 0 ? 1 : 2); ++branch)
+            {
+                double x = initialGuess(g.T, g.lambda, M, branch == 0);
+                if (!householder(x, g.T, g.lambda, M))
+                    continue;
+                glm::dvec3 v1, v2;
+                reconstruct(x, g, r1, r1n, r2, r2n[j], mu, v1, v2);
+                glm::dvec3 dv1 = v1 - v1Body;
+                glm::dvec3 dv2 = v2 - v2Body;
+                double departureC3 = glm::dot(dv1, dv1);
+                double arrivalVinf = glm::length(dv2);
+                double cost = std::sqrt(departureC3) + arrivalVinf;
+                if (cost < bestCost[j])
+                {
+                    bestCost[j] = cost;
+                    bestC3[j] = departureC3;
+                    bestVinf[j] = arrivalVinf;
+                }
+            }
+        }
+    }
+
+    // pass 3: write out
+    for (size_t j = 0; j < count; ++j)
+    {
+        bool valid = std::isfinite(bestCost[j]);
+        c3[j] = valid ? static_cast<float>(bestC3[j]) : -1.0f;
+        vInfArrival[j] = valid ? static_cast<float>(bestVinf[j]) : -1.0f;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "glm.hpp"
+#include <vector>
+
+// Lambert's problem: find the conic connecting r1 and r2 in a given time of flight.
+// Solved with Izzo's formulation (Householder iterations on the x variable), which
+// handles single and multi-revolution transfers with the same code path.
+
+struct LambertSolution
+{
+    glm::dvec3 v1;
+    glm::dvec3 v2;
+    int revolutions;
+    bool lowPath;
+};
+
+// Solves for every feasible branch up to maxRevolutions and appends them to solutions.
+// Returns the number of solutions found (0 for degenerate geometry, e.g. a 180 degree transfer).
+int solveLambert(const glm::dvec3& r1, const glm::dvec3& r2, double timeOfFlight, double mu,
+    int maxRevolutions, bool prograde, std::vector<LambertSolution>& solutions);
+
+// Batched solver for one row of a transfer grid: a single departure point against many
+// arrival points. The geometry pass runs over structure-of-arrays buffers so it
+// vectorizes; the root finding and velocity reconstruction are per element.
+class LambertBatch
+{
+public:
+    // arrival states are shared by every row, so they are set once per grid
+    void setArrivals(const std::vector<glm::dvec3>& positions, const std::vector<glm::dvec3>& velocities);
+
+    // Evaluates departure (r1, v1Body) at time t1 against every arrival at arrivalTimes[j].
+    // Writes the departure C3 and arrival v-infinity (in the units of mu) of the cheapest
+    // branch to c3 / vInfArrival; infeasible cells are set to a negative value.
+    void solveRow(const glm::dvec3& r1, const glm::dvec3& v1Body, double t1,
+        const std::vector<double>& arrivalTimes, double mu, int maxRevolutions,
+        float* c3, float* vInfArrival);
+
+private:
+    size_t count = 0;
+    // arrival states (SoA)
+    std::vector<double> r2x, r2y, r2z;
+    std::vector<double> v2x, v2y, v2z;
+    std::vector<double> r2n;
+
+    // per-row scratch (SoA)
+    std::vector<double> lambda, T, s, cNorm;
+    std::vector<double> it1x, it1y, it1z, it2x, it2y, it2z;
+    std::vector<double> bestCost, bestC3, bestVinf;
+};
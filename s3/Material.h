@@ -0,0 +1,95 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "glad.h" // holds all OpenGL type declarations
+
+#include "Shader.h"
+
+#include <string>
+#include <vector>
+
+// The textures a mesh draws with, each given a texture unit and its sampler name once, when the
+// model loads. The shader convention is unchanged: the Nth texture of a type goes to the
+// sampler 'texture_diffuseN', 'texture_specularN', 'texture_normalN' or 'texture_heightN'.
+//
+// Sampler and per-mesh uniform locations are looked up the first time a material is bound
+// with a program and kept until it is bound with another one, so drawing is a unit switch
+// and a bind per texture plus one glUniform1i each, with no strings involved.
+class Material
+{
+public:
+    struct Binding
+    {
+        unsigned int unit;
+        unsigned int texture;
+        std::string sampler;    // e.g. texture_diffuse1
+    };
+
+    // uniform locations of the program the material was last bound with
+    struct ProgramLocations
+    {
+        unsigned int program = 0;
+        std::vector<int> samplers;
+        int positionOffset = -1;
+        int positionScale = -1;
+    };
+
+    // textures as the importer returns them: (GL id, type) in unit order
+    Material(const std::vector<unsigned int>& textureIds, const std::vector<std::string>& types)
+    {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr = 1;
+        unsigned int heightNr = 1;
+        for (size_t i = 0; i < textureIds.size(); i++)
+        {
+            // retrieve texture number (the N in diffuse_textureN)
+            std::string number;
+            const std::string& name = types[i];
+            if (name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if (name == "texture_specular")
+                number = std::to_string(specularNr++);
+            else if (name == "texture_normal")
+                number = std::to_string(normalNr++);
+            else if (name == "texture_height")
+                number = std::to_string(heightNr++);
+
+            Binding binding;
+            binding.unit = static_cast<unsigned int>(i);
+            binding.texture = textureIds[i];
+            binding.sampler = name + number;
+            bindings.push_back(binding);
+        }
+    }
+
+    // binds the textures and points the program's samplers at them; the shader must be in use
+    const ProgramLocations& bind(const Shader& shader) const
+    {
+        if (locations.program != shader.ID)
+            resolve(shader);
+        for (size_t i = 0; i < bindings.size(); i++)
+        {
+            GLState::get().bindTexture(bindings[i].unit, GL_TEXTURE_2D, bindings[i].texture);
+            glUniform1i(locations.samplers[i], static_cast<GLint>(bindings[i].unit));
+        }
+        return locations;
+    }
+
+    const std::vector<Binding>& getBindings() const { return bindings; }
+
+private:
+    void resolve(const Shader& shader) const
+    {
+        locations.program = shader.ID;
+        locations.samplers.clear();
+        for (const Binding& binding : bindings)
+            locations.samplers.push_back(shader.location(binding.sampler));
+        locations.positionOffset = shader.location("positionOffset");
+        locations.positionScale = shader.location("positionScale");
+    }
+
+    std::vector<Binding> bindings;
+    mutable ProgramLocations locations;
+};
+#endif
@@ -5,9 +5,14 @@
 
 #include "glm.hpp"
 #include <gtc/matrix_transform.hpp>
+#include <gtc/packing.hpp>
 
 #include "Shader.h"
+#include "Material.h"
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 using namespace std;
@@ -31,6 +36,134 @@ struct Vertex {
     float m_Weights[MAX_BONE_INFLUENCE];
 };
 
+// How a mesh's vertices are stored on the GPU, chosen per mesh at import time. Vertex above is
+// the import format (88 bytes); the full layout uploads it as is, the compact one packs:
+//  - positions as unsigned 16-bit fractions of the mesh bounds (8 bytes); the vertex shader
+//    maps them back with positionOffset + aPos * positionScale, which Draw sets
+//  - normal and tangent as signed 10_10_10_2 (4 bytes each); the tangent's w holds the
+//    handedness, bitangent = cross(normal, tangent.xyz) * tangent.w, so location 4 is unused
+//  - texture coordinates as half floats (4 bytes)
+// Tangents are only kept for meshes with normal maps and bone data goes in a second stream of
+// 8 bytes only for skinned meshes, so a static textured mesh is 16 bytes a vertex.
+struct VertexLayout {
+    bool quantizedPositions;
+    bool packedNormals;
+    bool halfTexCoords;
+    bool tangents;
+    bool skinning;
+
+    static VertexLayout full() { return VertexLayout{ false, false, false, true, true }; }
+    static VertexLayout compact() { return VertexLayout{ true, true, true, true, false }; }
+
+    unsigned int bits() const
+    {
+        return (quantizedPositions ? 1u : 0u) | (packedNormals ? 2u : 0u) | (halfTexCoords ? 4u : 0u) | (tangents ? 8u : 0u) | (skinning ? 16u : 0u);
+    }
+    static VertexLayout fromBits(unsigned int bits)
+    {
+        return VertexLayout{ (bits & 1u) != 0, (bits & 2u) != 0, (bits & 4u) != 0, (bits & 8u) != 0, (bits & 16u) != 0 };
+    }
+
+    size_t positionBytes() const { return quantizedPositions ? 4 * sizeof(uint16_t) : 3 * sizeof(float); }
+    size_t normalBytes() const { return packedNormals ? sizeof(uint32_t) : 3 * sizeof(float); }
+    size_t texCoordBytes() const { return halfTexCoords ? 2 * sizeof(uint16_t) : 2 * sizeof(float); }
+    // tangent, plus the bitangent when the normals aren't packed
+    size_t tangentBytes() const { return !tangents ? 0 : packedNormals ? sizeof(uint32_t) : 6 * sizeof(float); }
+    size_t stride() const { return positionBytes() + normalBytes() + texCoordBytes() + tangentBytes(); }
+    // the full layout keeps the import format's ints and floats
+    size_t skinStride() const { return !skinning ? 0 : packedNormals ? 8 : MAX_BONE_INFLUENCE * (sizeof(int) + sizeof(float)); }
+};
+
+// packs vertices into the layout's main and skinning streams; positions are stored relative
+// to boundsMin and boundsExtent (see computeBounds) when quantized
+inline void packVertices(const VertexLayout& layout, const Vertex* vertices, size_t count,
+    const glm::vec3& boundsMin, const glm::vec3& boundsExtent, vector<unsigned char>& stream, vector<unsigned char>& skin)
+{
+    const size_t stride = layout.stride(), skinStride = layout.skinStride();
+    stream.assign(count * stride, 0);
+    skin.assign(count * skinStride, 0);
+    const glm::vec3 inverseExtent = glm::vec3(
+        boundsExtent.x > 0.0f ? 1.0f / boundsExtent.x : 0.0f,
+        boundsExtent.y > 0.0f ? 1.0f / boundsExtent.y : 0.0f,
+        boundsExtent.z > 0.0f ? 1.0f / boundsExtent.z : 0.0f);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Vertex& vertex = vertices[i];
+        unsigned char* out = &stream[i * stride];
+        if (layout.quantizedPositions)
+        {
+            glm::vec3 unit = glm::clamp((vertex.Position - boundsMin) * inverseExtent, 0.0f, 1.0f);
+            uint16_t position[4] = { uint16_t(unit.x * 65535.0f + 0.5f), uint16_t(unit.y * 65535.0f + 0.5f), uint16_t(unit.z * 65535.0f + 0.5f), 0 };
+            std::memcpy(out, position, sizeof(position));
+        }
+        else
+            std::memcpy(out, &vertex.Position, sizeof(glm::vec3));
+        out += layout.positionBytes();
+
+        if (layout.packedNormals)
+        {
+            uint32_t normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f));
+            std::memcpy(out, &normal, sizeof(normal));
+        }
+        else
+            std::memcpy(out, &vertex.Normal, sizeof(glm::vec3));
+        out += layout.normalBytes();
+
+        if (layout.halfTexCoords)
+        {
+            uint16_t texCoords[2] = { glm::packHalf1x16(vertex.TexCoords.x), glm::packHalf1x16(vertex.TexCoords.y) };
+            std::memcpy(out, texCoords, sizeof(texCoords));
+        }
+        else
+            std::memcpy(out, &vertex.TexCoords, sizeof(glm::vec2));
+        out += layout.texCoordBytes();
+
+        if (layout.tangents && layout.packedNormals)
+        {
+            float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+            uint32_t tangent = glm::packSnorm3x10_1x2(glm::vec4(vertex.Tangent, handedness));
+            std::memcpy(out, &tangent, sizeof(tangent));
+        }
+        else if (layout.tangents)
+        {
+            std::memcpy(out, &vertex.Tangent, sizeof(glm::vec3));
+            std::memcpy(out + sizeof(glm::vec3), &vertex.Bitangent, sizeof(glm::vec3));
+        }
+
+        if (layout.skinning)
+        {
+            unsigned char* bones = &skin[i * skinStride];
+            if (layout.packedNormals)
+            {
+                // up to 256 bones, weights in 1/255 steps
+                for (int b = 0; b < MAX_BONE_INFLUENCE; ++b)
+                {
+                    bones[b] = (unsigned char)glm::clamp(vertex.m_BoneIDs[b], 0, 255);
+                    bones[MAX_BONE_INFLUENCE + b] = (unsigned char)(glm::clamp(vertex.m_Weights[b], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+            else
+            {
+                std::memcpy(bones, vertex.m_BoneIDs, sizeof(vertex.m_BoneIDs));
+                std::memcpy(bones + sizeof(vertex.m_BoneIDs), vertex.m_Weights, sizeof(vertex.m_Weights));
+            }
+        }
+    }
+}
+
+inline void computeBounds(const Vertex* vertices, size_t count, glm::vec3& boundsMin, glm::vec3& boundsExtent)
+{
+    glm::vec3 low(count > 0 ? vertices[0].Position : glm::vec3(0.0f)), high(low);
+    for (size_t i = 1; i < count; ++i)
+    {
+        low = glm::min(low, vertices[i].Position);
+        high = glm::max(high, vertices[i].Position);
+    }
+    boundsMin = low;
+    boundsExtent = high - low;
+}
+
 struct Texture {
     unsigned int id;
     string type;
@@ -43,104 +176,160 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
+    std::shared_ptr<const Material> material;   // the textures' units and samplers, shared between meshes
     unsigned int VAO;
+    size_t indexCount;
+    size_t vertexCount;
+    VertexLayout layout;
+    glm::vec3 boundsMin, boundsExtent;   // the quantized positions' range
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor, packs the vertices into the given layout; without a material one is made
+    // from the textures
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexLayout layout = VertexLayout::full(),
+        std::shared_ptr<const Material> material = nullptr)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->layout = layout;
+        this->material = material ? material : makeMaterial(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        computeBounds(this->vertices.data(), this->vertices.size(), boundsMin, boundsExtent);
+        vector<unsigned char> stream, skin;
+        packVertices(layout, this->vertices.data(), this->vertices.size(), boundsMin, boundsExtent, stream, skin);
+        setupMesh(stream.data(), skin.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+    }
+
+    // constructor for cooked meshes (MeshCache): the streams are already packed and upload
+    // straight from the mapped file; no CPU copy is kept, so vertices and indices stay empty
+    Mesh(const VertexLayout& layout, const glm::vec3& boundsMin, const glm::vec3& boundsExtent,
+        const unsigned char* stream, const unsigned char* skin, size_t vertexCount,
+        const unsigned int* indexData, size_t indexCount, vector<Texture> textures, std::shared_ptr<const Material> material = nullptr)
+    {
+        this->textures = textures;
+        this->material = material ? material : makeMaterial(textures);
+        this->layout = layout;
+        this->boundsMin = boundsMin;
+        this->boundsExtent = boundsExtent;
+        setupMesh(stream, skin, vertexCount, indexData, indexCount);
+    }
+
+    // bytes of vertex data on the GPU
+    size_t vertexBytes() const { return vertexCount * (layout.stride() + layout.skinStride()); }
+
+    static std::shared_ptr<const Material> makeMaterial(const vector<Texture>& textures)
+    {
+        vector<unsigned int> ids;
+        vector<string> types;
+        for (const Texture& texture : textures)
+        {
+            ids.push_back(texture.id);
+            types.push_back(texture.type);
+        }
+        return std::make_shared<const Material>(ids, types);
     }
 
     // render the mesh
     void Draw(Shader& shader)
     {
         // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        unsigned int heightNr = 1;
-        for (unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if (name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if (name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if (name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-            else if (name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+        const Material::ProgramLocations& locations = material->bind(shader);
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // quantized positions come back to model space in the vertex shader
+        const glm::vec3 offset = layout.quantizedPositions ? boundsMin : glm::vec3(0.0f);
+        const glm::vec3 scale = layout.quantizedPositions ? boundsExtent : glm::vec3(1.0f);
+        glUniform3fv(locations.positionOffset, 1, &offset[0]);
+        glUniform3fv(locations.positionScale, 1, &scale[0]);
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        // draw mesh
+        GLState::get().bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
     }
 
 private:
     // render data 
-    unsigned int VBO, EBO;
+    unsigned int VBO, EBO, skinVBO;
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const unsigned char* stream, const unsigned char* skin, size_t count, const unsigned int* indexData, size_t indices)
     {
+        vertexCount = count;
+        indexCount = indices;
+        skinVBO = 0;
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * layout.stride(), stream, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
 
-        // set the vertex attribute pointers
+        // set the vertex attribute pointers, in stream order
+        const GLsizei stride = static_cast<GLsizei>(layout.stride());
+        size_t offset = 0;
         // vertex Positions
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        if (layout.quantizedPositions)
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offset);
+        else
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        offset += layout.positionBytes();
         // vertex normals
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        if (layout.packedNormals)
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offset);
+        else
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        offset += layout.normalBytes();
         // vertex texture coords
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-        // ids
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-        // weights
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        if (layout.halfTexCoords)
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offset);
+        else
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        offset += layout.texCoordBytes();
+        // vertex tangent (w = handedness when packed) and bitangent
+        if (layout.tangents)
+        {
+            glEnableVertexAttribArray(3);
+            if (layout.packedNormals)
+                glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offset);
+            else
+            {
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+                glEnableVertexAttribArray(4);
+                glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + sizeof(glm::vec3)));
+            }
+        }
+
+        // ids and weights, in their own stream
+        if (layout.skinning)
+        {
+            const GLsizei skinStride = static_cast<GLsizei>(layout.skinStride());
+            glGenBuffers(1, &skinVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, skinVBO);
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * skinStride, skin, GL_STATIC_DRAW);
+            glEnableVertexAttribArray(5);
+            glEnableVertexAttribArray(6);
+            if (layout.packedNormals)
+            {
+                glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, skinStride, (void*)0);
+                glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, skinStride, (void*)(size_t)MAX_BONE_INFLUENCE);
+            }
+            else
+            {
+                glVertexAttribIPointer(5, 4, GL_INT, skinStride, (void*)0);
+                glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, skinStride, (void*)(MAX_BONE_INFLUENCE * sizeof(int)));
+            }
+        }
+        GLState::get().bindVertexArray(0);
     }
 };
 #endif
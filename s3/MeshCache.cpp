@@ -0,0 +1,365 @@
+#include "MeshCache.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char CACHE_MAGIC[4] = { 'S', '3', 'M', 'S' };
+    const uint32_t CACHE_VERSION = 2;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t reserved;
+        uint32_t meshCount;
+        uint32_t textureCount;
+        uint32_t stringBytes;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t sourceHash;
+    };
+
+    bool sourceInfo(const std::string& path, uint64_t& size, int64_t& time)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        size = uint64_t(info.st_size);
+        time = int64_t(info.st_mtime);
+        return true;
+    }
+
+    // FNV-1a over the whole file
+    uint64_t hashFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        uint64_t hash = 14695981039346656037ull;
+        std::vector<char> buffer(1 << 16);
+        while (file)
+        {
+            file.read(buffer.data(), std::streamsize(buffer.size()));
+            for (std::streamsize i = 0; i < file.gcount(); ++i)
+            {
+                hash ^= uint64_t((unsigned char)buffer[size_t(i)]);
+                hash *= 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    size_t align(size_t offset, size_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+}
+
+MappedFile::MappedFile() : bytes(NULL), length(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE), mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping)
+        bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes)
+    {
+        close();
+        return false;
+    }
+    length = size_t(fileSize.QuadPart);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    void* view = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // the mapping keeps its own reference to the file
+    ::close(descriptor);
+    if (view == MAP_FAILED)
+        return false;
+    bytes = static_cast<const unsigned char*>(view);
+    length = size_t(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    mapping = NULL;
+#else
+    if (bytes)
+        munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+    bytes = NULL;
+    length = 0;
+}
+
+bool MeshCache::open(const std::string& cachePath, const std::string& sourcePath)
+{
+    meshes.clear();
+    if (!file.open(cachePath))
+        return false;
+
+    CacheHeader header;
+    if (file.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION)
+    {
+        file.close();
+        return false;
+    }
+
+    // stale? the timestamp is the quick check, the content hash the real one
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (sourceInfo(sourcePath, sourceSize, sourceTime))
+    {
+        if (sourceSize != header.sourceSize)
+        {
+            file.close();
+            return false;
+        }
+        if (sourceTime != header.sourceTime)
+        {
+            if (hashFile(sourcePath) != header.sourceHash)
+            {
+                file.close();
+                return false;
+            }
+            file.close();
+            header.sourceTime = sourceTime;
+            std::fstream patch(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+            patch.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            patch.close();
+            if (!file.open(cachePath))
+                return false;
+        }
+    }
+
+    // tables follow the header; every offset is checked against the mapping
+    size_t offset = sizeof(header);
+    const size_t tableBytes = header.meshCount * sizeof(MeshRecord) + header.textureCount * sizeof(TextureRecord) + header.stringBytes;
+    if (file.size() < offset + tableBytes)
+    {
+        file.close();
+        return false;
+    }
+    meshes.resize(header.meshCount);
+    if (header.meshCount > 0)
+        std::memcpy(meshes.data(), file.data() + offset, header.meshCount * sizeof(MeshRecord));
+    offset += header.meshCount * sizeof(MeshRecord);
+    textureRecords = reinterpret_cast<const TextureRecord*>(file.data() + offset);
+    offset += header.textureCount * sizeof(TextureRecord);
+    strings = reinterpret_cast<const char*>(file.data() + offset);
+
+    for (const MeshRecord& mesh : meshes)
+    {
+        const VertexLayout layout = VertexLayout::fromBits(mesh.layoutBits);
+        const bool inside = mesh.stride == layout.stride()
+            && mesh.vertexOffset % 4 == 0 && mesh.skinOffset % 4 == 0 && mesh.indexOffset % 4 == 0
+            && mesh.vertexOffset + mesh.vertexCount * layout.stride() <= file.size()
+            && mesh.skinOffset + mesh.vertexCount * layout.skinStride() <= file.size()
+            && mesh.indexOffset + mesh.indexCount * sizeof(unsigned int) <= file.size()
+            && uint64_t(mesh.firstTexture) + mesh.textureCount <= header.textureCount;
+        if (!inside)
+        {
+            std::cout << "ERROR::MESH_CACHE::CORRUPT " << cachePath << std::endl;
+            meshes.clear();
+            file.close();
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.textureCount; ++i)
+    {
+        const TextureRecord& record = textureRecords[i];
+        if (uint64_t(record.typeOffset) + record.typeLength > header.stringBytes || uint64_t(record.pathOffset) + record.pathLength > header.stringBytes)
+        {
+            std::cout << "ERROR::MESH_CACHE::CORRUPT " << cachePath << std::endl;
+            meshes.clear();
+            file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+const unsigned char* MeshCache::vertexStream(size_t mesh) const
+{
+    return file.data() + meshes[mesh].vertexOffset;
+}
+
+const unsigned char* MeshCache::skinStream(size_t mesh) const
+{
+    return layout(mesh).skinning ? file.data() + meshes[mesh].skinOffset : NULL;
+}
+
+const unsigned int* MeshCache::indices(size_t mesh) const
+{
+    return reinterpret_cast<const unsigned int*>(file.data() + meshes[mesh].indexOffset);
+}
+
+std::vector<std::pair<std::string, std::string>> MeshCache::textures(size_t mesh) const
+{
+    std::vector<std::pair<std::string, std::string>> result;
+    for (uint32_t i = 0; i < meshes[mesh].textureCount; ++i)
+    {
+        const TextureRecord& record = textureRecords[meshes[mesh].firstTexture + i];
+        result.push_back(std::make_pair(std::string(strings + record.typeOffset, record.typeLength),
+            std::string(strings + record.pathOffset, record.pathLength)));
+    }
+    return result;
+}
+
+bool MeshCache::write(const std::string& cachePath, const std::string& sourcePath, const std::vector<Mesh>& sourceMeshes)
+{
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    header.reserved = 0;
+    header.meshCount = uint32_t(sourceMeshes.size());
+    if (!sourceInfo(sourcePath, header.sourceSize, header.sourceTime))
+        return false;
+    header.sourceHash = hashFile(sourcePath);
+
+    std::vector<MeshRecord> meshRecords;
+    std::vector<TextureRecord> textureRecords;
+    std::string stringData;
+    // the meshes keep their import vertices, so the streams are packed again here
+    std::vector<std::vector<unsigned char>> streams(sourceMeshes.size()), skins(sourceMeshes.size());
+    for (size_t i = 0; i < sourceMeshes.size(); ++i)
+    {
+        const Mesh& mesh = sourceMeshes[i];
+        packVertices(mesh.layout, mesh.vertices.data(), mesh.vertices.size(), mesh.boundsMin, mesh.boundsExtent, streams[i], skins[i]);
+        MeshRecord record = {};
+        record.layoutBits = mesh.layout.bits();
+        record.stride = uint32_t(mesh.layout.stride());
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            record.boundsMin[axis] = mesh.boundsMin[axis];
+            record.boundsExtent[axis] = mesh.boundsExtent[axis];
+        }
+        record.firstTexture = uint32_t(textureRecords.size());
+        record.textureCount = uint32_t(mesh.textures.size());
+        record.vertexCount = mesh.vertices.size();
+        record.indexCount = mesh.indices.size();
+        for (const Texture& texture : mesh.textures)
+        {
+            TextureRecord textureRecord;
+            textureRecord.typeOffset = uint32_t(stringData.size());
+            textureRecord.typeLength = uint32_t(texture.type.size());
+            stringData += texture.type;
+            textureRecord.pathOffset = uint32_t(stringData.size());
+            textureRecord.pathLength = uint32_t(texture.path.size());
+            stringData += texture.path;
+            textureRecords.push_back(textureRecord);
+        }
+        meshRecords.push_back(record);
+    }
+    header.textureCount = uint32_t(textureRecords.size());
+    header.stringBytes = uint32_t(stringData.size());
+
+    // vertex and index streams start 16-byte aligned, in mesh order
+    size_t offset = align(sizeof(header) + meshRecords.size() * sizeof(MeshRecord)
+        + textureRecords.size() * sizeof(TextureRecord) + stringData.size(), 16);
+    for (size_t i = 0; i < sourceMeshes.size(); ++i)
+    {
+        meshRecords[i].vertexOffset = offset;
+        offset = align(offset + streams[i].size(), 16);
+        meshRecords[i].skinOffset = offset;
+        offset = align(offset + skins[i].size(), 16);
+        meshRecords[i].indexOffset = offset;
+        offset = align(offset + sourceMeshes[i].indices.size() * sizeof(unsigned int), 16);
+    }
+
+    // written under a temporary name, so a crash never leaves a truncated cache behind
+    const std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary);
+        if (!out)
+            return false;
+        auto pad = [&out]() {
+            while (size_t(out.tellp()) % 16 != 0)
+                out.put(0);
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!meshRecords.empty())
+            out.write(reinterpret_cast<const char*>(meshRecords.data()), std::streamsize(meshRecords.size() * sizeof(MeshRecord)));
+        if (!textureRecords.empty())
+            out.write(reinterpret_cast<const char*>(textureRecords.data()), std::streamsize(textureRecords.size() * sizeof(TextureRecord)));
+        out.write(stringData.data(), std::streamsize(stringData.size()));
+        pad();
+        for (size_t i = 0; i < sourceMeshes.size(); ++i)
+        {
+            const Mesh& mesh = sourceMeshes[i];
+            out.write(reinterpret_cast<const char*>(streams[i].data()), std::streamsize(streams[i].size()));
+            pad();
+            out.write(reinterpret_cast<const char*>(skins[i].data()), std::streamsize(skins[i].size()));
+            pad();
+            if (!mesh.indices.empty())
+                out.write(reinterpret_cast<const char*>(mesh.indices.data()), std::streamsize(mesh.indices.size() * sizeof(unsigned int)));
+            pad();
+        }
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE::WRITE_FAILED " << cachePath << std::endl;
+            return false;
+        }
+    }
+    std::remove(cachePath.c_str());
+    if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cout << "ERROR::MESH_CACHE::WRITE_FAILED " << cachePath << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Read-only view of a whole file, mapped into the address space instead of read.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
+
+// Cooked meshes of an imported model (<model>.s3mesh next to the source): the final vertex
+// streams, packed in each mesh's VertexLayout, and indices exactly as Mesh uploads them, plus
+// each mesh's texture
+// references, so a warm load is a file mapping and one buffer upload per mesh instead of an
+// Assimp import with triangulation, normal and tangent generation.
+//
+// The cache records the source's size, modification time and a 64-bit content hash. A size
+// or hash mismatch rejects it; a newer timestamp with the same content (a fresh checkout)
+// only refreshes the stored time. A new format version invalidates every cache.
+class MeshCache
+{
+public:
+    // maps and validates the cache against the source; the data stays mapped until close()
+    bool open(const std::string& cachePath, const std::string& sourcePath);
+    void close() { file.close(); }
+
+    size_t meshCount() const { return meshes.size(); }
+    VertexLayout layout(size_t mesh) const { return VertexLayout::fromBits(meshes[mesh].layoutBits); }
+    glm::vec3 boundsMin(size_t mesh) const { return glm::vec3(meshes[mesh].boundsMin[0], meshes[mesh].boundsMin[1], meshes[mesh].boundsMin[2]); }
+    glm::vec3 boundsExtent(size_t mesh) const { return glm::vec3(meshes[mesh].boundsExtent[0], meshes[mesh].boundsExtent[1], meshes[mesh].boundsExtent[2]); }
+    // packed main stream, and the skinning stream (NULL unless the layout has skinning)
+    const unsigned char* vertexStream(size_t mesh) const;
+    const unsigned char* skinStream(size_t mesh) const;
+    size_t vertexCount(size_t mesh) const { return size_t(meshes[mesh].vertexCount); }
+    const unsigned int* indices(size_t mesh) const;
+    size_t indexCount(size_t mesh) const { return size_t(meshes[mesh].indexCount); }
+    // (type, path) as Texture holds them, the path relative to the model's directory
+    std::vector<std::pair<std::string, std::string>> textures(size_t mesh) const;
+
+    static bool write(const std::string& cachePath, const std::string& sourcePath, const std::vector<Mesh>& meshes);
+
+private:
+    struct MeshRecord
+    {
+        uint64_t vertexOffset, skinOffset, vertexCount, indexOffset, indexCount;
+        uint32_t firstTexture, textureCount;
+        uint32_t layoutBits, stride;
+        float boundsMin[3], boundsExtent[3];
+    };
+    struct TextureRecord
+    {
+        uint32_t typeOffset, typeLength, pathOffset, pathLength;
+    };
+
+    MappedFile file;
+    std::vector<MeshRecord> meshes;
+    const TextureRecord* textureRecords = NULL;
+    const char* strings = NULL;
+};
@@ -14,7 +14,11 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "TextureRegistry.h"
+#include "MeshCache.h"
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -23,21 +27,27 @@
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
-
 class Model
 {
 public:
     // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<TextureRegistry::Handle> textureHandles;	// keeps the model's textures alive in the registry
     vector<Mesh>    meshes;
+    vector<std::shared_ptr<const Material>> materials;	// one per distinct texture set, shared by its meshes
     string directory;
     bool gammaCorrection;
+    TextureRegistry& textureRegistry;
+    // how the last load went: from the cooked cache or through Assimp, and how long it took
+    bool loadedFromCache;
+    double loadMs;
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    // constructor, expects a filepath to a 3D model; textures are shared through the registry.
+    Model(string const& path, TextureRegistry& registry, bool gamma = false) : gammaCorrection(gamma), textureRegistry(registry),
+        loadedFromCache(false), loadMs(0.0)
     {
+        auto start = std::chrono::high_resolution_clock::now();
         loadModel(path);
+        loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
     }
 
     // draws the model, and thus all its meshes
@@ -49,8 +59,28 @@ public:
 
 private:
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    // the processed meshes are cooked into <path>.s3mesh; later runs map that instead of importing again.
     void loadModel(string const& path)
     {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+        const string cachePath = path + ".s3mesh";
+
+        MeshCache cache;
+        if (cache.open(cachePath, path))
+        {
+            for (size_t i = 0; i < cache.meshCount(); i++)
+            {
+                vector<Texture> textures;
+                for (const auto& reference : cache.textures(i))
+                    textures.push_back(acquireTexture(reference.second, reference.first));
+                meshes.push_back(Mesh(cache.layout(i), cache.boundsMin(i), cache.boundsExtent(i), cache.vertexStream(i), cache.skinStream(i),
+                    cache.vertexCount(i), cache.indices(i), cache.indexCount(i), textures, materialFor(textures)));
+            }
+            loadedFromCache = true;
+            return;
+        }
+
         // read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -60,11 +90,10 @@ private:
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        MeshCache::write(cachePath, path, meshes);
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -96,7 +125,7 @@ private:
         // walk through each of the mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = {};
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -166,11 +195,18 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
+        // pick the smallest layout that keeps what the mesh uses: tangents only for normal
+        // mapping, the skinning stream only with bones (the importer doesn't extract bone
+        // weights yet, so they'd all be zero)
+        VertexLayout layout = VertexLayout::compact();
+        layout.tangents = mesh->HasTangentsAndBitangents() && !normalMaps.empty();
+        layout.skinning = mesh->HasBones();
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(vertices, indices, textures, layout, materialFor(textures));
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
+    // looks up all material textures of a given type in the registry, which loads each file once.
     // the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
     {
@@ -179,70 +215,42 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if (!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(acquireTexture(str.C_Str(), typeName));
         }
         return textures;
     }
-};
-
-
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    // the model's material for a set of textures, created the first time the set is seen; meshes
+    // of the same Assimp material end up with the same textures
+    std::shared_ptr<const Material> materialFor(const vector<Texture>& textures)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        for (const auto& material : materials)
+        {
+            const vector<Material::Binding>& bindings = material->getBindings();
+            bool same = bindings.size() == textures.size();
+            for (size_t i = 0; same && i < textures.size(); i++)
+                same = bindings[i].texture == textures[i].id && bindings[i].sampler.compare(0, textures[i].type.size(), textures[i].type) == 0;
+            if (same)
+                return material;
+        }
+        materials.push_back(Mesh::makeMaterial(textures));
+        return materials.back();
     }
-    else
+
+    // a texture relative to the model's directory, kept alive for as long as the model
+    Texture acquireTexture(const string& path, const string& typeName)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        TextureRegistry::Handle handle = textureRegistry.acquire(this->directory + '/' + path,
+            glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), typeName == "texture_diffuse");
+        if (std::find(textureHandles.begin(), textureHandles.end(), handle) == textureHandles.end())
+            textureHandles.push_back(handle);
+        Texture texture;
+        texture.id = handle->id;
+        texture.type = typeName;
+        texture.path = path;
+        return texture;
     }
+};
 
-    return textureID;
-}
 #endif
 
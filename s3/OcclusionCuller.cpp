@@ -0,0 +1,203 @@
+#include "OcclusionCuller.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+
+OcclusionCuller::OcclusionCuller() :
+    enabled(true), maxQueriesPerFrame(2048), frame(MAX_ANSWER_AGE + 1), shader(NULL), eye(0.0f), margin(0.0f),
+    conditionalActive(false), VAO(0), VBO(0), EBO(0), queriesIssued(0), occluded(0)
+{
+    polygonMode = GL_FILL;
+    cullFace = true;
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    reset();
+    if (VAO != 0)
+    {
+        GLState::get().deleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+}
+
+void OcclusionCuller::resize(size_t count)
+{
+    Slot empty = { 0, false, true, false, 0, 0 };
+    slots.resize(count, empty);
+}
+
+void OcclusionCuller::reset()
+{
+    for (Slot& slot : slots)
+        if (slot.query != 0)
+            glDeleteQueries(1, &slot.query);
+    slots.clear();
+    pendingIds.clear();
+    queriedIds.clear();
+    occluded = 0;
+}
+
+void OcclusionCuller::collect()
+{
+    ++frame;
+
+    // only results that are already there; the rest are picked up next frame
+    size_t kept = 0;
+    for (size_t id : pendingIds)
+    {
+        if (id >= slots.size())
+            continue;
+        Slot& slot = slots[id];
+        GLuint available = 0;
+        glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            pendingIds[kept++] = id;
+            continue;
+        }
+        GLuint samples = 0;
+        glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT, &samples);
+        slot.visible = samples != 0;
+        slot.answered = slot.issued;
+        slot.pending = false;
+    }
+    pendingIds.resize(kept);
+
+    occluded = 0;
+    for (size_t id : queriedIds)
+        if (!isVisible(id))
+            ++occluded;
+    queriedIds.clear();
+}
+
+bool OcclusionCuller::isVisible(size_t id) const
+{
+    if (!enabled || id >= slots.size())
+        return true;
+    const Slot& slot = slots[id];
+    return slot.visible || frame > slot.answered + MAX_ANSWER_AGE;
+}
+
+void OcclusionCuller::setupBox()
+{
+    // unit cube; query() stretches it over the box in the vertex shader
+    const float corners[] = {
+        0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 1.0f,   1.0f, 0.0f, 1.0f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f, 1.0f
+    };
+    const unsigned char faces[] = {
+        0, 2, 1,  0, 3, 2,      // -z
+        4, 5, 6,  4, 6, 7,      // +z
+        0, 1, 5,  0, 5, 4,      // -y
+        3, 6, 2,  3, 7, 6,      // +y
+        0, 4, 7,  0, 7, 3,      // -x
+        1, 2, 6,  1, 6, 5       // +x
+    };
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    GLState::get().bindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    GLState::get().bindVertexArray(0);
+}
+
+void OcclusionCuller::beginQueries(Shader& queryShader, const glm::vec3& eyePosition, float nearPlane)
+{
+    queriesIssued = 0;
+    if (!enabled)
+        return;
+    if (VAO == 0)
+        setupBox();
+
+    shader = &queryShader;
+    eye = eyePosition;
+    // the near plane's corners lie a little further out than the near distance
+    margin = nearPlane * 2.0f;
+
+    // depth test only: nothing is written, and both faces count so a box cut by the near
+    // plane still reports its back faces
+    GLState& state = GLState::get();
+    polygonMode = state.getPolygonMode();
+    cullFace = state.isEnabled(GL_CULL_FACE);
+    state.polygonMode(GL_FILL);
+    state.colorMask(false);
+    state.depthMask(false);
+    state.disable(GL_CULL_FACE);
+    shader->use();
+    state.bindVertexArray(VAO);
+}
+
+void OcclusionCuller::query(size_t id, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    if (!enabled)
+        return;
+    if (id >= slots.size())
+        resize(id + 1);
+    queriedIds.push_back(id);
+
+    Slot& slot = slots[id];
+    if (slot.pending || queriesIssued >= static_cast<size_t>(maxQueriesPerFrame))
+        return;
+
+    // from inside the box every sample of it may be clipped away; such occludees are visible
+    if (glm::all(glm::greaterThan(eye, boxMin - margin)) && glm::all(glm::lessThan(eye, boxMax + margin)))
+    {
+        slot.visible = true;
+        slot.usable = false;
+        slot.answered = frame;
+        return;
+    }
+
+    if (slot.query == 0)
+        glGenQueries(1, &slot.query);
+    shader->setVec3("boxMin", boxMin);
+    shader->setVec3("boxMax", boxMax);
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, slot.query);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+    slot.pending = true;
+    slot.usable = true;
+    slot.issued = frame;
+    pendingIds.push_back(id);
+    ++queriesIssued;
+}
+
+void OcclusionCuller::endQueries()
+{
+    if (!enabled)
+        return;
+    GLState& state = GLState::get();
+    state.colorMask(true);
+    state.depthMask(true);
+    state.enable(GL_CULL_FACE, cullFace);
+    state.polygonMode(polygonMode);
+}
+
+void OcclusionCuller::beginConditional(size_t id)
+{
+    conditionalActive = false;
+    if (!enabled || id >= slots.size())
+        return;
+    const Slot& slot = slots[id];
+    if (slot.query == 0 || !slot.usable || frame > slot.issued + MAX_ANSWER_AGE)
+        return;
+    // a query that hasn't finished yet just lets the draw through
+    glBeginConditionalRender(slot.query, GL_QUERY_NO_WAIT);
+    conditionalActive = true;
+}
+
+void OcclusionCuller::endConditional()
+{
+    if (conditionalActive)
+        glEndConditionalRender();
+    conditionalActive = false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Hardware occlusion culling with bounding-box queries. After the bodies of a frame are
+// drawn, every occludee that survived frustum culling gets its box rasterised with colour
+// and depth writes off inside an any-samples-passed query, a cheap depth-only pass against
+// the finished depth buffer.
+//
+// Results are consumed a frame later so nothing waits on the GPU: a query is only read once
+// GL reports it available, and until then the occludee keeps its previous answer (and no
+// new query is issued for it). Single draws can instead hand the decision to the GPU with
+// beginConditional(), which wraps them in glBeginConditionalRender on the latest query.
+class OcclusionCuller
+{
+public:
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    // makes room for ids [0, count); new occludees start out visible
+    void resize(size_t count);
+    // forgets every query (after the occludees changed meaning, e.g. a new scene)
+    void reset();
+
+    // reads the queries that have finished since last frame; call once per frame before
+    // isVisible()
+    void collect();
+    // false only if a recent finished query for this occludee found no visible samples;
+    // answers older than a few frames (the occludee left the view meanwhile) count as visible
+    bool isVisible(size_t id) const;
+
+    // depth-only query pass: beginQueries() sets up the state, query() issues one box
+    // (skipped while the previous one for this id is in flight or the eye is inside the
+    // box), endQueries() restores colour/depth writes and face culling
+    void beginQueries(Shader& shader, const glm::vec3& eye, float nearPlane);
+    void query(size_t id, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void endQueries();
+
+    // draws between these two are skipped on the GPU if the last query for the id found
+    // the box hidden; does nothing if there is no usable query
+    void beginConditional(size_t id);
+    void endConditional();
+
+    bool enabled;
+    int maxQueriesPerFrame;     // boxes past this stay on their previous answer
+
+    // stats: boxes issued in the last query pass, and how many of the occludees passed to
+    // it are currently considered hidden
+    size_t getQueryCount() const { return queriesIssued; }
+    size_t getOccludedCount() const { return occluded; }
+
+private:
+    struct Slot
+    {
+        unsigned int query;     // 0 until first used
+        bool pending;           // issued and not yet read back
+        bool visible;
+        bool usable;            // the latest query describes the current box (eye outside)
+        uint64_t issued;        // frame of the latest query
+        uint64_t answered;      // frame whose query `visible` comes from
+    };
+
+    static const uint64_t MAX_ANSWER_AGE = 3;
+
+    void setupBox();
+
+    std::vector<Slot> slots;
+    std::vector<size_t> pendingIds;
+    std::vector<size_t> queriedIds;     // passed to query() last frame
+    uint64_t frame;
+    Shader* shader;
+    glm::vec3 eye;
+    float margin;
+    // the caller's state, restored by endQueries()
+    unsigned int polygonMode;
+    bool cullFace;
+    bool conditionalActive;
+
+    unsigned int VAO, VBO, EBO;
+    size_t queriesIssued, occluded;
+};
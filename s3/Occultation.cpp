@@ -0,0 +1,253 @@
+#include "Occultation.h"
+#include "Random.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+// Constants
+const double EARTH_RADIUS_KM = 6378.137;
+const double AU_KM = 149597870.7;
+const double OBLIQUITY_J2000 = 23.4392911 * 3.14159265358979323846 / 180.0;
+const double TWO_PI = 2.0 * 3.14159265358979323846;
+const double RAD_TO_ARCSEC = 180.0 / 3.14159265358979323846 * 3600.0;
+
+OccultationSearch::OccultationSearch(ThreadPool& pool) :
+    pool(pool), generatedSeed(-1), running(false),
+    pairsScreened(0), bruteForcePairs(0), sweepSeconds(0.0)
+{
+}
+
+OccultationSearch::~OccultationSearch()
+{
+    if (pending.valid())
+        pending.wait();
+}
+
+void OccultationSearch::run(const OrbitalElements& earth, const OccultationSettings& requested)
+{
+    if (running)
+        return;
+    running = true;
+    pending = std::async(std::launch::async, [this, earth, requested] {
+        bool reloadCatalog = catalogSource != requested.catalogPath ||
+            (catalogSource.empty() && ((int)catalog.size() != requested.starCount || generatedSeed != requested.seed));
+        if (reloadCatalog || (int)asteroids.size() != requested.asteroidCount || generatedSeed != requested.seed)
+            generateTestData(requested, reloadCatalog);
+        return sweep(earth, requested);
+    });
+}
+
+void OccultationSearch::generateTestData(const OccultationSettings& requested, bool reloadCatalog)
+{
+    if (reloadCatalog)
+    {
+        catalog = StarCatalog();
+        catalogSource.clear();
+        if (requested.catalogPath[0] == '\0')
+            catalog.generateRandom(static_cast<size_t>(std::max(requested.starCount, 0)), static_cast<uint64_t>(requested.seed));
+        else if (catalog.loadFromFile(requested.catalogPath) > 0)
+            catalogSource = requested.catalogPath;   // a failed load is retried on the next run
+    }
+
+    // main-belt-like orbits
+    Random rng(static_cast<uint64_t>(requested.seed) * 7919u + 17u);
+    asteroids.clear();
+    asteroids.reserve(requested.asteroidCount);
+    for (int i = 0; i < requested.asteroidCount; ++i)
+    {
+        AsteroidTrack track;
+        track.name = "Asteroid " + std::to_string(i + 1);
+        track.orbit.semiMajorAxis = rng.uniform(2.1, 3.3);
+        track.orbit.eccentricity = std::min(0.35, std::abs(rng.normal()) * 0.12);
+        track.orbit.inclination = std::abs(rng.normal()) * 0.15;
+        track.orbit.longAscendingNode = rng.uniform(0.0, TWO_PI);
+        track.orbit.argPeriapsis = rng.uniform(0.0, TWO_PI);
+        track.orbit.meanAnomalyAtEpoch = rng.uniform(0.0, TWO_PI);
+        track.radiusKm = 2.0 + 100.0 * std::pow(rng.uniform(), 4.0);
+        asteroids.push_back(track);
+    }
+    generatedSeed = requested.seed;
+}
+
+// heliocentric ecliptic vector -> geocentric equatorial unit vector and distance
+static glm::dvec3 toEquatorial(const glm::dvec3& ecliptic)
+{
+    double c = std::cos(OBLIQUITY_J2000), s = std::sin(OBLIQUITY_J2000);
+    return glm::dvec3(ecliptic.x, ecliptic.y * c - ecliptic.z * s, ecliptic.y * s + ecliptic.z * c);
+}
+
+OccultationSearch::Result OccultationSearch::sweep(const OrbitalElements& earth, const OccultationSettings& grid)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const double step = std::max(grid.stepHours, 0.1f) / 24.0;
+    const size_t samples = static_cast<size_t>(std::ceil(grid.span / step)) + 1;
+
+    // Earth's track is shared by every asteroid
+    std::vector<glm::dvec3> earthPositions(samples);
+    for (size_t k = 0; k < samples; ++k)
+        earthPositions[k] = orbitalPosition(earth, grid.start + k * step);
+
+    Result result;
+    result.pairsScreened = 0;
+    result.bruteForcePairs = static_cast<uint64_t>(catalog.size()) * asteroids.size() * (samples - 1);
+    std::atomic<uint64_t> screened(0);
+    std::mutex eventMutex;
+
+    pool.parallelFor(0, asteroids.size(), [&](size_t a) {
+        const AsteroidTrack& track = asteroids[a];
+        std::vector<glm::dvec3> direction(samples);
+        std::vector<double> distance(samples);
+        std::vector<double> trackRa(samples), trackDec(samples);
+        for (size_t k = 0; k < samples; ++k)
+        {
+            glm::dvec3 geocentric = toEquatorial(orbitalPosition(track.orbit, grid.start + k * step) - earthPositions[k]);
+            distance[k] = glm::length(geocentric);
+            direction[k] = geocentric / distance[k];
+            trackRa[k] = std::atan2(direction[k].y, direction[k].x);
+            if (trackRa[k] < 0.0) trackRa[k] += TWO_PI;
+            trackDec[k] = std::asin(std::clamp(direction[k].z, -1.0, 1.0));
+        }
+
+        uint64_t localScreened = 0;
+        std::vector<OccultationEvent> localEvents;
+        for (size_t k = 0; k + 1 < samples; ++k)
+        {
+            // the shadow can fall anywhere on Earth: widen by Earth's radius as seen from the asteroid
+            double nearest = std::min(distance[k], distance[k + 1]) * AU_KM;
+            double threshold = (EARTH_RADIUS_KM + track.radiusKm) / nearest;
+
+            double decMin = std::min(trackDec[k], trackDec[k + 1]) - threshold;
+            double decMax = std::max(trackDec[k], trackDec[k + 1]) + threshold;
+            double raMin, raMax;
+            double maxAbsDec = std::max(std::abs(decMin), std::abs(decMax));
+            if (maxAbsDec > 1.5706)
+            {
+                raMin = 0.0;
+                raMax = TWO_PI;
+            }
+            else
+            {
+                double delta = std::remainder(trackRa[k + 1] - trackRa[k], TWO_PI);
+                double lo = delta >= 0.0 ? trackRa[k] : trackRa[k + 1];
+                double hi = lo + std::abs(delta);
+                double margin = threshold / std::cos(maxAbsDec);
+                lo -= margin;
+                hi += margin;
+                if (hi - lo >= TWO_PI)
+                {
+                    raMin = 0.0;
+                    raMax = TWO_PI;
+                }
+                else
+                {
+                    raMin = std::fmod(lo + TWO_PI, TWO_PI);
+                    raMax = std::fmod(hi + TWO_PI, TWO_PI);
+                }
+            }
+
+            const glm::dvec3 u0 = direction[k];
+            const glm::dvec3 d = direction[k + 1] - direction[k];
+            const double dd = std::max(glm::dot(d, d), 1e-30);
+            const double threshold2 = threshold * threshold;
+
+            localScreened += catalog.query(raMin, raMax, decMin, decMax, [&](size_t i) {
+                if (catalog.magnitude[i] > grid.magnitudeLimit)
+                    return;
+                // closest approach of the chord u0 + d t to the star direction
+                double sx = catalog.x[i] - u0.x, sy = catalog.y[i] - u0.y, sz = catalog.z[i] - u0.z;
+                double t = std::clamp((sx * d.x + sy * d.y + sz * d.z) / dd, 0.0, 1.0);
+                double ex = sx - d.x * t, ey = sy - d.y * t, ez = sz - d.z * t;
+                double separation2 = ex * ex + ey * ey + ez * ez;
+                if (separation2 < threshold2)
+                {
+                    OccultationEvent event;
+                    event.asteroid = static_cast<int>(a);
+                    event.star = i;
+                    event.time = grid.start + (k + t) * step;
+                    event.separationArcsec = std::sqrt(separation2) * RAD_TO_ARCSEC;
+                    event.distanceAU = distance[k] + (distance[k + 1] - distance[k]) * t;
+                    event.magnitude = catalog.magnitude[i];
+                    localEvents.push_back(event);
+                }
+            });
+        }
+
+        screened += localScreened;
+        if (!localEvents.empty())
+        {
+            std::lock_guard<std::mutex> lock(eventMutex);
+            result.events.insert(result.events.end(), localEvents.begin(), localEvents.end());
+        }
+    });
+
+    std::sort(result.events.begin(), result.events.end(), [](const OccultationEvent& a, const OccultationEvent& b) {
+        return a.time < b.time;
+    });
+    result.pairsScreened = screened;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void OccultationSearch::update()
+{
+    if (!running || !pending.valid())
+        return;
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    Result result = pending.get();
+    events = std::move(result.events);
+    pairsScreened = result.pairsScreened;
+    bruteForcePairs = result.bruteForcePairs;
+    sweepSeconds = result.seconds;
+    running = false;
+}
+
+void OccultationSearch::drawPanel(const OrbitalElements& earth)
+{
+    ImGui::Begin("Occultation Search");
+
+    ImGui::InputFloat("Start (J2000 days)", &settings.start, 1.0f, 30.0f, "%.1f");
+    ImGui::InputFloat("Span (days)", &settings.span, 1.0f, 10.0f, "%.1f");
+    ImGui::SliderFloat("Track step (hours)", &settings.stepHours, 0.5f, 24.0f);
+    ImGui::SliderFloat("Magnitude limit", &settings.magnitudeLimit, 6.0f, 20.0f);
+    ImGui::InputText("Catalog file", settings.catalogPath, sizeof(settings.catalogPath));
+    if (settings.catalogPath[0] == '\0')
+        ImGui::InputInt("Catalog stars", &settings.starCount, 100000, 1000000);
+    else if (!running)
+        ImGui::Text("Loaded stars: %zu", catalog.size());
+    ImGui::InputInt("Asteroids", &settings.asteroidCount, 100, 1000);
+    ImGui::InputInt("Seed", &settings.seed);
+    settings.starCount = std::max(settings.starCount, 0);
+    settings.asteroidCount = std::max(settings.asteroidCount, 0);
+
+    if (running)
+        ImGui::Text("Searching...");
+    else if (ImGui::Button("Run search"))
+        run(earth, settings);
+
+    if (sweepSeconds > 0.0 && !running)
+    {
+        ImGui::Text("Screened %.3g candidate pairs in %.2f s (%.3g pairs/s)",
+            double(pairsScreened), sweepSeconds, double(pairsScreened) / sweepSeconds);
+        ImGui::Text("Brute force would test %.3g pairs (%.0fx more)", double(bruteForcePairs),
+            pairsScreened > 0 ? double(bruteForcePairs) / double(pairsScreened) : 0.0);
+        ImGui::Text("%d occultation candidates", (int)events.size());
+
+        ImGui::BeginChild("Events", ImVec2(0, 200), true);
+        for (size_t i = 0; i < events.size() && i < 200; ++i)
+        {
+            const OccultationEvent& e = events[i];
+            ImGui::Text("day %.3f  %s  star #%zu (mag %.1f)  sep %.3f\"  %.2f AU", e.time,
+                asteroids[e.asteroid].name.c_str(), e.star, e.magnitude, e.separationArcsec, e.distanceAU);
+        }
+        ImGui::EndChild();
+    }
+
+    ImGui::End();
+}
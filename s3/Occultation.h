@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Orbit.h"
+#include "StarCatalog.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+struct AsteroidTrack
+{
+    std::string name;
+    OrbitalElements orbit;   // heliocentric ecliptic, AU / days
+    double radiusKm;
+};
+
+struct OccultationEvent
+{
+    int asteroid;
+    size_t star;
+    double time;                // days since J2000
+    double separationArcsec;    // geocentric closest approach
+    double distanceAU;          // geocentric distance of the asteroid
+    float magnitude;
+};
+
+struct OccultationSettings
+{
+    float start = 9000.0f;      // days since J2000
+    float span = 30.0f;         // days
+    float stepHours = 6.0f;     // track sampling interval
+    float magnitudeLimit = 16.0f;
+    char catalogPath[256] = ""; // "ra_deg dec_deg [mag]" lines; empty for a generated test catalog
+    int starCount = 2000000;    // size of the generated test catalog
+    int asteroidCount = 2000;   // size of the generated test asteroid set
+    int seed = 1;
+};
+
+// Predicts stellar occultations by sweeping propagated asteroid tracks through the
+// catalog's sky-plane index. Each track segment only tests the stars in its RA/Dec box,
+// widened by the shadow's angular size (asteroid radius plus Earth's radius over the
+// geocentric distance), and the asteroids are swept in parallel on the worker pool.
+class OccultationSearch
+{
+public:
+    explicit OccultationSearch(ThreadPool& pool);
+    ~OccultationSearch();
+
+    // runs in the background; reloads the catalog if its file changed and regenerates the
+    // test catalog/asteroids if their size or seed changed
+    void run(const OrbitalElements& earth, const OccultationSettings& settings);
+    bool isRunning() const { return running; }
+    void update();
+
+    void drawPanel(const OrbitalElements& earth);
+
+    const std::vector<OccultationEvent>& getEvents() const { return events; }
+
+private:
+    struct Result
+    {
+        std::vector<OccultationEvent> events;
+        uint64_t pairsScreened;
+        uint64_t bruteForcePairs;
+        double seconds;
+    };
+
+    void generateTestData(const OccultationSettings& settings, bool reloadCatalog);
+    Result sweep(const OrbitalElements& earth, const OccultationSettings& settings);
+
+    ThreadPool& pool;
+    OccultationSettings settings;
+    StarCatalog catalog;
+    std::string catalogSource;  // file the catalog was read from, empty when generated
+    std::vector<AsteroidTrack> asteroids;
+    int generatedSeed;
+
+    std::future<Result> pending;
+    std::atomic<bool> running;
+
+    std::vector<OccultationEvent> events;
+    uint64_t pairsScreened;
+    uint64_t bruteForcePairs;
+    double sweepSeconds;
+};
@@ -0,0 +1,114 @@
+// Orbit.h
+#ifndef ORBIT_H
+#define ORBIT_H
+
+#include "glm.hpp"
+#include <gtc/constants.hpp>
+#include <cmath>
+
+// Gaussian gravitational constant squared: the sun's GM in AU^3/day^2
+const double SUN_MU = 0.01720209895 * 0.01720209895;
+// Earth's GM in km^3/s^2, used for geocentric orbits
+const double EARTH_MU = 398600.4418;
+// 1 AU/day expressed in km/s
+const double AU_PER_DAY_KMS = 1731.456837;
+
+// Classical Keplerian elements. Distances and times are in whatever units mu is expressed
+// in (AU and days for heliocentric orbits, km and seconds for geocentric ones), angles in radians.
+struct OrbitalElements {
+    double semiMajorAxis = 0.0;
+    double eccentricity = 0.0;
+    double inclination = 0.0;
+    double longAscendingNode = 0.0;
+    double argPeriapsis = 0.0;
+    double meanAnomalyAtEpoch = 0.0;
+    double epoch = 0.0;
+    double mu = SUN_MU;
+
+    bool isValid() const { return semiMajorAxis > 0.0; }
+
+    double meanMotion() const { return std::sqrt(mu / (semiMajorAxis * semiMajorAxis * semiMajorAxis)); }
+    double period() const { return 2.0 * glm::pi<double>() / meanMotion(); }
+    double periapsis() const { return semiMajorAxis * (1.0 - eccentricity); }
+    double apoapsis() const { return semiMajorAxis * (1.0 + eccentricity); }
+
+    // builds elements from the longitude form used by the JPL approximate ephemerides
+    // (a, e, I, mean longitude L, longitude of perihelion, longitude of node; angles in degrees)
+    static OrbitalElements fromLongitudes(double a, double e, double incDeg, double meanLongDeg,
+        double longPeriDeg, double longNodeDeg, double epoch = 0.0, double mu = SUN_MU)
+    {
+        OrbitalElements el;
+        el.semiMajorAxis = a;
+        el.eccentricity = e;
+        el.inclination = glm::radians(incDeg);
+        el.longAscendingNode = glm::radians(longNodeDeg);
+        el.argPeriapsis = glm::radians(longPeriDeg - longNodeDeg);
+        el.meanAnomalyAtEpoch = glm::radians(meanLongDeg - longPeriDeg);
+        el.epoch = epoch;
+        el.mu = mu;
+        return el;
+    }
+};
+
+// solves Kepler's equation M = E - e sin(E) for the eccentric anomaly (elliptic orbits only)
+inline double solveKepler(double meanAnomaly, double e)
+{
+    const double twoPi = 2.0 * glm::pi<double>();
+    double M = std::fmod(meanAnomaly, twoPi);
+    if (M < 0.0) M += twoPi;
+    double E = e < 0.8 ? M : glm::pi<double>();
+    for (int i = 0; i < 30; ++i)
+    {
+        double f = E - e * std::sin(E) - M;
+        double dE = f / (1.0 - e * std::cos(E));
+        E -= dE;
+        if (std::abs(dE) < 1e-13)
+            break;
+    }
+    return E;
+}
+
+// computes the position and velocity of an orbit at time t in the reference frame of its elements
+inline void orbitalState(const OrbitalElements& el, double t, glm::dvec3& position, glm::dvec3& velocity)
+{
+    if (!el.isValid())
+    {
+        position = glm::dvec3(0.0);
+        velocity = glm::dvec3(0.0);
+        return;
+    }
+
+    const double a = el.semiMajorAxis;
+    const double e = el.eccentricity;
+    const double n = el.meanMotion();
+    double E = solveKepler(el.meanAnomalyAtEpoch + n * (t - el.epoch), e);
+
+    double cosE = std::cos(E), sinE = std::sin(E);
+    double b = a * std::sqrt(1.0 - e * e);
+    // perifocal coordinates
+    double px = a * (cosE - e);
+    double py = b * sinE;
+    double Edot = n / (1.0 - e * cosE);
+    double vx = -a * sinE * Edot;
+    double vy = b * cosE * Edot;
+
+    // rotate perifocal -> reference frame
+    double cO = std::cos(el.longAscendingNode), sO = std::sin(el.longAscendingNode);
+    double cw = std::cos(el.argPeriapsis), sw = std::sin(el.argPeriapsis);
+    double ci = std::cos(el.inclination), si = std::sin(el.inclination);
+
+    glm::dvec3 P(cO * cw - sO * sw * ci, sO * cw + cO * sw * ci, sw * si);
+    glm::dvec3 Q(-cO * sw - sO * cw * ci, -sO * sw + cO * cw * ci, cw * si);
+
+    position = P * px + Q * py;
+    velocity = P * vx + Q * vy;
+}
+
+inline glm::dvec3 orbitalPosition(const OrbitalElements& el, double t)
+{
+    glm::dvec3 r, v;
+    orbitalState(el, t, r, v);
+    return r;
+}
+
+#endif // ORBIT_H
@@ -0,0 +1,582 @@
+#include "PlanetTerrain.h"
+#include "CubeSphere.h"
+#include "GLState.h"
+#include "VertexCache.h"
+
+#include <glad/glad.h>
+#include <gtc/matrix_transform.hpp>
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    const int GRID = PlanetTerrain::CHUNK_QUADS + 1;
+    const int BORDER = 4 * PlanetTerrain::CHUNK_QUADS;     // skirt vertices
+    const int VERTEX_FLOATS = 12;                           // position, morph delta, normal, direction
+    const double PI = 3.14159265358979323846;
+
+    // lattice value noise in [0, 1]; stateless so worker threads can share it
+    double latticeValue(int64_t x, int64_t y, int64_t z)
+    {
+        uint64_t h = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full ^
+            static_cast<uint64_t>(z) * 0x165667B19E3779F9ull;
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 29;
+        return static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double valueNoise(const glm::dvec3& p)
+    {
+        glm::dvec3 cell = glm::floor(p);
+        glm::dvec3 f = p - cell;
+        glm::dvec3 w = f * f * (3.0 - 2.0 * f);
+        int64_t x = static_cast<int64_t>(cell.x), y = static_cast<int64_t>(cell.y), z = static_cast<int64_t>(cell.z);
+        double c00 = glm::mix(latticeValue(x, y, z), latticeValue(x + 1, y, z), w.x);
+        double c10 = glm::mix(latticeValue(x, y + 1, z), latticeValue(x + 1, y + 1, z), w.x);
+        double c01 = glm::mix(latticeValue(x, y, z + 1), latticeValue(x + 1, y, z + 1), w.x);
+        double c11 = glm::mix(latticeValue(x, y + 1, z + 1), latticeValue(x + 1, y + 1, z + 1), w.x);
+        return glm::mix(glm::mix(c00, c10, w.y), glm::mix(c01, c11, w.y), w.z);
+    }
+
+    // the cube face a node lives on: axis 0-2, side 0 = negative, 1 = positive
+    void faceAxes(int face, int& axis, int& b, int& c, double& side)
+    {
+        axis = face / 2;
+        b = (axis + 1) % 3;
+        c = (axis + 2) % 3;
+        side = (face % 2) ? 1.0 : -1.0;
+    }
+}
+
+PlanetTerrain::PlanetTerrain(ThreadPool& pool) :
+    radius(6371.0), heightScale(6.0), detailScale(1.5), maxLevel(16), splitFactor(2.0f),
+    morphRegion(0.3f), maxUploadsPerFrame(16),
+    pool(pool), active(false), eye(0.0, 0.0, 6371.0 + 3000.0),
+    heightmapWidth(0), heightmapHeight(0),
+    viewProjection(1.0f), nearPlane(1.0f), farPlane(1e4f), frame(0), jobsInFlight(0), uploadsThisFrame(0),
+    EBO(0), indexCount(0),
+    culledFrustum(0), culledHorizon(0), deepestLevel(0)
+{
+}
+
+PlanetTerrain::~PlanetTerrain()
+{
+    reset();
+    if (EBO != 0)
+        glDeleteBuffers(1, &EBO);
+}
+
+void PlanetTerrain::setHeightmap(const TextureLoader::Pixels& pixels, bool invert)
+{
+    if (!pixels.data)
+    {
+        std::cout << "ERROR::TERRAIN::HEIGHTMAP_NOT_LOADED" << std::endl;
+        return;
+    }
+
+    waitForJobs();
+    heightmap.resize(static_cast<size_t>(pixels.width) * pixels.height);
+    for (size_t i = 0; i < heightmap.size(); ++i)
+    {
+        float value = pixels.data[i * pixels.channels] / 255.0f;
+        heightmap[i] = invert ? 1.0f - value : value;
+    }
+    heightmapWidth = pixels.width;
+    heightmapHeight = pixels.height;
+    reset();
+}
+
+void PlanetTerrain::waitForJobs()
+{
+    for (auto& entry : chunks)
+        if (entry.second->pending.valid())
+            entry.second->pending.wait();
+}
+
+void PlanetTerrain::reset()
+{
+    waitForJobs();
+    for (auto& entry : chunks)
+    {
+        Chunk& chunk = *entry.second;
+        if (chunk.VAO != 0)
+        {
+            GLState::get().deleteVertexArrays(1, &chunk.VAO);
+            glDeleteBuffers(1, &chunk.VBO);
+        }
+    }
+    chunks.clear();
+    drawList.clear();
+    jobsInFlight = 0;
+}
+
+void PlanetTerrain::setActive(bool value)
+{
+    active = value;
+    if (!active)
+        drawList.clear();
+}
+
+double PlanetTerrain::altitude() const
+{
+    double distance = glm::length(eye);
+    return distance - radius - heightAt(eye / distance);
+}
+
+void PlanetTerrain::move(const glm::vec3& cameraDelta)
+{
+    double scale = 0.5 * std::max(altitude(), 0.05);
+    eye += glm::dvec3(cameraDelta) * scale;
+
+    // stay a couple of metres above the ground
+    glm::dvec3 direction = glm::normalize(eye);
+    double ground = radius + heightAt(direction) + 0.002;
+    if (glm::length(eye) < ground)
+        eye = direction * ground;
+}
+
+uint64_t PlanetTerrain::nodeKey(int face, int level, uint32_t x, uint32_t y)
+{
+    return (uint64_t(face) << 61) | (uint64_t(level) << 56) | (uint64_t(x) << 28) | uint64_t(y);
+}
+
+glm::dvec3 PlanetTerrain::nodeDirection(int face, int level, double x, double y) const
+{
+    int axis, b, c;
+    double side;
+    faceAxes(face, axis, b, c, side);
+    double scale = 2.0 / static_cast<double>(1u << level);
+    glm::dvec3 cube;
+    cube[axis] = side;
+    cube[b] = -1.0 + x * scale;
+    cube[c] = -1.0 + y * scale;
+    return cubeToSphere(cube);
+}
+
+PlanetTerrain::NodeBounds PlanetTerrain::nodeBounds(int face, int level, uint32_t x, uint32_t y) const
+{
+    // corners and centre on the lowest and highest possible surface
+    const double lowest = radius;
+    const double highest = radius + heightScale + 2.0 * detailScale;
+    glm::dvec3 samples[5] = {
+        nodeDirection(face, level, x, y), nodeDirection(face, level, x + 1.0, y),
+        nodeDirection(face, level, x, y + 1.0), nodeDirection(face, level, x + 1.0, y + 1.0),
+        nodeDirection(face, level, x + 0.5, y + 0.5)
+    };
+    NodeBounds bounds;
+    bounds.center = samples[4] * (0.5 * (lowest + highest));
+    bounds.radius = 0.0;
+    for (const glm::dvec3& direction : samples)
+    {
+        bounds.radius = std::max(bounds.radius, glm::length(direction * lowest - bounds.center));
+        bounds.radius = std::max(bounds.radius, glm::length(direction * highest - bounds.center));
+    }
+    return bounds;
+}
+
+double PlanetTerrain::sampleHeightmap(const glm::dvec3& d) const
+{
+    double angle = std::atan2(-d.z, -d.x);
+    if (angle < 0.0)
+        angle += 2.0 * PI;
+    double u = 1.0 - angle / (2.0 * PI);
+    double v = std::acos(glm::clamp(-d.y, -1.0, 1.0)) / PI;
+
+    double px = u * heightmapWidth - 0.5;
+    double py = glm::clamp(v * heightmapHeight - 0.5, 0.0, heightmapHeight - 1.0);
+    int x0 = static_cast<int>(std::floor(px));
+    int y0 = static_cast<int>(py);
+    double fx = px - x0, fy = py - y0;
+    int y1 = std::min(y0 + 1, heightmapHeight - 1);
+    auto at = [&](int x, int y) {
+        x = ((x % heightmapWidth) + heightmapWidth) % heightmapWidth;
+        return static_cast<double>(heightmap[static_cast<size_t>(y) * heightmapWidth + x]);
+    };
+    return glm::mix(glm::mix(at(x0, y0), at(x0 + 1, y0), fx), glm::mix(at(x0, y1), at(x0 + 1, y1), fx), fy);
+}
+
+double PlanetTerrain::heightAt(const glm::dvec3& direction) const
+{
+    // continents: the heightmap, or low-frequency noise without one
+    double land;
+    if (!heightmap.empty())
+        land = sampleHeightmap(direction);
+    else
+    {
+        land = 0.0;
+        double amplitude = 0.5, frequency = 1.5;
+        for (int octave = 0; octave < 5; ++octave, amplitude *= 0.5, frequency *= 2.0)
+            land += amplitude * valueNoise(direction * frequency + glm::dvec3(17.0));
+        land = glm::clamp((land - 0.45) * 3.0, 0.0, 1.0);
+    }
+
+    // ridged detail down to metre wavelengths, strongest on land
+    double detail = 0.0;
+    double amplitude = detailScale, frequency = 8.0;
+    const double finestFrequency = 2.0 * PI * radius / 0.005;     // 5 m wavelength
+    for (int octave = 0; octave < 24 && frequency < finestFrequency; ++octave, amplitude *= 0.5, frequency *= 2.0)
+    {
+        double ridge = 1.0 - std::fabs(2.0 * valueNoise(direction * frequency) - 1.0);
+        detail += amplitude * ridge * ridge;
+    }
+
+    double height = land * heightScale + detail * (0.15 + land) - 0.3 * detailScale;
+    return std::max(height, 0.0);   // sea level
+}
+
+PlanetTerrain::ChunkMesh PlanetTerrain::buildChunk(int face, int level, uint32_t x, uint32_t y) const
+{
+    const int N = CHUNK_QUADS;
+    const int ext = N + 3;      // one ring outside the chunk for normals
+
+    std::vector<glm::dvec3> points(static_cast<size_t>(ext) * ext);
+    auto point = [&](int i, int j) -> glm::dvec3& { return points[static_cast<size_t>(i + 1) * ext + (j + 1)]; };
+    for (int i = -1; i <= N + 1; ++i)
+    {
+        for (int j = -1; j <= N + 1; ++j)
+        {
+            glm::dvec3 direction = nodeDirection(face, level, x + static_cast<double>(i) / N, y + static_cast<double>(j) / N);
+            point(i, j) = direction * (radius + heightAt(direction));
+        }
+    }
+
+    ChunkMesh mesh;
+    mesh.center = point(N / 2, N / 2);
+    mesh.vertices.reserve(static_cast<size_t>(GRID * GRID + BORDER) * VERTEX_FLOATS);
+    double boundingRadius = 0.0;
+
+    auto emit = [&](const glm::dvec3& position, const glm::dvec3& morph, const glm::dvec3& normal) {
+        glm::dvec3 local = position - mesh.center;
+        glm::dvec3 direction = glm::normalize(position);
+        mesh.vertices.insert(mesh.vertices.end(), {
+            (float)local.x, (float)local.y, (float)local.z,
+            (float)morph.x, (float)morph.y, (float)morph.z,
+            (float)normal.x, (float)normal.y, (float)normal.z,
+            (float)direction.x, (float)direction.y, (float)direction.z });
+        boundingRadius = std::max(boundingRadius, glm::length(local));
+    };
+
+    std::vector<glm::dvec3> morphs(static_cast<size_t>(GRID) * GRID);
+    std::vector<glm::dvec3> normals(static_cast<size_t>(GRID) * GRID);
+    for (int i = 0; i <= N; ++i)
+    {
+        for (int j = 0; j <= N; ++j)
+        {
+            const glm::dvec3& p = point(i, j);
+            // where the vertex lies on the parent's grid (quads split along the 00-11 diagonal)
+            glm::dvec3 target = p;
+            if (i % 2 == 1 && j % 2 == 0)
+                target = 0.5 * (point(i - 1, j) + point(i + 1, j));
+            else if (i % 2 == 0 && j % 2 == 1)
+                target = 0.5 * (point(i, j - 1) + point(i, j + 1));
+            else if (i % 2 == 1 && j % 2 == 1)
+                target = 0.5 * (point(i - 1, j - 1) + point(i + 1, j + 1));
+
+            glm::dvec3 normal = glm::normalize(glm::cross(point(i + 1, j) - point(i - 1, j), point(i, j + 1) - point(i, j - 1)));
+            if (glm::dot(normal, p) < 0.0)
+                normal = -normal;
+
+            morphs[static_cast<size_t>(i) * GRID + j] = target - p;
+            normals[static_cast<size_t>(i) * GRID + j] = normal;
+            emit(p, target - p, normal);
+        }
+    }
+
+    // skirts: the border loop again, dropped below the surface
+    double width = radius * (PI / 2.0) / static_cast<double>(1u << level);
+    double skirtDepth = 0.05 * width + 0.1 * heightScale / (1 << std::min(level, 8));
+    for (int k = 0; k < BORDER; ++k)
+    {
+        int i, j;
+        if (k < N)          { i = k;         j = 0; }
+        else if (k < 2 * N) { i = N;         j = k - N; }
+        else if (k < 3 * N) { i = 3 * N - k; j = N; }
+        else                { i = 0;         j = 4 * N - k; }
+        const glm::dvec3& p = point(i, j);
+        emit(p - glm::normalize(p) * skirtDepth, morphs[static_cast<size_t>(i) * GRID + j], normals[static_cast<size_t>(i) * GRID + j]);
+    }
+
+    mesh.boundingRadius = static_cast<float>(boundingRadius);
+    return mesh;
+}
+
+void PlanetTerrain::setupIndices()
+{
+    const int N = CHUNK_QUADS;
+    std::vector<unsigned int> indices;
+    indices.reserve(static_cast<size_t>(N) * N * 6 + BORDER * 6);
+
+    // counter-clockwise from outside on the positive faces; render() flips the winding
+    // for the negative ones
+    for (int i = 0; i < N; ++i)
+    {
+        for (int j = 0; j < N; ++j)
+        {
+            unsigned int v00 = i * GRID + j, v10 = (i + 1) * GRID + j;
+            unsigned int v01 = v00 + 1, v11 = v10 + 1;
+            indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+        }
+    }
+    auto borderVertex = [&](int k) -> unsigned int {
+        k %= BORDER;
+        int i, j;
+        if (k < N)          { i = k;         j = 0; }
+        else if (k < 2 * N) { i = N;         j = k - N; }
+        else if (k < 3 * N) { i = 3 * N - k; j = N; }
+        else                { i = 0;         j = 4 * N - k; }
+        return static_cast<unsigned int>(i * GRID + j);
+    };
+    for (int k = 0; k < BORDER; ++k)
+    {
+        unsigned int top = borderVertex(k), topNext = borderVertex(k + 1);
+        unsigned int bottom = GRID * GRID + k, bottomNext = GRID * GRID + (k + 1) % BORDER;
+        indices.insert(indices.end(), { top, bottom, topNext, topNext, bottom, bottomNext });
+    }
+
+    indices = optimizeVertexCache(indices, GRID * GRID + BORDER);
+    std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+    indexCount = static_cast<unsigned int>(shortIndices.size());
+
+    // the index buffer binding belongs to whatever vertex array is bound
+    GLState::get().bindVertexArray(0);
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+PlanetTerrain::Chunk* PlanetTerrain::request(int face, int level, uint32_t x, uint32_t y)
+{
+    uint64_t key = nodeKey(face, level, x, y);
+    auto found = chunks.find(key);
+    if (found != chunks.end())
+    {
+        found->second->lastUsed = frame;
+        return found->second->ready ? found->second.get() : NULL;
+    }
+
+    if (jobsInFlight >= static_cast<int>(pool.size()) * 2)
+        return NULL;
+
+    std::unique_ptr<Chunk> chunk(new Chunk());
+    chunk->face = face;
+    chunk->level = level;
+    chunk->boundingRadius = 0.0f;
+    chunk->VAO = chunk->VBO = 0;
+    chunk->lastUsed = frame;
+    chunk->ready = false;
+    chunk->pending = pool.submit([this, face, level, x, y] { return buildChunk(face, level, x, y); });
+    ++jobsInFlight;
+    chunks.emplace(key, std::move(chunk));
+    return NULL;
+}
+
+void PlanetTerrain::collectFinished()
+{
+    uploadsThisFrame = 0;
+    for (auto& entry : chunks)
+    {
+        Chunk& chunk = *entry.second;
+        if (uploadsThisFrame >= maxUploadsPerFrame)
+            break;
+        if (chunk.ready || !chunk.pending.valid() ||
+            chunk.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+
+        ChunkMesh mesh = chunk.pending.get();
+        --jobsInFlight;
+        ++uploadsThisFrame;
+        chunk.center = mesh.center;
+        chunk.boundingRadius = mesh.boundingRadius;
+
+        glGenVertexArrays(1, &chunk.VAO);
+        glGenBuffers(1, &chunk.VBO);
+        GLState::get().bindVertexArray(chunk.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        for (int attribute = 0; attribute < 4; ++attribute)
+        {
+            glVertexAttribPointer(attribute, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(attribute * 3 * sizeof(float)));
+            glEnableVertexAttribArray(attribute);
+        }
+        GLState::get().bindVertexArray(0);
+        chunk.ready = true;
+    }
+}
+
+void PlanetTerrain::evictUnused()
+{
+    // chunks not selected for a few seconds go, unless their job is still running
+    const uint64_t keepFrames = 300;
+    for (auto it = chunks.begin(); it != chunks.end();)
+    {
+        Chunk& chunk = *it->second;
+        if (chunk.lastUsed + keepFrames < frame && chunk.ready)
+        {
+            GLState::get().deleteVertexArrays(1, &chunk.VAO);
+            glDeleteBuffers(1, &chunk.VBO);
+            it = chunks.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+bool PlanetTerrain::isVisible(const NodeBounds& bounds)
+{
+    // frustum, eye-relative
+    if (!frustum.intersectsSphere(glm::vec3(bounds.center - eye), static_cast<float>(bounds.radius)))
+    {
+        ++culledFrustum;
+        return false;
+    }
+
+    // horizon: nothing further than the eye's horizon plus the node's own horizon over the
+    // lowest possible surface can be seen past the planet
+    double eyeDistance = glm::length(eye);
+    double horizon = std::sqrt(std::max(eyeDistance * eyeDistance - radius * radius, 0.0));
+    double top = glm::length(bounds.center) + bounds.radius;
+    double nodeHorizon = std::sqrt(std::max(top * top - radius * radius, 0.0));
+    if (glm::length(bounds.center - eye) - bounds.radius > horizon + nodeHorizon)
+    {
+        ++culledHorizon;
+        return false;
+    }
+    return true;
+}
+
+void PlanetTerrain::select(int face, int level, uint32_t x, uint32_t y)
+{
+    // conservative bounds from the height range first, then the built chunk's own
+    if (!isVisible(nodeBounds(face, level, x, y)))
+        return;
+    Chunk* self = request(face, level, x, y);
+    if (self == NULL)
+        return;     // only happens before the first faces are built
+    NodeBounds bounds = { self->center, self->boundingRadius };
+    if (!isVisible(bounds))
+        return;
+
+    double width = radius * (PI / 2.0) / static_cast<double>(1u << level);
+    double distance = std::max(glm::length(bounds.center - eye) - bounds.radius, 0.0);
+
+    if (level < maxLevel && distance < splitFactor * width)
+    {
+        // descend only once all four children are there, so the area is never left empty
+        bool childrenReady = true;
+        for (uint32_t child = 0; child < 4; ++child)
+            childrenReady = request(face, level + 1, x * 2 + (child & 1), y * 2 + (child >> 1)) != NULL && childrenReady;
+        if (childrenReady)
+        {
+            for (uint32_t child = 0; child < 4; ++child)
+                select(face, level + 1, x * 2 + (child & 1), y * 2 + (child >> 1));
+            return;
+        }
+    }
+
+    drawList.push_back(self);
+    deepestLevel = std::max(deepestLevel, level);
+}
+
+void PlanetTerrain::update(const glm::vec3& front, const glm::vec3& up, float fovY, float aspect)
+{
+    if (!active)
+        return;
+    if (EBO == 0)
+        setupIndices();
+
+    ++frame;
+    culledFrustum = culledHorizon = deepestLevel = 0;
+    drawList.clear();
+    collectFinished();
+
+    // depth range from the height above ground to the far horizon
+    double eyeDistance = glm::length(eye);
+    double highest = radius + heightScale + 2.0 * detailScale;
+    double horizon = std::sqrt(std::max(eyeDistance * eyeDistance - radius * radius, 0.0)) +
+        std::sqrt(highest * highest - radius * radius);
+    nearPlane = static_cast<float>(std::max(0.3 * altitude(), 0.0005));
+    farPlane = static_cast<float>(horizon * 1.1);
+
+    glm::mat4 projection = glm::perspective(glm::radians(fovY), aspect, nearPlane, farPlane);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), front, up);
+    viewProjection = projection * view;
+
+    frustum = Frustum(viewProjection);
+
+    for (int face = 0; face < 6; ++face)
+        select(face, 0, 0, 0);
+
+    evictUnused();
+}
+
+void PlanetTerrain::render(Shader& shader, const glm::vec3& lightDirection, unsigned int surfaceTexture)
+{
+    if (!active || drawList.empty())
+        return;
+
+    // own depth range, so the rest of the scene's depth is of no use
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    shader.use();
+    shader.setMat4("viewProjection", viewProjection);
+    shader.setVec3("lightDirection", glm::normalize(lightDirection));
+    shader.setInt("surfaceTexture", 0);
+    GLState::get().bindTexture(0, GL_TEXTURE_2D, surfaceTexture);
+
+    for (Chunk* chunk : drawList)
+    {
+        // parent takes over at twice this level's split distance; root chunks never morph
+        double width = radius * (PI / 2.0) / static_cast<double>(1u << chunk->level);
+        float morphEnd = chunk->level > 0 ? static_cast<float>(2.0 * splitFactor * width) : 1e30f;
+        float morphStart = morphEnd * (1.0f - morphRegion);
+        shader.setVec3("chunkOffset", glm::vec3(chunk->center - eye));
+        shader.setVec2("morphRange", morphStart, morphEnd);
+
+        // the shared index buffer winds counter-clockwise on the positive cube faces only
+        glFrontFace(chunk->face % 2 ? GL_CCW : GL_CW);
+        GLState::get().bindVertexArray(chunk->VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+    }
+    glFrontFace(GL_CCW);
+}
+
+void PlanetTerrain::drawPanel()
+{
+    ImGui::Begin("Surface Flyover");
+
+    bool flying = active;
+    if (ImGui::Checkbox("Fly over the surface", &flying))
+        setActive(flying);
+    ImGui::Text("Altitude %.3f km", altitude());
+    ImGui::SliderInt("Max level", &maxLevel, 0, 20);
+    ImGui::SliderFloat("Split distance", &splitFactor, 1.0f, 6.0f);
+    ImGui::SliderFloat("Morph region", &morphRegion, 0.05f, 0.9f);
+
+    // the shape is read by the chunk jobs, so changing it rebuilds everything
+    float height = static_cast<float>(heightScale);
+    float detail = static_cast<float>(detailScale);
+    if (ImGui::SliderFloat("Height scale (km)", &height, 0.0f, 20.0f))
+    {
+        reset();
+        heightScale = height;
+    }
+    if (ImGui::SliderFloat("Detail scale (km)", &detail, 0.0f, 10.0f))
+    {
+        reset();
+        detailScale = detail;
+    }
+
+    size_t triangles = drawList.size() * indexCount / 3;
+    ImGui::Text("%zu chunks drawn, %zu triangles, deepest level %d", drawList.size(), triangles, deepestLevel);
+    ImGui::Text("Culled: %d frustum, %d horizon", culledFrustum, culledHorizon);
+    ImGui::Text("%zu chunks cached, %d building", chunks.size(), jobsInFlight);
+
+    ImGui::End();
+}
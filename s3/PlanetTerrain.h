@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Frustum.h"
+#include "Shader.h"
+#include "TextureLoader.h"
+#include "ThreadPool.h"
+
+#include <glm.hpp>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// CDLOD-style planet surface for low flyovers. The planet is a cube whose six faces are
+// quadtrees; every node is a chunk of CHUNK_QUADS x CHUNK_QUADS quads projected onto the
+// sphere and displaced by the height function (heightmap + noise detail). Nodes are split
+// while the eye is closer than splitFactor chunk widths, so the number of chunks on screen,
+// and with it the triangle count, stays about the same from orbit down to the mountains.
+//
+// Each vertex also stores where it would sit on the parent's grid; the vertex shader blends
+// towards that position as the chunk approaches the distance at which its parent takes over,
+// so level changes don't pop. Skirts hide the remaining cracks between levels.
+//
+// Everything is planet-centred and in kilometres, kept in double precision on the CPU and
+// rendered relative to the eye, so float precision holds at metre scale on an Earth-sized
+// planet. Chunk meshes are built on the worker pool and uploaded when finished.
+class PlanetTerrain
+{
+public:
+    static const int CHUNK_QUADS = 32;      // even, so every vertex has a parent-grid target
+
+    explicit PlanetTerrain(ThreadPool& pool);
+    ~PlanetTerrain();
+
+    // equirectangular greyscale heightmap (bright = high), rows from the south pole up, as
+    // TextureLoader decodes them; only the first channel is read. invert for masks where bright
+    // is low. Without one the continents come from noise.
+    void setHeightmap(const TextureLoader::Pixels& pixels, bool invert = false);
+
+    // drops every chunk (after changing the shape settings)
+    void reset();
+
+    // flyover mode: replaces the 3D view like SkyView
+    bool isActive() const { return active; }
+    void setActive(bool value);
+
+    // moves the eye by a scene-camera offset; one camera unit covers about the current
+    // altitude, so the same keys work in orbit and at ground level
+    void move(const glm::vec3& cameraDelta);
+
+    // selects and culls the chunks for this frame, queues missing ones on the pool and
+    // uploads finished ones
+    void update(const glm::vec3& front, const glm::vec3& up, float fovY, float aspect);
+
+    // draws the selected chunks with their own projection (clears depth first), using the
+    // terrain program (shaders/terrain.vs/.fs)
+    void render(Shader& shader, const glm::vec3& lightDirection, unsigned int surfaceTexture);
+
+    void drawPanel();
+
+    double altitude() const;                // above the surface below the eye, km
+
+    // shape
+    double radius;                          // km
+    double heightScale;                     // km, heightmap range
+    double detailScale;                     // km, amplitude of the largest noise octave
+    int maxLevel;
+    float splitFactor;                      // split while eye distance < splitFactor * chunk width
+    float morphRegion;                      // fraction of a level's range spent morphing
+    int maxUploadsPerFrame;
+
+private:
+    struct ChunkMesh
+    {
+        glm::dvec3 center;                  // planet-centred, km
+        float boundingRadius;
+        std::vector<float> vertices;        // position, morph delta, normal, direction
+    };
+
+    struct Chunk
+    {
+        int face;
+        int level;
+        glm::dvec3 center;
+        float boundingRadius;
+        unsigned int VAO, VBO;
+        uint64_t lastUsed;
+        bool ready;
+        std::future<ChunkMesh> pending;
+    };
+
+    struct NodeBounds
+    {
+        glm::dvec3 center;
+        double radius;
+    };
+
+    // face, level and position packed into one key
+    static uint64_t nodeKey(int face, int level, uint32_t x, uint32_t y);
+    NodeBounds nodeBounds(int face, int level, uint32_t x, uint32_t y) const;
+    glm::dvec3 nodeDirection(int face, int level, double x, double y) const;
+
+    ChunkMesh buildChunk(int face, int level, uint32_t x, uint32_t y) const;
+    double heightAt(const glm::dvec3& direction) const;
+    double sampleHeightmap(const glm::dvec3& direction) const;
+
+    // returns the chunk if ready, otherwise queues it (if there is room) and returns null
+    Chunk* request(int face, int level, uint32_t x, uint32_t y);
+    void select(int face, int level, uint32_t x, uint32_t y);
+    bool isVisible(const NodeBounds& bounds);
+    void collectFinished();
+    void evictUnused();
+    void waitForJobs();
+    void setupIndices();
+
+    ThreadPool& pool;
+    bool active;
+    glm::dvec3 eye;                         // planet-centred, km
+
+    std::vector<float> heightmap;
+    int heightmapWidth, heightmapHeight;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+    std::vector<Chunk*> drawList;
+    Frustum frustum;                        // eye-relative
+    glm::mat4 viewProjection;               // eye-relative
+    float nearPlane, farPlane;
+    uint64_t frame;
+    int jobsInFlight;
+    int uploadsThisFrame;
+
+    unsigned int EBO;                       // shared by every chunk
+    unsigned int indexCount;
+
+    // stats of the last update
+    int culledFrustum, culledHorizon, deepestLevel;
+};
@@ -0,0 +1,248 @@
+#include "Porkchop.h"
+#include "GLState.h"
+#include "Lambert.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Porkchop::Porkchop(ThreadPool& pool) :
+    pool(pool), computing(false), rowsDone(0), pendingRows(1),
+    solveSeconds(0.0), bestC3(-1.0f), bestDeparture(0.0f), bestArrival(0.0f),
+    heatmapTexture(0)
+{
+}
+
+Porkchop::~Porkchop()
+{
+    if (pending.valid())
+        pending.wait();
+    if (heatmapTexture)
+        GLState::get().deleteTextures(1, &heatmapTexture);
+}
+
+void Porkchop::compute(const std::vector<SpaceObject*>& bodies, const PorkchopSettings& requested)
+{
+    if (computing)
+        return;
+    if (requested.departureBody < 0 || requested.departureBody >= (int)bodies.size() ||
+        requested.arrivalBody < 0 || requested.arrivalBody >= (int)bodies.size())
+        return;
+
+    // snapshot the ephemerides so the simulation can keep running while the grid solves
+    std::vector<OrbitalElements> orbits = {
+        bodies[requested.departureBody]->getOrbit(),
+        bodies[requested.arrivalBody]->getOrbit()
+    };
+
+    computing = true;
+    rowsDone = 0;
+    pendingRows = std::max(requested.rows, 1);
+    pending = std::async(std::launch::async, [this, orbits, requested] {
+        return solveGrid(orbits, requested);
+    });
+}
+
+Porkchop::Result Porkchop::solveGrid(std::vector<OrbitalElements> orbits, PorkchopSettings grid)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const size_t rows = static_cast<size_t>(std::max(grid.rows, 1));
+    const size_t columns = static_cast<size_t>(std::max(grid.columns, 1));
+    const double kms2 = AU_PER_DAY_KMS * AU_PER_DAY_KMS;
+
+    // arrival ephemeris is the same for every row: evaluate it once
+    std::vector<double> arrivalTimes(columns);
+    std::vector<glm::dvec3> arrivalPositions(columns), arrivalVelocities(columns);
+    for (size_t j = 0; j < columns; ++j)
+    {
+        arrivalTimes[j] = grid.arrivalStart + grid.arrivalSpan * (columns > 1 ? double(j) / (columns - 1) : 0.0);
+        orbitalState(orbits[1], arrivalTimes[j], arrivalPositions[j], arrivalVelocities[j]);
+    }
+
+    Result result;
+    result.settings = grid;
+    result.c3.assign(rows * columns, -1.0f);
+    result.vInf.assign(rows * columns, -1.0f);
+
+    static std::atomic<unsigned int> gridCounter(0);
+    const unsigned int gridId = ++gridCounter;
+
+    pool.parallelFor(0, rows, [&](size_t i) {
+        // one batch per worker thread, loaded with the arrival states once per grid
+        thread_local LambertBatch batch;
+        thread_local unsigned int batchGrid = 0;
+        if (batchGrid != gridId)
+        {
+            batch.setArrivals(arrivalPositions, arrivalVelocities);
+            batchGrid = gridId;
+        }
+
+        double departureTime = grid.departureStart + grid.departureSpan * (rows > 1 ? double(i) / (rows - 1) : 0.0);
+        glm::dvec3 r1, v1;
+        orbitalState(orbits[0], departureTime, r1, v1);
+
+        float* rowC3 = &result.c3[i * columns];
+        float* rowVinf = &result.vInf[i * columns];
+        batch.solveRow(r1, v1, departureTime, arrivalTimes, SUN_MU, grid.maxRevolutions, rowC3, rowVinf);
+        for (size_t j = 0; j < columns; ++j)
+        {
+            if (rowC3[j] >= 0.0f)
+            {
+                rowC3[j] = static_cast<float>(rowC3[j] * kms2);
+                rowVinf[j] = static_cast<float>(rowVinf[j] * AU_PER_DAY_KMS);
+            }
+        }
+        rowsDone++;
+    }, 4);
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void Porkchop::update()
+{
+    if (!computing || !pending.valid())
+        return;
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    Result result = pending.get();
+    resultSettings = result.settings;
+    c3 = std::move(result.c3);
+    vInf = std::move(result.vInf);
+    solveSeconds = result.seconds;
+    buildHeatmap();
+    computing = false;
+}
+
+// maps 0..1 to a blue -> green -> yellow -> red ramp
+static void heatColor(float t, unsigned char* rgba)
+{
+    const float stops[5][3] = {
+        { 0.05f, 0.10f, 0.60f }, { 0.00f, 0.60f, 0.90f }, { 0.10f, 0.85f, 0.30f },
+        { 0.95f, 0.90f, 0.10f }, { 0.90f, 0.15f, 0.10f }
+    };
+    t = std::clamp(t, 0.0f, 1.0f) * 4.0f;
+    int i = std::min(static_cast<int>(t), 3);
+    float f = t - i;
+    for (int c = 0; c < 3; ++c)
+        rgba[c] = static_cast<unsigned char>(255.0f * (stops[i][c] + (stops[i + 1][c] - stops[i][c]) * f));
+    rgba[3] = 255;
+}
+
+void Porkchop::buildHeatmap()
+{
+    const int rows = std::max(resultSettings.rows, 1);
+    const int columns = std::max(resultSettings.columns, 1);
+
+    bestC3 = -1.0f;
+    // texture x = departure date, y = arrival date
+    std::vector<unsigned char> pixels(static_cast<size_t>(rows) * columns * 4);
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int j = 0; j < columns; ++j)
+        {
+            float value = c3[static_cast<size_t>(i) * columns + j];
+            unsigned char* px = &pixels[(static_cast<size_t>(j) * rows + i) * 4];
+            if (value < 0.0f || value > resultSettings.maxC3)
+            {
+                px[0] = px[1] = px[2] = 12;
+                px[3] = 255;
+                continue;
+            }
+            heatColor(value / resultSettings.maxC3, px);
+            // darken a thin band every 5 km^2/s^2 to give contour lines
+            if (std::fmod(value, 5.0f) < resultSettings.maxC3 * 0.004f)
+            {
+                px[0] /= 3; px[1] /= 3; px[2] /= 3;
+            }
+            if (bestC3 < 0.0f || value < bestC3)
+            {
+                bestC3 = value;
+                bestDeparture = resultSettings.departureStart + resultSettings.departureSpan * (rows > 1 ? float(i) / (rows - 1) : 0.0f);
+                bestArrival = resultSettings.arrivalStart + resultSettings.arrivalSpan * (columns > 1 ? float(j) / (columns - 1) : 0.0f);
+            }
+        }
+    }
+
+    if (!heatmapTexture)
+        glGenTextures(1, &heatmapTexture);
+    GLState::get().bindTexture(GL_TEXTURE_2D, heatmapTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rows, columns, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void Porkchop::drawPanel(const std::vector<SpaceObject*>& bodies)
+{
+    ImGui::Begin("Porkchop Plot");
+
+    auto bodyName = [](void* data, int index) -> const char* {
+        return (*static_cast<const std::vector<SpaceObject*>*>(data))[index]->getName().c_str();
+    };
+    void* bodyList = const_cast<void*>(static_cast<const void*>(&bodies));
+    ImGui::Combo("Departure", &settings.departureBody, bodyName, bodyList, (int)bodies.size());
+    ImGui::Combo("Arrival", &settings.arrivalBody, bodyName, bodyList, (int)bodies.size());
+    ImGui::InputFloat("Launch start (J2000 days)", &settings.departureStart, 10.0f, 100.0f, "%.0f");
+    ImGui::InputFloat("Launch span (days)", &settings.departureSpan, 10.0f, 100.0f, "%.0f");
+    ImGui::InputFloat("Arrival start (J2000 days)", &settings.arrivalStart, 10.0f, 100.0f, "%.0f");
+    ImGui::InputFloat("Arrival span (days)", &settings.arrivalSpan, 10.0f, 100.0f, "%.0f");
+    ImGui::SliderInt("Launch samples", &settings.rows, 16, 2000);
+    ImGui::SliderInt("Arrival samples", &settings.columns, 16, 2000);
+    ImGui::SliderInt("Max revolutions", &settings.maxRevolutions, 0, 3);
+    ImGui::SliderFloat("C3 scale (km^2/s^2)", &settings.maxC3, 5.0f, 200.0f);
+
+    if (computing)
+    {
+        float progress = float(rowsDone) / float(pendingRows);
+        ImGui::ProgressBar(std::min(progress, 1.0f), ImVec2(-1.0f, 0.0f), "Solving...");
+    }
+    else if (ImGui::Button("Compute"))
+    {
+        compute(bodies, settings);
+    }
+
+    if (heatmapTexture)
+    {
+        double cells = double(resultSettings.rows) * resultSettings.columns;
+        ImGui::Text("%d x %d grid in %.2f s (%.2f M transfers/s)", resultSettings.rows, resultSettings.columns,
+            solveSeconds, solveSeconds > 0.0 ? cells / solveSeconds * 1e-6 : 0.0);
+        if (bestC3 >= 0.0f)
+            ImGui::Text("Min C3 %.2f km^2/s^2: launch day %.0f, arrival day %.0f", bestC3, bestDeparture, bestArrival);
+
+        ImVec2 imageSize(400.0f, 400.0f);
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        // flip v so arrival dates increase upwards
+        ImGui::Image((ImTextureID)(intptr_t)heatmapTexture, imageSize, ImVec2(0, 1), ImVec2(1, 0));
+        if (ImGui::IsItemHovered())
+        {
+            ImVec2 mouse = ImGui::GetMousePos();
+            float u = std::clamp((mouse.x - origin.x) / imageSize.x, 0.0f, 1.0f);
+            float v = std::clamp(1.0f - (mouse.y - origin.y) / imageSize.y, 0.0f, 1.0f);
+            int i = std::min(static_cast<int>(u * resultSettings.rows), resultSettings.rows - 1);
+            int j = std::min(static_cast<int>(v * resultSettings.columns), resultSettings.columns - 1);
+            size_t cell = static_cast<size_t>(i) * resultSettings.columns + j;
+            if (cell < c3.size())
+            {
+                ImGui::BeginTooltip();
+                ImGui::Text("Launch day %.0f", resultSettings.departureStart + u * resultSettings.departureSpan);
+                ImGui::Text("Arrival day %.0f", resultSettings.arrivalStart + v * resultSettings.arrivalSpan);
+                if (c3[cell] >= 0.0f)
+                    ImGui::Text("C3 %.2f km^2/s^2, arrival v-inf %.2f km/s", c3[cell], vInf[cell]);
+                else
+                    ImGui::Text("No transfer");
+                ImGui::EndTooltip();
+            }
+        }
+    }
+
+    ImGui::End();
+}
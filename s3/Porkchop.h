@@ -0,0 +1,76 @@
+#pragma once
+
+#include "spaceobject.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+// Launch/arrival date grid for a transfer between two bodies. Dates are days since J2000.
+struct PorkchopSettings
+{
+    int departureBody = 2;
+    int arrivalBody = 3;
+    float departureStart = 8950.0f;
+    float departureSpan = 300.0f;
+    float arrivalStart = 9100.0f;
+    float arrivalSpan = 400.0f;
+    int columns = 1000;          // arrival samples
+    int rows = 1000;             // departure samples
+    int maxRevolutions = 1;
+    float maxC3 = 60.0f;         // km^2/s^2, upper end of the colour scale
+};
+
+// Porkchop plot generator. The grid is solved in the background on the worker pool (one
+// Lambert batch per departure row, arrival ephemerides evaluated once per grid) and the
+// result is turned into a heatmap texture that the ImGui panel displays.
+class Porkchop
+{
+public:
+    explicit Porkchop(ThreadPool& pool);
+    ~Porkchop();
+
+    // starts computing a grid; ignored while a previous grid is still running
+    void compute(const std::vector<SpaceObject*>& bodies, const PorkchopSettings& settings);
+    bool isComputing() const { return computing; }
+
+    // call once per frame from the GL thread: picks up finished grids and uploads the heatmap
+    void update();
+
+    // draws the "Porkchop Plot" window
+    void drawPanel(const std::vector<SpaceObject*>& bodies);
+
+    // results, in km^2/s^2 and km/s; negative where no transfer exists
+    const std::vector<float>& getC3() const { return c3; }
+    const std::vector<float>& getArrivalVinf() const { return vInf; }
+
+private:
+    struct Result
+    {
+        PorkchopSettings settings;
+        std::vector<float> c3;
+        std::vector<float> vInf;
+        double seconds;
+    };
+
+    Result solveGrid(std::vector<OrbitalElements> orbits, PorkchopSettings settings);
+    void buildHeatmap();
+
+    ThreadPool& pool;
+    PorkchopSettings settings;
+    PorkchopSettings resultSettings;
+    std::future<Result> pending;
+    std::atomic<bool> computing;
+    std::atomic<int> rowsDone;
+    int pendingRows;
+
+    std::vector<float> c3;
+    std::vector<float> vInf;
+    double solveSeconds;
+    float bestC3;
+    float bestDeparture;
+    float bestArrival;
+    unsigned int heatmapTexture;
+};
@@ -0,0 +1,200 @@
+#include "PostProcess.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+#include <algorithm>
+#include <iostream>
+
+PostProcess::PostProcess(ShaderCache& shaderCache) :
+    exposure(0.0f), bloomStrength(0.04f), bloomRadius(1.0f), bloomLevels(5), bloomEnabled(true),
+    sourceWidth(0), sourceHeight(0), allocatedLevels(0),
+    downsampleShader(shaderCache.get("shaders/post.vs", "shaders/bloom_downsample.fs")),
+    upsampleShader(shaderCache.get("shaders/post.vs", "shaders/bloom_upsample.fs")),
+    tonemapShader(shaderCache.get("shaders/post.vs", "shaders/tonemap.fs")), VAO(0),
+    timerIndex(0), gpuMs(0.0)
+{
+    timers[0] = timers[1] = 0;
+    timerPending[0] = timerPending[1] = false;
+}
+
+PostProcess::~PostProcess()
+{
+    release();
+    if (VAO != 0)
+    {
+        GLState::get().deleteVertexArrays(1, &VAO);
+        glDeleteQueries(2, timers);
+    }
+}
+
+void PostProcess::release()
+{
+    for (Level& level : levels)
+    {
+        glDeleteFramebuffers(1, &level.FBO);
+        GLState::get().deleteTextures(1, &level.texture);
+    }
+    levels.clear();
+}
+
+void PostProcess::allocate(int width, int height)
+{
+    release();
+    sourceWidth = width;
+    sourceHeight = height;
+    allocatedLevels = bloomLevels;
+
+    for (int i = 0; i < bloomLevels; ++i)
+    {
+        Level level;
+        level.width = std::max(1, width >> (i + 1));
+        level.height = std::max(1, height >> (i + 1));
+
+        // the glow has no alpha and doesn't need half-float precision per channel
+        glGenTextures(1, &level.texture);
+        GLState::get().bindTexture(GL_TEXTURE_2D, level.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, level.width, level.height, 0, GL_RGB, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glGenFramebuffers(1, &level.FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, level.FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER::BLOOM_LEVEL_NOT_COMPLETE" << std::endl;
+        levels.push_back(level);
+
+        // nothing left to blur below a few texels
+        if (level.width <= 4 || level.height <= 4)
+            break;
+    }
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PostProcess::readTimer()
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!timerPending[i])
+            continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(timers[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(timers[i], GL_QUERY_RESULT, &nanoseconds);
+        gpuMs = nanoseconds * 1e-6;
+        timerPending[i] = false;
+    }
+}
+
+void PostProcess::render(unsigned int sceneTexture, int width, int height)
+{
+    if (VAO == 0)
+    {
+        downsampleShader->use();
+        downsampleShader->setInt("source", 0);
+        upsampleShader->use();
+        upsampleShader->setInt("source", 0);
+        tonemapShader->use();
+        tonemapShader->setInt("scene", 0);
+        tonemapShader->setInt("bloom", 1);
+        glGenVertexArrays(1, &VAO);
+        glGenQueries(2, timers);
+    }
+    if (width != sourceWidth || height != sourceHeight || bloomLevels != allocatedLevels)
+        allocate(width, height);
+
+    readTimer();
+    const bool timing = !timerPending[timerIndex];
+    if (timing)
+        glBeginQuery(GL_TIME_ELAPSED, timers[timerIndex]);
+
+    GLState& state = GLState::get();
+    const unsigned int polygonMode = state.getPolygonMode();
+    state.polygonMode(GL_FILL);
+    state.disable(GL_DEPTH_TEST);
+    state.disable(GL_CULL_FACE);
+    state.disable(GL_BLEND);
+    state.bindVertexArray(VAO);
+
+    const bool bloom = bloomEnabled && bloomStrength > 0.0f && !levels.empty();
+    if (bloom)
+    {
+        // down the chain; the first step also tames single-pixel highlights
+        downsampleShader->use();
+        unsigned int source = sceneTexture;
+        int sourceLevelWidth = width, sourceLevelHeight = height;
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, levels[i].FBO);
+            glViewport(0, 0, levels[i].width, levels[i].height);
+            downsampleShader->setVec2("texelSize", 1.0f / sourceLevelWidth, 1.0f / sourceLevelHeight);
+            downsampleShader->setBool("firstLevel", i == 0);
+            state.bindTexture(0, GL_TEXTURE_2D, source);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            source = levels[i].texture;
+            sourceLevelWidth = levels[i].width;
+            sourceLevelHeight = levels[i].height;
+        }
+
+        // and back up, each level added onto the next larger one
+        upsampleShader->use();
+        upsampleShader->setFloat("radius", bloomRadius);
+        state.enable(GL_BLEND);
+        state.blendFunc(GL_ONE, GL_ONE);
+        for (size_t i = levels.size() - 1; i > 0; --i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, levels[i - 1].FBO);
+            glViewport(0, 0, levels[i - 1].width, levels[i - 1].height);
+            upsampleShader->setVec2("texelSize", 1.0f / levels[i].width, 1.0f / levels[i].height);
+            state.bindTexture(0, GL_TEXTURE_2D, levels[i].texture);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        state.disable(GL_BLEND);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    tonemapShader->use();
+    tonemapShader->setFloat("exposure", exposure);
+    tonemapShader->setFloat("bloomStrength", bloom ? bloomStrength : 0.0f);
+    tonemapShader->setFloat("bloomNormalization", levels.empty() ? 1.0f : 1.0f / levels.size());
+    tonemapShader->setVec2("bloomTexelSize", levels.empty() ? glm::vec2(0.0f) :
+        glm::vec2(1.0f / levels[0].width, 1.0f / levels[0].height));
+    state.bindTexture(0, GL_TEXTURE_2D, sceneTexture);
+    state.bindTexture(1, GL_TEXTURE_2D, bloom ? levels[0].texture : sceneTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    state.enable(GL_DEPTH_TEST);
+    state.enable(GL_CULL_FACE);
+    state.polygonMode(polygonMode);
+
+    if (timing)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        timerPending[timerIndex] = true;
+        timerIndex ^= 1;
+    }
+}
+
+void PostProcess::drawPanel()
+{
+    ImGui::Begin("HDR and Bloom");
+
+    ImGui::SliderFloat("Exposure (EV)", &exposure, -10.0f, 10.0f, "%.1f");
+    ImGui::Checkbox("Bloom", &bloomEnabled);
+    ImGui::SliderFloat("Bloom strength", &bloomStrength, 0.001f, 0.5f, "%.3f", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderFloat("Bloom radius", &bloomRadius, 0.5f, 3.0f);
+    ImGui::SliderInt("Bloom levels", &bloomLevels, 1, 8);
+    ImGui::Text("%zu levels from %dx%d", levels.size(),
+        levels.empty() ? 0 : levels[0].width, levels.empty() ? 0 : levels[0].height);
+    ImGui::Text("Bloom + tone map: %.3f ms GPU", gpuMs);
+
+    ImGui::End();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ShaderCache.h"
+
+#include <memory>
+#include <vector>
+
+// HDR resolve of the 3D view: a bloom chain and a filmic tone curve.
+//
+// The scene is rendered into a half-float target, so the emissive intensities are plain
+// radiance multipliers (1 = the reference white at 0 EV) and anything brighter than the
+// display can show spills into the glow instead of clipping flat. Bloom follows the
+// downsample/upsample scheme from Call of Duty: Advanced Warfare: a 13-tap filtered
+// downsample into a chain of ever smaller targets, the first at half resolution, then a
+// tent-filtered upsample that adds each level onto the next larger one. There is no
+// brightness threshold; a small fraction of all light is spread, which is what a lens does,
+// and only very bright sources spread enough to see. The result is mixed into the scene,
+// exposed and tone mapped with the ACES filmic fit.
+//
+// All of it works on linear light: colour textures are sampled through sRGB formats and
+// picked colours are converted before they reach the scene. The tone-mapped image is
+// sRGB-encoded by the tone mapping shader itself.
+class PostProcess
+{
+public:
+    // the bloom and tone mapping programs come from the cache
+    explicit PostProcess(ShaderCache& shaderCache);
+    ~PostProcess();
+
+    // bloom from the HDR scene texture, then tone maps into the bound framebuffer
+    void render(unsigned int sceneTexture, int width, int height);
+    void drawPanel();
+
+    float exposure;          // EV
+    float bloomStrength;     // fraction of the light redistributed into the glow
+    float bloomRadius;       // upsample tent radius, in texels of the smaller level
+    int bloomLevels;         // the first is half resolution, each next one half again
+    bool bloomEnabled;
+
+private:
+    struct Level
+    {
+        unsigned int FBO, texture;
+        int width, height;
+    };
+
+    void allocate(int width, int height);
+    void release();
+    void readTimer();
+
+    std::vector<Level> levels;
+    int sourceWidth, sourceHeight, allocatedLevels;
+
+    std::shared_ptr<Shader> downsampleShader;
+    std::shared_ptr<Shader> upsampleShader;
+    std::shared_ptr<Shader> tonemapShader;
+    unsigned int VAO;            // empty; the full-screen triangle comes from gl_VertexID
+
+    // GPU time of the chain, read back a frame or two later so nothing waits
+    unsigned int timers[2];
+    bool timerPending[2];
+    int timerIndex;
+    double gpuMs;
+};
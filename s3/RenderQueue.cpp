@@ -0,0 +1,148 @@
+#include "RenderQueue.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    const int PROGRAM_BITS = 12, TEXTURE_SET_BITS = 16, VERTEX_ARRAY_BITS = 12, DEPTH_BITS = 20;
+
+    // the top bits of a non-negative float sort like the float itself
+    uint64_t depthKey(float depth)
+    {
+        if (!(depth > 0.0f))
+            return 0;
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - 1 - DEPTH_BITS);
+    }
+}
+
+RenderQueue::RenderQueue() : programSwitches(0), textureBinds(0), vertexArrayBinds(0), sortMs(0.0)
+{
+    // set 0: no textures
+    textureSets.push_back(std::vector<TextureBinding>());
+}
+
+uint16_t RenderQueue::addTextureSet(const std::vector<TextureBinding>& bindings)
+{
+    textureSets.push_back(bindings);
+    return static_cast<uint16_t>(textureSets.size() - 1);
+}
+
+void RenderQueue::setTextureSet(uint16_t id, const std::vector<TextureBinding>& bindings)
+{
+    textureSets[id] = bindings;
+}
+
+void RenderQueue::begin()
+{
+    items.clear();
+    keys.clear();
+}
+
+void RenderQueue::submit(RenderPass pass, Shader* shader, uint16_t textureSet, unsigned int vertexArray, float depth,
+    DrawFunction draw, const void* context, uint32_t argument)
+{
+    uint64_t depthBits = depthKey(depth);
+    if (pass == RENDER_PASS_TRANSPARENT)
+        depthBits = ((uint64_t(1) << DEPTH_BITS) - 1) - depthBits;
+
+    SortKey sortKey;
+    sortKey.key = uint64_t(pass) << (PROGRAM_BITS + TEXTURE_SET_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS)
+        | uint64_t(shader->ID & ((1u << PROGRAM_BITS) - 1)) << (TEXTURE_SET_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS)
+        | uint64_t(textureSet) << (VERTEX_ARRAY_BITS + DEPTH_BITS)
+        | uint64_t(vertexArray & ((1u << VERTEX_ARRAY_BITS) - 1)) << DEPTH_BITS
+        | depthBits;
+    sortKey.item = static_cast<uint32_t>(items.size());
+    keys.push_back(sortKey);
+
+    Item item;
+    item.shader = shader;
+    item.textureSet = textureSet;
+    item.vertexArray = vertexArray;
+    item.draw = draw;
+    item.context = context;
+    item.argument = argument;
+    items.push_back(item);
+}
+
+// least significant digit first, 8 bits at a time; a byte every key shares (most of the
+// depth and program bytes in practice) is skipped without moving anything
+void RenderQueue::sortKeys()
+{
+    scratch.resize(keys.size());
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (const SortKey& sortKey : keys)
+            ++counts[(sortKey.key >> shift) & 0xff];
+        if (counts[(keys[0].key >> shift) & 0xff] == keys.size())
+            continue;
+
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const SortKey& sortKey : keys)
+            scratch[counts[(sortKey.key >> shift) & 0xff]++] = sortKey;
+        keys.swap(scratch);
+    }
+}
+
+void RenderQueue::execute()
+{
+    programSwitches = textureBinds = vertexArrayBinds = 0;
+    if (items.empty())
+        return;
+
+    auto sortStart = std::chrono::steady_clock::now();
+    sortKeys();
+    sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+
+    // the state cache drops whatever is already bound; the counts are what the sorted order
+    // still has to change
+    GLState& state = GLState::get();
+    const Shader* currentShader = NULL;
+    int currentTextureSet = -1;
+    unsigned int currentVertexArray = 0;
+    for (const SortKey& sortKey : keys)
+    {
+        const Item& item = items[sortKey.item];
+        if (item.shader != currentShader)
+        {
+            item.shader->use();
+            currentShader = item.shader;
+            ++programSwitches;
+        }
+        if (int(item.textureSet) != currentTextureSet)
+        {
+            for (const TextureBinding& binding : textureSets[item.textureSet])
+                state.bindTexture(binding.unit, binding.target, binding.texture);
+            textureBinds += textureSets[item.textureSet].size();
+            currentTextureSet = item.textureSet;
+        }
+        if (item.vertexArray != 0 && item.vertexArray != currentVertexArray)
+        {
+            state.bindVertexArray(item.vertexArray);
+            currentVertexArray = item.vertexArray;
+            ++vertexArrayBinds;
+        }
+        item.draw(item.context, item.argument);
+        if (item.vertexArray == 0)
+            currentVertexArray = 0;
+    }
+}
+
+void RenderQueue::drawStats()
+{
+    ImGui::Text("Render queue: %zu items, %zu programs, %zu texture binds, %zu VAO binds (sort %.3f ms)",
+        items.size(), programSwitches, textureBinds, vertexArrayBinds, sortMs);
+}
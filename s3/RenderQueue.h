@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <vector>
+
+// passes run in this order; within a pass items are grouped by state
+enum RenderPass {
+    RENDER_PASS_OPAQUE,         // front to back within a state group
+    RENDER_PASS_TRANSPARENT,    // back to front
+    RENDER_PASS_OVERLAY,
+    RENDER_PASS_COUNT
+};
+
+// A texture for one unit, as bound by a texture set
+struct TextureBinding
+{
+    unsigned int unit;
+    unsigned int target;        // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, ...
+    unsigned int texture;
+};
+
+// Draws of a frame, collected first and issued in state order. Each item is packed into a
+// 64-bit key, most significant first:
+//
+//   pass (4) | program (12) | texture set (16) | vertex array (12) | depth (20)
+//
+// and the keys are radix sorted, so items sharing a program, textures and vertex array end up
+// next to each other whatever order they were submitted in. execute() then only switches the
+// program, the textures and the vertex array when they differ from the last item's (through
+// GLState, which also skips what the previous frame left bound), and calls the item's draw
+// function with that state bound. The draw function sets its per-draw uniforms and issues
+// the draw.
+//
+// Vertex array 0 marks a draw function that binds its own (instanced batches over several
+// meshes); the queue binds none for it.
+//
+// Texture sets are registered once and referred to by id (0 is no textures). Depth is the
+// distance from the eye; its float bits are used directly, which keeps the order for
+// positive values.
+class RenderQueue
+{
+public:
+    typedef void (*DrawFunction)(const void* context, uint32_t argument);
+
+    RenderQueue();
+
+    uint16_t addTextureSet(const std::vector<TextureBinding>& bindings);
+    // replaces a set's textures (e.g. a regenerated texture array); cheap, can run every frame
+    void setTextureSet(uint16_t id, const std::vector<TextureBinding>& bindings);
+
+    // clears the items for a new frame
+    void begin();
+
+    // a plain function and its arguments, nothing allocated per item; the context must outlive execute()
+    void submit(RenderPass pass, Shader* shader, uint16_t textureSet, unsigned int vertexArray, float depth,
+        DrawFunction draw, const void* context, uint32_t argument = 0);
+
+    // sorts and draws everything submitted since begin()
+    void execute();
+
+    void drawStats();
+
+    size_t getItemCount() const { return items.size(); }
+    size_t getProgramSwitches() const { return programSwitches; }
+    size_t getTextureBinds() const { return textureBinds; }
+    size_t getVertexArrayBinds() const { return vertexArrayBinds; }
+
+private:
+    struct Item
+    {
+        Shader* shader;
+        uint16_t textureSet;
+        unsigned int vertexArray;
+        DrawFunction draw;
+        const void* context;
+        uint32_t argument;
+    };
+    struct SortKey
+    {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    void sortKeys();
+
+    std::vector<std::vector<TextureBinding>> textureSets;
+    std::vector<Item> items;
+    std::vector<SortKey> keys, scratch;
+
+    size_t programSwitches, textureBinds, vertexArrayBinds;
+    double sortMs;
+};
@@ -0,0 +1,169 @@
+#include "Scene.h"
+#include "GLState.h"
+#include "SceneGenerator.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+
+std::string Scene::bodyName(size_t index) const
+{
+    if (index == 0 && !bodies.empty() && bodies[0].emissive > 0.0f)
+        return "Star";
+    if (index < bodies.size() && bodies[index].parent >= 0)
+        return "Moon " + std::to_string(index) + " of " + bodyName(bodies[index].parent);
+    return "Body " + std::to_string(index);
+}
+
+void Scene::update(double days, ThreadPool& pool)
+{
+    positions.resize(bodies.size());
+
+    // heliocentric bodies first, then satellites on top of their (already placed) parents
+    pool.parallelFor(0, bodies.size(), [&](size_t i) {
+        const SceneBody& body = bodies[i];
+        if (body.parent >= 0)
+            return;
+        positions[i] = body.orbit.isValid() ? eclipticToScene(orbitalPosition(body.orbit, days)) : glm::vec3(0.0f);
+    });
+    pool.parallelFor(0, bodies.size(), [&](size_t i) {
+        const SceneBody& body = bodies[i];
+        if (body.parent < 0)
+            return;
+        glm::vec3 offset = body.orbit.isValid() ? eclipticToScene(orbitalPosition(body.orbit, days)) : glm::vec3(0.0f);
+        positions[i] = positions[body.parent] + offset;
+    });
+}
+
+bool Scene::save(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        std::cout << "ERROR::SCENE::FILE_NOT_WRITTEN: " << path << std::endl;
+        return false;
+    }
+
+    std::fprintf(file, "s3scene 1\n");
+    std::fprintf(file, "seed %" PRIu64 "\n", seed);
+    std::fprintf(file, "textures %zu\n", textures.size());
+    for (const SceneTexture& texture : textures)
+        std::fprintf(file, "texture %d %" PRIu64 "\n", texture.resolution, texture.seed);
+    std::fprintf(file, "bodies %zu\n", bodies.size());
+    // body parent radius r g b emissive texture a e i node peri M0 epoch mu
+    for (const SceneBody& b : bodies)
+    {
+        const OrbitalElements& o = b.orbit;
+        std::fprintf(file, "body %d %.9g %.6g %.6g %.6g %.6g %d %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n",
+            b.parent, b.radius, b.color.r, b.color.g, b.color.b, b.emissive, b.texture,
+            o.semiMajorAxis, o.eccentricity, o.inclination, o.longAscendingNode, o.argPeriapsis,
+            o.meanAnomalyAtEpoch, o.epoch, o.mu);
+    }
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!ok)
+        std::cout << "ERROR::SCENE::FILE_NOT_WRITTEN: " << path << std::endl;
+    return ok;
+}
+
+bool Scene::load(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file)
+    {
+        std::cout << "ERROR::SCENE::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+        return false;
+    }
+
+    Scene loaded;
+    int version = 0;
+    size_t count = 0;
+    bool ok = std::fscanf(file, " s3scene %d", &version) == 1 && version == 1 &&
+        std::fscanf(file, " seed %" SCNu64, &loaded.seed) == 1 &&
+        std::fscanf(file, " textures %zu", &count) == 1;
+
+    for (size_t i = 0; ok && i < count; ++i)
+    {
+        SceneTexture texture;
+        ok = std::fscanf(file, " texture %d %" SCNu64, &texture.resolution, &texture.seed) == 2;
+        loaded.textures.push_back(texture);
+    }
+
+    ok = ok && std::fscanf(file, " bodies %zu", &count) == 1;
+    if (ok)
+        loaded.bodies.reserve(count);
+    for (size_t i = 0; ok && i < count; ++i)
+    {
+        SceneBody b;
+        OrbitalElements& o = b.orbit;
+        ok = std::fscanf(file, " body %d %f %f %f %f %f %d %lf %lf %lf %lf %lf %lf %lf %lf",
+            &b.parent, &b.radius, &b.color.r, &b.color.g, &b.color.b, &b.emissive, &b.texture,
+            &o.semiMajorAxis, &o.eccentricity, &o.inclination, &o.longAscendingNode, &o.argPeriapsis,
+            &o.meanAnomalyAtEpoch, &o.epoch, &o.mu) == 15;
+        // a parent is a root body listed earlier (propagation is one level deep); a texture
+        // is -1 for none or an existing layer
+        ok = ok && (b.parent == -1 ||
+            (b.parent >= 0 && b.parent < (int)i && loaded.bodies[b.parent].parent < 0)) &&
+            b.texture >= -1 && b.texture < (int)loaded.textures.size();
+        loaded.bodies.push_back(b);
+    }
+    std::fclose(file);
+
+    if (!ok)
+    {
+        std::cout << "ERROR::SCENE::INVALID_FILE: " << path << std::endl;
+        return false;
+    }
+
+    releaseTextures();
+    *this = std::move(loaded);
+    return true;
+}
+
+void Scene::uploadTextures(ThreadPool& pool)
+{
+    releaseTextures();
+    if (textures.empty())
+        return;
+
+    int resolution = 2;
+    for (const SceneTexture& texture : textures)
+        resolution = std::max(resolution, texture.resolution);
+
+    std::vector<std::vector<unsigned char>> pixels(textures.size());
+    pool.parallelFor(0, textures.size(), [&](size_t i) {
+        SceneTexture layer = textures[i];
+        layer.resolution = resolution;
+        generateTexturePixels(layer, pixels[i]);
+    });
+
+    glGenTextures(1, &textureArray);
+    GLState::get().bindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    // generated colours are sRGB-encoded like the image files
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB8, resolution, resolution / 2, static_cast<GLsizei>(textures.size()),
+        0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), resolution, resolution / 2, 1,
+            GL_RGB, GL_UNSIGNED_BYTE, pixels[i].data());
+        std::vector<unsigned char>().swap(pixels[i]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void Scene::releaseTextures()
+{
+    if (textureArray != 0)
+        GLState::get().deleteTextures(1, &textureArray);
+    textureArray = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Orbit.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// scene units per astronomical unit
+const float SCENE_UNITS_PER_AU = 10.0f;
+
+// ecliptic (z = north) -> scene space (y up)
+inline glm::vec3 eclipticToScene(const glm::dvec3& ecliptic)
+{
+    return glm::vec3(ecliptic.x, ecliptic.z, -ecliptic.y) * SCENE_UNITS_PER_AU;
+}
+
+struct SceneBody
+{
+    int parent = -1;             // index of the body this one orbits, -1 for heliocentric
+    float radius = 0.05f;        // display radius in scene units
+    glm::vec3 color = glm::vec3(1.0f);
+    float emissive = 0.0f;       // > 0 for self-luminous bodies
+    int texture = -1;            // index into the scene's textures, -1 for untextured
+    OrbitalElements orbit;       // relative to the parent (AU, days)
+};
+
+// Procedural textures are stored by recipe, not by pixels, so scene files stay small
+// and every load regenerates exactly the same image.
+struct SceneTexture
+{
+    int resolution = 256;        // width; height is half (equirectangular)
+    uint64_t seed = 0;
+};
+
+// A loadable set of bodies. Parents always precede their children, so positions can be
+// resolved in one pass over heliocentric bodies followed by one over satellites.
+class Scene
+{
+public:
+    std::vector<SceneBody> bodies;
+    std::vector<SceneTexture> textures;
+    uint64_t seed = 0;
+    unsigned int textureArray = 0;   // GL_TEXTURE_2D_ARRAY, one layer per texture
+
+    // world-space positions after the last update()
+    std::vector<glm::vec3> positions;
+
+    size_t size() const { return bodies.size(); }
+    bool empty() const { return bodies.empty(); }
+    std::string bodyName(size_t index) const;
+
+    // propagates every body to the given time (days since J2000) on the worker pool
+    void update(double days, ThreadPool& pool);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // generates the procedural textures (in parallel) and uploads them as layers of one
+    // texture array so every body can be drawn in the same instanced call (GL thread).
+    // Layers share the largest resolution in the scene.
+    void uploadTextures(ThreadPool& pool);
+    void releaseTextures();
+};
@@ -0,0 +1,93 @@
+#include "SceneFramebuffer.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+
+SceneFramebuffer::SceneFramebuffer(int samples) :
+    requestedSamples(samples), samples(0), width(0), height(0),
+    FBO(0), colorRBO(0), depthRBO(0), resolveFBO(0), resolveTexture(0)
+{
+}
+
+SceneFramebuffer::~SceneFramebuffer()
+{
+    release();
+}
+
+void SceneFramebuffer::release()
+{
+    if (FBO == 0)
+        return;
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteRenderbuffers(1, &colorRBO);
+    glDeleteRenderbuffers(1, &depthRBO);
+    glDeleteFramebuffers(1, &resolveFBO);
+    GLState::get().deleteTextures(1, &resolveTexture);
+    FBO = colorRBO = depthRBO = resolveFBO = resolveTexture = 0;
+}
+
+void SceneFramebuffer::allocate(int newWidth, int newHeight)
+{
+    release();
+    width = newWidth;
+    height = newHeight;
+
+    int maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    samples = std::min(requestedSamples, maxSamples);
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glGenRenderbuffers(1, &colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA16F, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT32F, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER::SCENE_NOT_COMPLETE" << std::endl;
+
+    glGenTextures(1, &resolveTexture);
+    GLState::get().bindTexture(GL_TEXTURE_2D, resolveTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolveTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER::RESOLVE_NOT_COMPLETE" << std::endl;
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SceneFramebuffer::begin(int newWidth, int newHeight, float clearDepth)
+{
+    // minimised windows report 0 x 0
+    newWidth = std::max(newWidth, 1);
+    newHeight = std::max(newHeight, 1);
+    if (FBO == 0 || newWidth != width || newHeight != height)
+        allocate(newWidth, newHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, width, height);
+    glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+    glClearDepth(clearDepth);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void SceneFramebuffer::end()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
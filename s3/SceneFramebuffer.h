@@ -0,0 +1,32 @@
+#pragma once
+
+// Offscreen target for the 3D view. The window's framebuffer has a fixed-point depth
+// buffer (if any), which reversed-Z can't use, and 8-bit colour, which clips every emissive
+// body at white. The scene renders into a multisampled target with half-float colour and a
+// 32-bit float depth buffer instead; end() resolves the samples into a single-sampled
+// texture that PostProcess turns into the final image, with ImGui drawn on top.
+class SceneFramebuffer
+{
+public:
+    explicit SceneFramebuffer(int samples = 4);
+    ~SceneFramebuffer();
+
+    // (re)allocates for the window size, binds the target and clears it
+    void begin(int width, int height, float clearDepth);
+    // resolves into the texture (getTexture()) and binds the default framebuffer
+    void end();
+
+    int getSamples() const { return samples; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    unsigned int getTexture() const { return resolveTexture; }
+
+private:
+    void allocate(int newWidth, int newHeight);
+    void release();
+
+    int requestedSamples, samples;
+    int width, height;
+    unsigned int FBO, colorRBO, depthRBO;           // multisampled
+    unsigned int resolveFBO, resolveTexture;
+};
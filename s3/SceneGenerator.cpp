@@ -0,0 +1,202 @@
+#include "SceneGenerator.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+const double TWO_PI = 2.0 * 3.14159265358979323846;
+
+Scene generateScene(const SceneGeneratorSettings& settings)
+{
+    Scene scene;
+    scene.seed = settings.seed;
+
+    // every stream gets its own generator so changing one count doesn't reshuffle the others
+    Random textureRng(settings.seed * 0x9E3779B97F4A7C15ull + 1);
+    Random orbitRng(settings.seed * 0x9E3779B97F4A7C15ull + 2);
+    Random moonRng(settings.seed * 0x9E3779B97F4A7C15ull + 3);
+
+    const int textureCount = std::max(settings.textureCount, 0);
+    const int resolution = std::max(settings.textureResolution, 2) & ~1;
+    for (int i = 0; i < textureCount; ++i)
+    {
+        SceneTexture texture;
+        texture.resolution = resolution;
+        texture.seed = textureRng.next();
+        scene.textures.push_back(texture);
+    }
+
+    const size_t bodyCount = static_cast<size_t>(std::max(settings.bodyCount, 0));
+    const size_t moonCount = bodyCount * static_cast<size_t>(std::max(settings.moonsPerBody, 0));
+    scene.bodies.reserve(1 + bodyCount + moonCount);
+
+    // the star sits at the origin
+    SceneBody star;
+    star.radius = 0.5f;
+    star.color = glm::vec3(1.0f, 0.85f, 0.6f);
+    star.emissive = 1.0f;
+    scene.bodies.push_back(star);
+
+    const double minOrbit = std::max(0.01, (double)std::min(settings.minOrbit, settings.maxOrbit));
+    const double maxOrbit = std::max(minOrbit, (double)std::max(settings.minOrbit, settings.maxOrbit));
+    const double maxInclination = glm::radians((double)settings.maxInclination);
+    const double maxEccentricity = std::clamp((double)settings.maxEccentricity, 0.0, 0.95);
+
+    for (size_t i = 0; i < bodyCount; ++i)
+    {
+        SceneBody body;
+        OrbitalElements& o = body.orbit;
+        switch (settings.distribution)
+        {
+        case ORBITS_UNIFORM:
+            o.semiMajorAxis = orbitRng.uniform(minOrbit, maxOrbit);
+            break;
+        case ORBITS_LOG_UNIFORM:
+            o.semiMajorAxis = minOrbit * std::pow(maxOrbit / minOrbit, orbitRng.uniform());
+            break;
+        case ORBITS_BELT:
+            o.semiMajorAxis = std::clamp(0.5 * (minOrbit + maxOrbit) + orbitRng.normal() * 0.1 * (maxOrbit - minOrbit),
+                minOrbit, maxOrbit);
+            break;
+        }
+        o.eccentricity = maxEccentricity * orbitRng.uniform();
+        o.inclination = maxInclination * orbitRng.uniform();
+        o.longAscendingNode = orbitRng.uniform(0.0, TWO_PI);
+        o.argPeriapsis = orbitRng.uniform(0.0, TWO_PI);
+        o.meanAnomalyAtEpoch = orbitRng.uniform(0.0, TWO_PI);
+
+        body.radius = static_cast<float>(0.02 * std::pow(10.0, orbitRng.uniform()));
+        body.color = glm::vec3(orbitRng.uniform(0.4, 1.0), orbitRng.uniform(0.4, 1.0), orbitRng.uniform(0.4, 1.0));
+        body.texture = textureCount > 0 ? static_cast<int>(orbitRng.below(textureCount)) : -1;
+        scene.bodies.push_back(body);
+    }
+
+    // moons after all of their parents, in parent order
+    for (size_t i = 0; i < bodyCount && settings.moonsPerBody > 0; ++i)
+    {
+        const int parent = static_cast<int>(1 + i);
+        const float parentRadius = scene.bodies[parent].radius;
+        for (int m = 0; m < settings.moonsPerBody; ++m)
+        {
+            SceneBody moon;
+            moon.parent = parent;
+            OrbitalElements& o = moon.orbit;
+            // outside the parent's display radius, a few hundred days or less per revolution
+            o.semiMajorAxis = parentRadius / SCENE_UNITS_PER_AU * moonRng.uniform(2.0, 2.0 + 1.5 * settings.moonsPerBody);
+            o.eccentricity = 0.05 * moonRng.uniform();
+            o.inclination = maxInclination * moonRng.uniform();
+            o.longAscendingNode = moonRng.uniform(0.0, TWO_PI);
+            o.argPeriapsis = moonRng.uniform(0.0, TWO_PI);
+            o.meanAnomalyAtEpoch = moonRng.uniform(0.0, TWO_PI);
+            o.mu = SUN_MU * std::pow(10.0, moonRng.uniform(-7.0, -3.0));
+
+            moon.radius = parentRadius * static_cast<float>(moonRng.uniform(0.1, 0.35));
+            float grey = static_cast<float>(moonRng.uniform(0.5, 0.9));
+            moon.color = glm::vec3(grey);
+            moon.texture = textureCount > 0 ? static_cast<int>(moonRng.below(textureCount)) : -1;
+            scene.bodies.push_back(moon);
+        }
+    }
+
+    return scene;
+}
+
+// integer lattice hash -> [0, 1)
+static float latticeValue(uint64_t seed, int x, int y)
+{
+    uint64_t h = seed ^ (static_cast<uint64_t>(static_cast<uint32_t>(x)) * 0x9E3779B97F4A7C15ull) ^
+        (static_cast<uint64_t>(static_cast<uint32_t>(y)) * 0xC2B2AE3D27D4EB4Full);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return static_cast<float>(h >> 40) * (1.0f / 16777216.0f);
+}
+
+// smooth value noise that wraps horizontally every `period` lattice cells
+static float valueNoise(uint64_t seed, float x, float y, int period)
+{
+    int x0 = static_cast<int>(std::floor(x)), y0 = static_cast<int>(std::floor(y));
+    float fx = x - x0, fy = y - y0;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    int xa = ((x0 % period) + period) % period, xb = (xa + 1) % period;
+    float a = latticeValue(seed, xa, y0), b = latticeValue(seed, xb, y0);
+    float c = latticeValue(seed, xa, y0 + 1), d = latticeValue(seed, xb, y0 + 1);
+    return (a + (b - a) * fx) * (1.0f - fy) + (c + (d - c) * fx) * fy;
+}
+
+void generateTexturePixels(const SceneTexture& texture, std::vector<unsigned char>& rgb)
+{
+    const int width = std::max(texture.resolution, 2);
+    const int height = width / 2;
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+
+    Random rng(texture.seed);
+    const bool banded = (rng.next() & 1) != 0;   // gas giant or rocky
+    const glm::vec3 dark(rng.uniform(0.1, 0.5), rng.uniform(0.1, 0.5), rng.uniform(0.1, 0.5));
+    const glm::vec3 light(rng.uniform(0.5, 1.0), rng.uniform(0.5, 1.0), rng.uniform(0.5, 1.0));
+    const uint64_t noiseSeed = rng.next();
+
+    const int baseCells = 8;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            float u = static_cast<float>(x) / width, v = static_cast<float>(y) / height;
+            float value = 0.0f, amplitude = 0.5f;
+            int cells = baseCells;
+            for (int octave = 0; octave < 5; ++octave)
+            {
+                value += amplitude * valueNoise(noiseSeed + octave, u * cells, v * cells * 0.5f, cells);
+                amplitude *= 0.5f;
+                cells *= 2;
+            }
+            if (banded)
+                value = 0.5f + 0.5f * std::sin(v * 40.0f + value * 6.0f);
+
+            glm::vec3 color = dark + (light - dark) * value;
+            unsigned char* p = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+            p[0] = static_cast<unsigned char>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f);
+            p[1] = static_cast<unsigned char>(std::clamp(color.g, 0.0f, 1.0f) * 255.0f);
+            p[2] = static_cast<unsigned char>(std::clamp(color.b, 0.0f, 1.0f) * 255.0f);
+        }
+    }
+}
+
+void benchmarkScenes(const SceneGeneratorSettings& settings, ThreadPool& pool)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    const int counts[] = { 10, 1000, 100000, 1000000 };
+    const std::string path = "scene_benchmark.s3scene";
+
+    std::printf("%10s %10s %12s %12s %12s %12s\n", "bodies", "total", "generate ms", "save ms", "load ms", "update ms");
+    for (int count : counts)
+    {
+        SceneGeneratorSettings requested = settings;
+        requested.bodyCount = count;
+
+        auto t0 = Clock::now();
+        Scene scene = generateScene(requested);
+        auto t1 = Clock::now();
+        scene.save(path);
+        auto t2 = Clock::now();
+        Scene loaded;
+        loaded.load(path);
+        auto t3 = Clock::now();
+        // average over a few frames' worth of propagation
+        const int frames = 10;
+        for (int frame = 0; frame < frames; ++frame)
+            loaded.update(frame * 0.5, pool);
+        auto t4 = Clock::now();
+
+        std::printf("%10d %10zu %12.2f %12.2f %12.2f %12.3f\n", count, loaded.size(),
+            ms(t0, t1), ms(t1, t2), ms(t2, t3), ms(t3, t4) / frames);
+    }
+    std::remove(path.c_str());
+}
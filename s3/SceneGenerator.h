@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Scene.h"
+
+#include <cstdint>
+#include <vector>
+
+enum OrbitDistribution {
+    ORBITS_UNIFORM,       // semi-major axis uniform between min and max
+    ORBITS_LOG_UNIFORM,   // evenly spaced in log(a), like a planetary system
+    ORBITS_BELT           // clustered around the middle of the range, like an asteroid belt
+};
+
+struct SceneGeneratorSettings
+{
+    uint64_t seed = 1;
+    int bodyCount = 1000;        // heliocentric bodies, not counting the star or moons
+    int moonsPerBody = 0;
+    int textureCount = 8;
+    int textureResolution = 256;
+    OrbitDistribution distribution = ORBITS_LOG_UNIFORM;
+    float minOrbit = 0.3f;       // AU
+    float maxOrbit = 40.0f;      // AU
+    float maxEccentricity = 0.1f;
+    float maxInclination = 5.0f; // degrees
+};
+
+// Deterministic stress-scene generator: the same settings always produce the same scene,
+// on any platform, so scaling runs at 10, 1k, 100k or 1M bodies are reproducible.
+Scene generateScene(const SceneGeneratorSettings& settings);
+
+// fills rgb with the procedural texture for the given recipe (width x width/2 pixels)
+void generateTexturePixels(const SceneTexture& texture, std::vector<unsigned char>& rgb);
+
+// generates, saves, reloads and propagates scenes of 10, 1k, 100k and 1M bodies with the
+// given settings and prints the timings to stdout
+void benchmarkScenes(const SceneGeneratorSettings& settings, ThreadPool& pool);
@@ -0,0 +1,118 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Registry of linked programs. A program is identified by its source paths, a hash of the
+// source text and the preprocessor defines it was built with, so asking for the same
+// combination twice returns the same shared program instead of compiling it again, while
+// an edited file (different hash) or a different define set gets its own program.
+class ShaderCache
+{
+public:
+    ShaderCache() : requests(0), compiles(0) {}
+
+    // returns the program for the pair, compiling it on first use; defines are injected
+    // as "#define NAME" (or "#define NAME VALUE" for "NAME VALUE") after the #version line
+    std::shared_ptr<Shader> get(const std::string& vertexPath, const std::string& fragmentPath,
+        const std::vector<std::string>& defines = std::vector<std::string>())
+    {
+        ++requests;
+        std::string vertexCode = Shader::readFile(vertexPath.c_str());
+        std::string fragmentCode = Shader::readFile(fragmentPath.c_str());
+
+        std::string definesKey;
+        for (const std::string& define : defines)
+            definesKey += define + ";";
+        uint64_t hash = hashSource(vertexCode, hashSource(fragmentCode, hashSource(definesKey)));
+
+        Key key = { vertexPath, fragmentPath, definesKey, hash };
+        auto found = programs.find(key);
+        if (found != programs.end())
+            return found->second;
+
+        std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+        shader->build(injectDefines(vertexCode, defines), injectDefines(fragmentCode, defines));
+        programs[key] = shader;
+        ++compiles;
+        return shader;
+    }
+
+    // deletes every program; handles still held elsewhere become invalid
+    void clear()
+    {
+        for (auto& entry : programs)
+            GLState::get().deleteProgram(entry.second->ID);
+        programs.clear();
+    }
+
+    size_t programCount() const { return programs.size(); }
+    size_t requestCount() const { return requests; }
+    size_t compileCount() const { return compiles; }
+
+private:
+    struct Key
+    {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::string defines;
+        uint64_t hash;
+
+        bool operator<(const Key& other) const
+        {
+            if (hash != other.hash) return hash < other.hash;
+            if (vertexPath != other.vertexPath) return vertexPath < other.vertexPath;
+            if (fragmentPath != other.fragmentPath) return fragmentPath < other.fragmentPath;
+            return defines < other.defines;
+        }
+    };
+
+    // 64-bit FNV-1a
+    static uint64_t hashSource(const std::string& text, uint64_t hash = 14695981039346656037ull)
+    {
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static std::string injectDefines(const std::string& code, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+            return code;
+        std::string block;
+        for (const std::string& define : defines)
+            block += "#define " + define + "\n";
+        // #version has to stay the first statement
+        size_t insertAt = 0;
+        size_t version = code.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = code.find('\n', version);
+            if (lineEnd == std::string::npos)
+            {
+                insertAt = code.size();
+                block = "\n" + block;
+            }
+            else
+                insertAt = lineEnd + 1;
+        }
+        std::string result = code;
+        result.insert(insertAt, block);
+        return result;
+    }
+
+    std::map<Key, std::shared_ptr<Shader>> programs;
+    size_t requests;
+    size_t compiles;
+};
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,312 @@
+#include "SkyView.h"
+#include "GLState.h"
+#include "Random.h"
+
+#include "imgui.h"
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SKY_USE_SSE
+#endif
+
+const double ARCSEC = glm::pi<double>() / (180.0 * 3600.0);
+const double OBLIQUITY_J2000_RAD = glm::radians(23.4392911);
+
+// rotation matrices in the astronomical (frame rotation) convention, built from rows
+static glm::dmat3 fromRows(double a, double b, double c, double d, double e, double f, double g, double h, double i)
+{
+    return glm::transpose(glm::dmat3(a, b, c, d, e, f, g, h, i));
+}
+
+static glm::dmat3 rotateX(double angle)
+{
+    double c = std::cos(angle), s = std::sin(angle);
+    return fromRows(1, 0, 0, 0, c, s, 0, -s, c);
+}
+
+static glm::dmat3 rotateY(double angle)
+{
+    double c = std::cos(angle), s = std::sin(angle);
+    return fromRows(c, 0, -s, 0, 1, 0, s, 0, c);
+}
+
+static glm::dmat3 rotateZ(double angle)
+{
+    double c = std::cos(angle), s = std::sin(angle);
+    return fromRows(c, s, 0, -s, c, 0, 0, 0, 1);
+}
+
+void transformDirections(const float m[9], const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t n)
+{
+    size_t i = 0;
+#ifdef SKY_USE_SSE
+    const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+    const __m128 m3 = _mm_set1_ps(m[3]), m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]);
+    const __m128 m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]), m8 = _mm_set1_ps(m[8]);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        _mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, vx), _mm_mul_ps(m1, vy)), _mm_mul_ps(m2, vz)));
+        _mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, vx), _mm_mul_ps(m4, vy)), _mm_mul_ps(m5, vz)));
+        _mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m6, vx), _mm_mul_ps(m7, vy)), _mm_mul_ps(m8, vz)));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = m[0] * vx + m[1] * vy + m[2] * vz;
+        outY[i] = m[3] * vx + m[4] * vy + m[5] * vz;
+        outZ[i] = m[6] * vx + m[7] * vy + m[8] * vz;
+    }
+}
+
+SkyView::SkyView(ThreadPool& pool) :
+    days(0.0), pool(pool), active(false), precessionDays(-1e9),
+    shader(NULL), VAO(0), styleVBO(0), styleDirty(true),
+    transformMs(0.0), propagateMs(0.0)
+{
+}
+
+SkyView::~SkyView()
+{
+    delete shader;
+    if (VAO != 0)
+    {
+        GLState::get().deleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &styleVBO);
+    }
+}
+
+void SkyView::setBodies(const std::vector<OrbitalElements>& orbits)
+{
+    bodyOrbits = orbits;
+    bodyX.assign(orbits.size(), 0.0f);
+    bodyY.assign(orbits.size(), 0.0f);
+    bodyZ.assign(orbits.size(), 0.0f);
+    styleDirty = true;
+}
+
+void SkyView::generateStars(int count, uint64_t seed)
+{
+    StarCatalog catalog;
+    catalog.generateRandom(static_cast<size_t>(std::max(count, 0)), seed);
+    starX.assign(catalog.x.begin(), catalog.x.end());
+    starY.assign(catalog.y.begin(), catalog.y.end());
+    starZ.assign(catalog.z.begin(), catalog.z.end());
+    starMagnitude = catalog.magnitude;
+    styleDirty = true;
+}
+
+void SkyView::updateFrame()
+{
+    frame.days = days;
+    const double T = days / 36525.0;
+
+    // IAU 1976 precession and the two largest nutation terms (good to about an arcsecond)
+    if (std::abs(days - precessionDays) > 0.01)
+    {
+        double zeta = (2306.2181 * T + 0.30188 * T * T + 0.017998 * T * T * T) * ARCSEC;
+        double z = (2306.2181 * T + 1.09468 * T * T + 0.018203 * T * T * T) * ARCSEC;
+        double theta = (2004.3109 * T - 0.42665 * T * T - 0.041833 * T * T * T) * ARCSEC;
+        frame.precession = rotateZ(-z) * rotateY(theta) * rotateZ(-zeta);
+
+        double node = glm::radians(125.04452 - 1934.136261 * T);
+        double sunLongitude = glm::radians(280.4665 + 36000.7698 * T);
+        double moonLongitude = glm::radians(218.3165 + 481267.8813 * T);
+        double dPsi = (-17.20 * std::sin(node) - 1.32 * std::sin(2.0 * sunLongitude) -
+            0.23 * std::sin(2.0 * moonLongitude) + 0.21 * std::sin(2.0 * node)) * ARCSEC;
+        double dEps = (9.20 * std::cos(node) + 0.57 * std::cos(2.0 * sunLongitude) +
+            0.10 * std::cos(2.0 * moonLongitude) - 0.09 * std::cos(2.0 * node)) * ARCSEC;
+        double meanObliquity = OBLIQUITY_J2000_RAD - 46.8150 * T * ARCSEC;
+        frame.nutation = rotateX(-(meanObliquity + dEps)) * rotateZ(-dPsi) * rotateX(meanObliquity);
+        frame.nutationLongitude = dPsi;
+        frame.trueObliquity = meanObliquity + dEps;
+        precessionDays = days;
+    }
+
+    // apparent sidereal time at the observer
+    double gmst = 280.46061837 + 360.98564736629 * days + 0.000387933 * T * T;
+    double last = glm::radians(gmst + settings.longitude) + frame.nutationLongitude * std::cos(frame.trueObliquity);
+    frame.localSiderealTime = std::fmod(last, 2.0 * glm::pi<double>());
+    if (frame.localSiderealTime < 0.0)
+        frame.localSiderealTime += 2.0 * glm::pi<double>();
+
+    // true equator of date -> (south, east, zenith) -> scene axes (east, zenith, south)
+    const glm::dmat3 toScene = fromRows(0, 1, 0, 0, 0, 1, 1, 0, 0);
+    glm::dmat3 horizontal = toScene * rotateY(glm::radians(90.0 - settings.latitude)) * rotateZ(frame.localSiderealTime);
+    frame.equatorialToSky = horizontal * frame.nutation * frame.precession;
+    frame.eclipticToSky = frame.equatorialToSky * rotateX(-OBLIQUITY_J2000_RAD);
+}
+
+void SkyView::update(float deltaSeconds, const OrbitalElements& earth)
+{
+    if (!active)
+        return;
+    days += deltaSeconds * settings.timeRate / 86400.0;
+    updateFrame();
+
+    auto start = std::chrono::steady_clock::now();
+
+    // geocentric directions of the bodies (one Kepler solve each)
+    const glm::dvec3 earthPosition = orbitalPosition(earth, days);
+    pool.parallelFor(0, bodyOrbits.size(), [&](size_t i) {
+        const OrbitalElements& orbit = bodyOrbits[i];
+        glm::dvec3 heliocentric = orbit.isValid() ? orbitalPosition(orbit, days) : glm::dvec3(0.0);
+        glm::dvec3 geocentric = heliocentric - earthPosition;
+        double distance = glm::length(geocentric);
+        // the observer's own planet has no direction
+        glm::dvec3 direction = distance > 1e-9 ? geocentric / distance : glm::dvec3(0.0);
+        bodyX[i] = static_cast<float>(direction.x);
+        bodyY[i] = static_cast<float>(direction.y);
+        bodyZ[i] = static_cast<float>(direction.z);
+    }, 1024);
+
+    auto propagated = std::chrono::steady_clock::now();
+
+    const size_t stars = starX.size();
+    const size_t total = stars + bodyOrbits.size();
+    skyX.resize(total);
+    skyY.resize(total);
+    skyZ.resize(total);
+
+    float equatorial[9], ecliptic[9];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            equatorial[r * 3 + c] = static_cast<float>(frame.equatorialToSky[c][r]);
+            ecliptic[r * 3 + c] = static_cast<float>(frame.eclipticToSky[c][r]);
+        }
+    }
+
+    // one matrix pass per source, in blocks so the pool can share the work
+    const size_t block = 16384;
+    const size_t starBlocks = (stars + block - 1) / block;
+    const size_t bodyBlocks = (bodyOrbits.size() + block - 1) / block;
+    pool.parallelFor(0, starBlocks + bodyBlocks, [&](size_t b) {
+        if (b < starBlocks)
+        {
+            size_t first = b * block, count = std::min(block, stars - first);
+            transformDirections(equatorial, &starX[first], &starY[first], &starZ[first],
+                &skyX[first], &skyY[first], &skyZ[first], count);
+        }
+        else
+        {
+            size_t first = (b - starBlocks) * block, count = std::min(block, bodyOrbits.size() - first);
+            transformDirections(ecliptic, &bodyX[first], &bodyY[first], &bodyZ[first],
+                &skyX[stars + first], &skyY[stars + first], &skyZ[stars + first], count);
+        }
+    });
+
+    auto end = std::chrono::steady_clock::now();
+    propagateMs = std::chrono::duration<double, std::milli>(propagated - start).count();
+    transformMs = std::chrono::duration<double, std::milli>(end - propagated).count();
+}
+
+void SkyView::altAz(size_t i, double& altitude, double& azimuth) const
+{
+    altitude = std::asin(std::clamp((double)skyY[i], -1.0, 1.0));
+    azimuth = std::atan2((double)skyX[i], -(double)skyZ[i]);
+    if (azimuth < 0.0)
+        azimuth += 2.0 * glm::pi<double>();
+}
+
+void SkyView::render(StreamBuffer& stream, const glm::mat4& projection, const glm::vec3& front, const glm::vec3& up)
+{
+    if (!active || skyX.empty())
+        return;
+
+    if (shader == NULL)
+        shader = new Shader("shaders/sky.vs", "shaders/sky.fs");
+    if (VAO == 0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &styleVBO);
+    }
+
+    const size_t count = skyX.size();
+    const size_t bytes = count * sizeof(float);
+    GLState::get().bindVertexArray(VAO);
+
+    // colour and magnitude only change with the object set
+    if (styleDirty)
+    {
+        std::vector<float> style;
+        style.reserve(count * 4);
+        for (size_t i = 0; i < starX.size(); ++i)
+        {
+            float tint = 0.85f + 0.15f * static_cast<float>(i % 7) / 6.0f;
+            style.insert(style.end(), { tint, tint, 1.0f, starMagnitude[i] });
+        }
+        for (size_t i = 0; i < bodyOrbits.size(); ++i)
+            style.insert(style.end(), { 1.0f, 0.85f, 0.5f, -2.0f });
+        glBindBuffer(GL_ARRAY_BUFFER, styleVBO);
+        glBufferData(GL_ARRAY_BUFFER, style.size() * sizeof(float), style.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(3);
+        styleDirty = false;
+    }
+
+    // directions stay SoA: one attribute per component from consecutive ranges of one
+    // allocation; a frame that doesn't fit is skipped while the stream grows
+    StreamBuffer::Allocation directions = stream.allocate(3 * bytes);
+    if (!directions.pointer)
+        return;
+    unsigned char* target = static_cast<unsigned char*>(directions.pointer);
+    std::memcpy(target, skyX.data(), bytes);
+    std::memcpy(target + bytes, skyY.data(), bytes);
+    std::memcpy(target + 2 * bytes, skyZ.data(), bytes);
+    stream.commit(directions);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+    for (int c = 0; c < 3; ++c)
+    {
+        glVertexAttribPointer(c, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(directions.offset + c * bytes));
+        glEnableVertexAttribArray(c);
+    }
+
+    // the observer sits at the origin of the sky, only the camera's orientation matters
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), front, up);
+    shader->use();
+    shader->setMat4("view", view);
+    shader->setMat4("projection", projection);
+    shader->setFloat("magnitudeLimit", settings.magnitudeLimit);
+
+    GLState::get().disable(GL_DEPTH_TEST);
+    GLState::get().enable(GL_PROGRAM_POINT_SIZE);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+    GLState::get().disable(GL_PROGRAM_POINT_SIZE);
+    GLState::get().enable(GL_DEPTH_TEST);
+}
+
+void SkyView::drawPanel()
+{
+    ImGui::Begin("Sky View");
+
+    ImGui::Checkbox("View from surface", &active);
+    ImGui::SliderFloat("Latitude", &settings.latitude, -90.0f, 90.0f);
+    ImGui::SliderFloat("Longitude", &settings.longitude, -180.0f, 180.0f);
+    float date = static_cast<float>(days);
+    if (ImGui::InputFloat("Date (J2000 days)", &date, 1.0f, 30.0f, "%.4f"))
+        days = date;
+    ImGui::SliderFloat("Time rate", &settings.timeRate, 0.0f, 86400.0f, "%.0fx", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderFloat("Magnitude limit", &settings.magnitudeLimit, 0.0f, 20.0f);
+    ImGui::InputInt("Stars", &settings.starCount, 10000, 100000);
+    ImGui::InputInt("Seed", &settings.seed);
+    settings.starCount = std::max(settings.starCount, 0);
+    if (ImGui::Button("Generate stars"))
+        generateStars(settings.starCount, static_cast<uint64_t>(settings.seed));
+
+    ImGui::Text("%zu objects (%zu stars, %zu bodies)", objectCount(), starX.size(), bodyOrbits.size());
+    ImGui::Text("Local sidereal time %.4f h", glm::degrees(frame.localSiderealTime) / 15.0);
+    ImGui::Text("Propagate %.3f ms, transform %.3f ms", propagateMs, transformMs);
+
+    ImGui::End();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Orbit.h"
+#include "Shader.h"
+#include "StarCatalog.h"
+#include "StreamBuffer.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+struct SkyViewSettings
+{
+    float latitude = 51.48f;     // degrees, north positive
+    float longitude = 0.0f;      // degrees, east positive
+    float timeRate = 600.0f;     // simulated seconds per real second
+    int starCount = 100000;
+    int seed = 1;
+    float magnitudeLimit = 18.0f;
+};
+
+// Matrices shared by every object in a frame. Precession and nutation only change
+// noticeably over hours, so they are rebuilt when the date moves; sidereal time and
+// the horizon rotation are rebuilt every frame.
+struct SkyFrame
+{
+    double days = 0.0;            // since J2000
+    glm::dmat3 precession;        // J2000 equator -> mean equator of date
+    glm::dmat3 nutation;          // mean -> true equator of date
+    double nutationLongitude = 0.0;
+    double trueObliquity = 0.0;
+    double localSiderealTime = 0.0;
+    glm::dmat3 equatorialToSky;   // J2000 equatorial -> sky (x east, y up, z south)
+    glm::dmat3 eclipticToSky;     // J2000 ecliptic -> sky
+};
+
+// Sky as seen from a point on Earth's surface. Stars (J2000 equatorial) and bodies
+// (heliocentric ecliptic orbits, seen from Earth's centre) are stored as SoA unit vectors
+// and pushed through a single combined 3x3 matrix per frame, four at a time with SSE.
+// The output directions are in scene axes (east = +x, zenith = +y, north = -z).
+class SkyView
+{
+public:
+    explicit SkyView(ThreadPool& pool);
+    ~SkyView();
+
+    void setBodies(const std::vector<OrbitalElements>& orbits);
+    void generateStars(int count, uint64_t seed);
+
+    // advances the clock and transforms every object (worker pool)
+    void update(float deltaSeconds, const OrbitalElements& earth);
+    // draws the sky as points for a camera at the observer looking along front; the frame's
+    // directions are written into the stream buffer
+    void render(StreamBuffer& stream, const glm::mat4& projection, const glm::vec3& front, const glm::vec3& up);
+    void drawPanel();
+
+    bool isActive() const { return active; }
+    void setActive(bool value) { active = value; }
+    size_t objectCount() const { return starX.size() + bodyOrbits.size(); }
+    const SkyFrame& getFrame() const { return frame; }
+
+    // altitude/azimuth (radians, azimuth from north through east) of object i after update()
+    void altAz(size_t i, double& altitude, double& azimuth) const;
+
+    double days;   // since J2000, UT
+
+private:
+    void updateFrame();
+
+    ThreadPool& pool;
+    SkyViewSettings settings;
+    SkyFrame frame;
+    bool active;
+    double precessionDays;   // date the cached precession/nutation belong to
+
+    // inputs: stars first, then bodies (float SoA so the transform runs four lanes wide)
+    std::vector<float> starX, starY, starZ;
+    std::vector<float> starMagnitude;
+    std::vector<OrbitalElements> bodyOrbits;
+    std::vector<float> bodyX, bodyY, bodyZ;
+
+    // outputs, stars then bodies
+    std::vector<float> skyX, skyY, skyZ;
+
+    Shader* shader;
+    unsigned int VAO, styleVBO;
+    bool styleDirty;
+    double transformMs;
+    double propagateMs;
+};
+
+// out = m * in for n SoA vectors; m is row-major 3x3
+void transformDirections(const float m[9], const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t n);
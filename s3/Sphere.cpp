@@ -3,6 +3,7 @@
 #include <cmath>
 #include <vector>
 #include "Sphere.h"
+#include "GLState.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -28,15 +29,14 @@ Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, int up) :
 // Destructor
 Sphere::~Sphere() {
     // Clean up buffers
-    glDeleteVertexArrays(1, &VAO);
+    GLState::get().deleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 }
 
 void Sphere::draw() const {
-    glBindVertexArray(VAO);
+    GLState::get().bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 void Sphere::buildVerticesSmooth() {
@@ -118,8 +118,8 @@ void Sphere::buildVerticesSmooth() {
 
 void Sphere::set(float radius, int sectorCount, int stackCount, bool smooth, int up) {
     this->radius = radius;
-    this->sectorCount = sectorCount;
-    this->stackCount = stackCount;
+    this->sectorCount = sectorCount < MIN_SECTOR_COUNT ? MIN_SECTOR_COUNT : sectorCount;
+    this->stackCount = stackCount < MIN_STACK_COUNT ? MIN_STACK_COUNT : stackCount;
     this->smooth = smooth;
     this->up = up;
 
@@ -146,11 +146,14 @@ void Sphere::buildInterleavedVertices() {
 }
 
 void Sphere::setupSphere() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    // reuse the buffers on rebuilds instead of leaking a new set each time
+    if (VAO == 0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
 
-    glBindVertexArray(VAO);
+    GLState::get().bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, interleavedVertices.size() * sizeof(float), &interleavedVertices[0], GL_STATIC_DRAW);
@@ -170,7 +173,7 @@ void Sphere::setupSphere() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    GLState::get().bindVertexArray(0);
 }
 
 void Sphere::addVertex(float x, float y, float z) {
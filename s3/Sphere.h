@@ -15,6 +15,10 @@ public:
     int getStackCount() const { return stackCount; }
     bool isSmooth() const { return smooth; }
     int getUp() const { return up; }
+    unsigned int getVAO() const { return VAO; }
+    unsigned int getIndexCount() const { return static_cast<unsigned int>(indices.size()); }
+    const std::vector<float>& getVertices() const { return vertices; }
+    const std::vector<unsigned int>& getIndices() const { return indices; }
 
     // Setters
     void set(float radius, int sectorCount, int stackCount, bool smooth = true, int up = 3);
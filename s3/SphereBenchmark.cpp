@@ -0,0 +1,178 @@
+#include "SphereBenchmark.h"
+#include "CubeSphere.h"
+#include "GLState.h"
+#include "Icosphere.h"
+#include "Sphere.h"
+#include "VertexCache.h"
+
+#include <glad/glad.h>
+#include <gtc/matrix_transform.hpp>
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+    // GPU time of drawing the mesh `instances` times; best of three after a warm-up draw
+    template <class Mesh>
+    double timeDraws(const Mesh& mesh, int instances)
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        mesh.draw();
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            // depth is cleared so every run rasterises the same way
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            for (int i = 0; i < instances; ++i)
+                mesh.draw();
+            glEndQuery(GL_TIME_ELAPSED);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            best = std::min(best, nanoseconds * 1e-6);
+        }
+        glDeleteQueries(1, &query);
+        return best;
+    }
+
+    std::vector<glm::vec3> unitPositions(const Sphere& sphere)
+    {
+        const std::vector<float>& vertices = sphere.getVertices();
+        std::vector<glm::vec3> positions(vertices.size() / 3);
+        for (size_t i = 0; i < positions.size(); ++i)
+            positions[i] = glm::vec3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]) / sphere.getRadius();
+        return positions;
+    }
+}
+
+SphereBenchmark::SphereBenchmark() :
+    tolerance(0.5f), pixelRadius(300.0f), instances(500), cacheSize(16), pending(false)
+{
+}
+
+void SphereBenchmark::run(const Shader& shader, const glm::vec3& eye, const glm::vec3& front,
+    float projectionScale, float viewportHeight)
+{
+    pending = false;
+    results.clear();
+
+    const float PI = acos(-1.0f);
+    const float targetError = tolerance / pixelRadius;     // relative to the radius
+
+    // a unit sphere straight ahead, far enough away to cover pixelRadius
+    float distance = projectionScale * 0.5f * viewportHeight / pixelRadius;
+    shader.use();
+    shader.setMat4("model", glm::translate(glm::mat4(1.0f), eye + glm::normalize(front) * distance));
+    shader.setVec3("emissiveColor", glm::vec3(1.0f));
+    GLState::get().enable(GL_DEPTH_TEST);
+
+    auto addResult = [&](const std::string& name, int detail, const std::vector<glm::vec3>& positions,
+        const std::vector<unsigned int>& indices, size_t indexSize, double gpuMs) {
+        SphereBenchmarkResult result;
+        result.name = name;
+        result.detail = detail;
+        result.vertices = positions.size();
+        result.triangles = indices.size() / 3;
+        result.errorPixels = sphereMeshError(positions, indices) * pixelRadius;
+        result.acmr = computeACMR(indices, positions.size(), cacheSize);
+        result.hitRate = 1.0f - result.acmr / 3.0f;
+        result.indexBytes = indices.size() * indexSize;
+        result.gpuMs = gpuMs;
+        results.push_back(result);
+    };
+
+    // UV sphere: start from the chord error estimate 1 - cos(pi / sectors), then refine
+    // until the measured error (larger, in the middle of the quads) is met
+    int sectors = std::max(8, static_cast<int>(std::ceil(PI / std::acos(1.0f - targetError))));
+    std::unique_ptr<Sphere> uvSphere;
+    for (;;)
+    {
+        sectors += sectors & 1;
+        uvSphere.reset(new Sphere(1.0f, sectors, sectors / 2));
+        if (sectors >= 1024 || sphereMeshError(unitPositions(*uvSphere), uvSphere->getIndices()) <= targetError)
+            break;
+        sectors += std::max(2, sectors / 16);
+    }
+    addResult("UV sphere", sectors, unitPositions(*uvSphere), uvSphere->getIndices(), sizeof(unsigned int),
+        timeDraws(*uvSphere, instances));
+    uvSphere.reset();
+
+    int subdivisions = 0;
+    std::unique_ptr<Icosphere> icosphere(new Icosphere(1.0f, subdivisions));
+    while (subdivisions < 8 && sphereMeshError(icosphere->getPositions(), icosphere->getIndices()) > targetError)
+        icosphere->setSubdivisionCount(++subdivisions);
+    for (bool optimized : { false, true })
+    {
+        icosphere->setCacheOptimized(optimized);
+        addResult(optimized ? "Icosphere" : "Icosphere (unordered)", subdivisions, icosphere->getPositions(),
+            icosphere->getIndices(), icosphere->getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4, timeDraws(*icosphere, instances));
+    }
+    icosphere.reset();
+
+    // cube sphere error falls off as roughly 0.7 / segments^2
+    int segments = std::max(1, static_cast<int>(std::sqrt(0.5f / targetError)));
+    std::unique_ptr<CubeSphere> cubeSphere(new CubeSphere(1.0f, segments));
+    while (segments < 512 && sphereMeshError(cubeSphere->getPositions(), cubeSphere->getIndices()) > targetError)
+    {
+        segments += std::max(1, segments / 16);
+        cubeSphere->setSegmentCount(segments);
+    }
+    for (bool optimized : { false, true })
+    {
+        cubeSphere->setCacheOptimized(optimized);
+        addResult(optimized ? "Cube sphere" : "Cube sphere (unordered)", segments, cubeSphere->getPositions(),
+            cubeSphere->getIndices(), cubeSphere->getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4, timeDraws(*cubeSphere, instances));
+    }
+    cubeSphere.reset();
+
+    // leave nothing of the test draws in the frame
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    std::printf("sphere meshes at %.2f px error on a %.0f px radius, %d draws, %d-entry cache\n",
+        tolerance, pixelRadius, instances, cacheSize);
+    std::printf("%-24s %6s %9s %9s %8s %6s %6s %10s %9s\n",
+        "mesh", "detail", "vertices", "triangles", "error px", "ACMR", "hits", "index KB", "GPU ms");
+    for (const SphereBenchmarkResult& r : results)
+        std::printf("%-24s %6d %9zu %9zu %8.3f %6.3f %5.1f%% %10.1f %9.3f\n", r.name.c_str(), r.detail,
+            r.vertices, r.triangles, r.errorPixels, r.acmr, r.hitRate * 100.0f, r.indexBytes / 1024.0, r.gpuMs);
+    std::fflush(stdout);
+}
+
+void SphereBenchmark::drawPanel()
+{
+    ImGui::Begin("Sphere Benchmark");
+    ImGui::SliderFloat("Error (px)", &tolerance, 0.1f, 4.0f);
+    ImGui::SliderFloat("Radius (px)", &pixelRadius, 10.0f, 2000.0f);
+    ImGui::SliderInt("Draws", &instances, 1, 5000);
+    ImGui::SliderInt("Cache size", &cacheSize, 4, 64);
+    if (ImGui::Button("Run"))
+        pending = true;
+
+    if (!results.empty() && ImGui::BeginTable("SphereBenchmarkResults", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        const char* headers[] = { "Mesh", "Detail", "Vertices", "Triangles", "Error px", "ACMR", "Cache hits", "GPU ms" };
+        for (const char* header : headers)
+            ImGui::TableSetupColumn(header);
+        ImGui::TableHeadersRow();
+        for (const SphereBenchmarkResult& r : results)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(r.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%d", r.detail);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", r.vertices);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", r.triangles);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", r.errorPixels);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", r.acmr);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f%%", r.hitRate * 100.0f);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", r.gpuMs);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <glm.hpp>
+#include <string>
+#include <vector>
+
+// Compares the UV sphere against the icosphere and cube-sphere generators at equal visual
+// error. For a target silhouette error in pixels at a given on-screen radius, each generator
+// gets the coarsest detail level that meets it; the table then shows what that costs:
+// vertices, triangles, index size, the post-transform cache hit rate and measured GPU time.
+struct SphereBenchmarkResult
+{
+    std::string name;
+    int detail;             // sectors, subdivisions or segments
+    size_t vertices;
+    size_t triangles;
+    float errorPixels;      // measured, at the benchmark radius
+    float acmr;             // transformed vertices per triangle, FIFO cache
+    float hitRate;          // fraction of index fetches served by the cache
+    size_t indexBytes;
+    double gpuMs;           // for all instances, best of several runs
+};
+
+class SphereBenchmark
+{
+public:
+    SphereBenchmark();
+
+    // builds the meshes and times them. Needs a current context and draws into the bound
+    // framebuffer (which it clears afterwards), so call it before the frame is rendered.
+    // The shader must take a "model" mat4 and "emissiveColor" vec3 (shaders/sun.*).
+    void run(const Shader& shader, const glm::vec3& eye, const glm::vec3& front,
+        float projectionScale, float viewportHeight);
+
+    // settings, a Run button and the result table; run() is left to the caller, so the
+    // panel only raises requested()
+    void drawPanel();
+    bool requested() const { return pending; }
+
+    const std::vector<SphereBenchmarkResult>& getResults() const { return results; }
+
+    float tolerance;        // pixels
+    float pixelRadius;      // on-screen radius the meshes are compared at
+    int instances;          // draws per timing
+    int cacheSize;          // simulated FIFO entries
+
+private:
+    std::vector<SphereBenchmarkResult> results;
+    bool pending;
+};
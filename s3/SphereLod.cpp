@@ -0,0 +1,38 @@
+#include "SphereLod.h"
+
+#include <cmath>
+
+// sectors per level; stacks are half of that. The coarsest level is a few dozen triangles.
+static const int LOD_SECTORS[] = { 6, 12, 24, 48, 96, 192 };
+
+SphereLodChain::SphereLodChain() : tolerance(0.5f), hysteresis(0.6f)
+{
+    for (int sectors : LOD_SECTORS)
+        levels.emplace_back(new Sphere(1.0f, sectors, sectors / 2, true, 3));
+}
+
+float SphereLodChain::errorPixels(int index, float pixelRadius) const
+{
+    const float PI = acos(-1.0f);
+    return pixelRadius * (1.0f - cosf(PI / sectorCount(index)));
+}
+
+int SphereLodChain::select(float pixelRadius, int current) const
+{
+    const int last = levelCount() - 1;
+    if (current < 0 || current > last)
+        current = 0;
+
+    // finest level needed right now
+    int needed = 0;
+    while (needed < last && errorPixels(needed, pixelRadius) > tolerance)
+        ++needed;
+    if (needed >= current)
+        return needed;
+
+    // only drop detail once a coarser level is comfortably inside the tolerance
+    int coarse = 0;
+    while (coarse < last && errorPixels(coarse, pixelRadius) > tolerance * hysteresis)
+        ++coarse;
+    return coarse < current ? coarse : current;
+}
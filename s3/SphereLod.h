@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Sphere.h"
+
+#include <glm.hpp>
+#include <memory>
+#include <vector>
+
+// Unit spheres of increasing detail, built once. A body's level is picked from its
+// projected radius so that the silhouette error (the gap between a sector chord and the
+// true circle, r * (1 - cos(pi / sectors))) stays under a pixel tolerance.
+class SphereLodChain
+{
+public:
+    SphereLodChain();
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    const Sphere& level(int index) const { return *levels[index]; }
+    int sectorCount(int index) const { return levels[index]->getSectorCount(); }
+
+    // silhouette error in pixels of a level drawn at the given projected radius
+    float errorPixels(int index, float pixelRadius) const;
+
+    // picks the level for a body. Refining happens as soon as the current level exceeds the
+    // tolerance; coarsening waits until the coarser level is well under it, so bodies near a
+    // threshold don't flicker between levels.
+    int select(float pixelRadius, int current) const;
+
+    float tolerance;    // pixels
+    float hysteresis;   // fraction of the tolerance a coarser level must reach
+
+private:
+    std::vector<std::unique_ptr<Sphere>> levels;
+};
+
+// radius in pixels of a sphere on screen; projectionScale is projection[1][1]
+inline float projectedRadius(const glm::vec3& center, float radius, const glm::vec3& eye,
+    float projectionScale, float viewportHeight)
+{
+    float distance = glm::length(center - eye);
+    if (distance <= radius)
+        return viewportHeight;   // camera inside or touching: full detail
+    return radius * projectionScale * 0.5f * viewportHeight / distance;
+}
@@ -0,0 +1,236 @@
+#include "SphereMesh.h"
+#include "GLState.h"
+#include "VertexCache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+SphereMesh::SphereMesh(float radius, bool cacheOptimized) :
+    radius(radius), cacheOptimized(cacheOptimized),
+    VAO(0), VBO(0), EBO(0)
+{
+}
+
+SphereMesh::~SphereMesh()
+{
+    GLState::get().deleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+unsigned int SphereMesh::getIndexType() const
+{
+    return positions.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void SphereMesh::setRadius(float radius)
+{
+    if (radius != this->radius)
+    {
+        this->radius = radius;
+        setupMesh();
+    }
+}
+
+void SphereMesh::setCacheOptimized(bool optimized)
+{
+    if (optimized != cacheOptimized)
+    {
+        cacheOptimized = optimized;
+        rebuild();
+    }
+}
+
+void SphereMesh::draw() const
+{
+    GLState::get().bindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, getIndexCount(), getIndexType(), 0);
+}
+
+void SphereMesh::rebuild()
+{
+    positions.clear();
+    indices.clear();
+    texCoords.clear();
+    buildUnitSphere();
+    buildTexCoords();
+    if (cacheOptimized)
+        optimize();
+    setupMesh();
+}
+
+unsigned int SphereMesh::addPosition(const glm::vec3& p)
+{
+    positions.push_back(glm::normalize(p));
+    return static_cast<unsigned int>(positions.size() - 1);
+}
+
+void SphereMesh::addTriangle(unsigned int i1, unsigned int i2, unsigned int i3)
+{
+    indices.push_back(i1);
+    indices.push_back(i2);
+    indices.push_back(i3);
+}
+
+// Same parameterisation as Sphere::buildVerticesSmooth: s runs 1 -> 0 with the sector angle
+// measured from -x towards -z, t runs 0 -> 1 from the south pole (y = -1) to the north.
+void SphereMesh::buildTexCoords()
+{
+    const float PI = acos(-1.0f);
+    const float POLE = 1.0f - 1e-6f;
+
+    texCoords.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const glm::vec3& p = positions[i];
+        float angle = atan2f(-p.z, -p.x);
+        if (angle < 0.0f)
+            angle += 2.0f * PI;
+        texCoords[i] = glm::vec2(1.0f - angle / (2.0f * PI), acosf(glm::clamp(-p.y, -1.0f, 1.0f)) / PI);
+    }
+
+    // triangles straddling the seam get copies of their low-s vertices shifted by one turn;
+    // pole vertices have no meaningful s, so each pole triangle gets its own copy in between
+    std::unordered_map<unsigned int, unsigned int> shifted;
+    const size_t originalCount = positions.size();
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        unsigned int* tri = &indices[t];
+        float lo = 2.0f, hi = -1.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (std::fabs(positions[tri[k]].y) >= POLE)
+                continue;
+            lo = std::min(lo, texCoords[tri[k]].x);
+            hi = std::max(hi, texCoords[tri[k]].x);
+        }
+        if (hi - lo > 0.5f)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int v = tri[k];
+                if (std::fabs(positions[v].y) >= POLE || texCoords[v].x >= 0.5f)
+                    continue;
+                auto found = shifted.find(v);
+                if (found == shifted.end())
+                {
+                    positions.push_back(positions[v]);
+                    texCoords.push_back(texCoords[v] + glm::vec2(1.0f, 0.0f));
+                    found = shifted.emplace(v, static_cast<unsigned int>(positions.size() - 1)).first;
+                }
+                tri[k] = found->second;
+            }
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = tri[k];
+            if (v >= originalCount || std::fabs(positions[v].y) < POLE)
+                continue;
+            float s = 0.5f * (texCoords[tri[(k + 1) % 3]].x + texCoords[tri[(k + 2) % 3]].x);
+            positions.push_back(positions[v]);
+            texCoords.push_back(glm::vec2(s, texCoords[v].y));
+            tri[k] = static_cast<unsigned int>(positions.size() - 1);
+        }
+    }
+
+    // pole originals are no longer referenced; optimize() drops them
+}
+
+void SphereMesh::optimize()
+{
+    indices = optimizeVertexCache(indices, positions.size());
+    std::vector<unsigned int> remap = optimizeVertexFetch(indices, positions.size());
+
+    std::vector<glm::vec3> orderedPositions(positions.size());
+    std::vector<glm::vec2> orderedTexCoords(texCoords.size());
+    size_t used = 0;
+    for (size_t v = 0; v < positions.size(); ++v)
+    {
+        orderedPositions[remap[v]] = positions[v];
+        orderedTexCoords[remap[v]] = texCoords[v];
+    }
+    for (unsigned int index : indices)
+        used = std::max(used, static_cast<size_t>(index) + 1);
+    // unreferenced vertices were moved to the end
+    orderedPositions.resize(used);
+    orderedTexCoords.resize(used);
+    positions.swap(orderedPositions);
+    texCoords.swap(orderedTexCoords);
+}
+
+void SphereMesh::setupMesh()
+{
+    if (VAO == 0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
+
+    std::vector<float> interleavedVertices;
+    interleavedVertices.reserve(positions.size() * 8);
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const glm::vec3& n = positions[i];
+        interleavedVertices.insert(interleavedVertices.end(),
+            { n.x * radius, n.y * radius, n.z * radius, n.x, n.y, n.z, texCoords[i].x, texCoords[i].y });
+    }
+
+    GLState::get().bindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, interleavedVertices.size() * sizeof(float), interleavedVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (getIndexType() == GL_UNSIGNED_SHORT)
+    {
+        std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Normal attribute
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // Texture coordinate attribute
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    GLState::get().bindVertexArray(0);
+}
+
+float sphereMeshError(const std::vector<glm::vec3>& unitPositions, const std::vector<unsigned int>& indices)
+{
+    float worst = 0.0f;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const glm::vec3& a = unitPositions[indices[t]];
+        const glm::vec3& b = unitPositions[indices[t + 1]];
+        const glm::vec3& c = unitPositions[indices[t + 2]];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float area = glm::length(normal);
+        if (area <= 0.0f)
+            continue;   // degenerate (pole caps of a UV sphere)
+        normal /= area;
+
+        // the point of the triangle's plane closest to the centre, if it lies inside the
+        // triangle; otherwise the closest point is on an edge, where it's the midpoint
+        glm::vec3 foot = normal * glm::dot(normal, a);
+        bool inside = glm::dot(glm::cross(b - a, foot - a), normal) >= 0.0f &&
+            glm::dot(glm::cross(c - b, foot - b), normal) >= 0.0f &&
+            glm::dot(glm::cross(a - c, foot - c), normal) >= 0.0f;
+        float nearest = inside ? std::fabs(glm::dot(normal, a)) :
+            std::min({ glm::length(0.5f * (a + b)), glm::length(0.5f * (b + c)), glm::length(0.5f * (c + a)) });
+        worst = std::max(worst, 1.0f - nearest);
+    }
+    return worst;
+}
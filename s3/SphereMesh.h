@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm.hpp>
+#include <vector>
+
+// Shared base of the subdivided sphere generators (Icosphere, CubeSphere). A derived class
+// only produces unit positions and triangles; the base adds normals and equirectangular
+// texture coordinates laid out like Sphere's (so the same maps line up), splits vertices
+// along the texture seam, reorders the triangles for the post-transform vertex cache and
+// stores the indices as 16-bit when the vertex count allows it.
+//
+// Vertex layout matches Sphere: location 0 position, 1 normal, 2 texCoord.
+class SphereMesh
+{
+public:
+    virtual ~SphereMesh();
+
+    // Getters
+    float getRadius() const { return radius; }
+    bool isCacheOptimized() const { return cacheOptimized; }
+    unsigned int getVAO() const { return VAO; }
+    unsigned int getIndexCount() const { return static_cast<unsigned int>(indices.size()); }
+    unsigned int getIndexType() const;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    size_t getVertexCount() const { return positions.size(); }
+    size_t getTriangleCount() const { return indices.size() / 3; }
+    const std::vector<glm::vec3>& getPositions() const { return positions; }   // unit sphere
+    const std::vector<unsigned int>& getIndices() const { return indices; }
+
+    // Setters
+    void setRadius(float radius);
+    void setCacheOptimized(bool optimized);
+
+    // Drawing functions
+    void draw() const;
+
+protected:
+    SphereMesh(float radius, bool cacheOptimized);
+
+    // fills positions (unit length) and indices, counter-clockwise seen from outside
+    virtual void buildUnitSphere() = 0;
+
+    // generate + post-process + upload; derived constructors and setters call this
+    void rebuild();
+
+    // midpoint/grid helpers for derived classes
+    unsigned int addPosition(const glm::vec3& p);
+    void addTriangle(unsigned int i1, unsigned int i2, unsigned int i3);
+
+    float radius;
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+
+private:
+    void buildTexCoords();
+    void optimize();
+    void setupMesh();
+
+    bool cacheOptimized;
+    std::vector<glm::vec2> texCoords;
+    unsigned int VAO, VBO, EBO; // OpenGL buffers
+};
+
+// largest distance (relative to the radius) between a triangle's surface and the true
+// sphere, sampled at edge midpoints and centroids. Used to compare meshes at equal
+// visual error: on screen the gap is error * pixelRadius.
+float sphereMeshError(const std::vector<glm::vec3>& unitPositions, const std::vector<unsigned int>& indices);
@@ -0,0 +1,85 @@
+#include "SphereRenderer.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+SphereRenderer::SphereRenderer(StreamBuffer& stream) : stream(stream), drawCalls(0)
+{
+    for (int m = 0; m < SPHERE_MATERIAL_COUNT; ++m)
+        queues[m].resize(lods.levelCount());
+}
+
+void SphereRenderer::begin()
+{
+    for (int m = 0; m < SPHERE_MATERIAL_COUNT; ++m)
+        for (std::vector<SphereInstance>& queue : queues[m])
+            queue.clear();
+    drawCalls = 0;
+}
+
+void SphereRenderer::add(SphereMaterial material, int lod, const glm::mat4& model, const glm::vec4& color,
+    float textureLayer, float emissive)
+{
+    SphereInstance instance;
+    instance.model = model;
+    instance.color = color;
+    instance.params = glm::vec4(textureLayer, emissive, 0.0f, 0.0f);
+    queues[material][lod].push_back(instance);
+}
+
+size_t SphereRenderer::getInstanceCount() const
+{
+    size_t count = 0;
+    for (int m = 0; m < SPHERE_MATERIAL_COUNT; ++m)
+        for (const std::vector<SphereInstance>& queue : queues[m])
+            count += queue.size();
+    return count;
+}
+
+size_t SphereRenderer::getTriangleCount() const
+{
+    size_t count = 0;
+    for (int m = 0; m < SPHERE_MATERIAL_COUNT; ++m)
+        for (int level = 0; level < lods.levelCount(); ++level)
+            count += queues[m][level].size() * (lods.level(level).getIndexCount() / 3);
+    return count;
+}
+
+void SphereRenderer::draw(SphereMaterial material)
+{
+    for (int level = 0; level < lods.levelCount(); ++level)
+    {
+        const std::vector<SphereInstance>& queue = queues[material][level];
+        if (queue.empty())
+            continue;
+
+        // a frame that doesn't fit is counted by the stream, which grows for the next one
+        StreamBuffer::Allocation instances = stream.write(queue.data(), queue.size() * sizeof(SphereInstance));
+        if (!instances.pointer)
+            continue;
+
+        // the instance attributes point at this queue's allocation
+        const Sphere& mesh = lods.level(level);
+        GLState::get().bindVertexArray(mesh.getVAO());
+        glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+        const GLsizei stride = sizeof(SphereInstance);
+        const size_t base = instances.offset;
+        for (int column = 0; column < 4; ++column)
+        {
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SphereInstance, model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SphereInstance, color)));
+        glEnableVertexAttribArray(7);
+        glVertexAttribDivisor(7, 1);
+        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SphereInstance, params)));
+        glEnableVertexAttribArray(8);
+        glVertexAttribDivisor(8, 1);
+
+        glDrawElementsInstanced(GL_TRIANGLES, mesh.getIndexCount(), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(queue.size()));
+        ++drawCalls;
+    }
+}
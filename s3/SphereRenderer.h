@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SphereLod.h"
+#include "StreamBuffer.h"
+
+#include <glm.hpp>
+#include <vector>
+
+// material classes; each is one instanced draw per LOD level in use
+enum SphereMaterial {
+    SPHERE_EMISSIVE,   // flat colour (shaders/emissive.*)
+    SPHERE_LIT,        // lit, optionally textured from the scene's texture array (shaders/body.*)
+    SPHERE_MATERIAL_COUNT
+};
+
+// Per-instance data, matching attributes 3-8 of the instanced shaders
+struct SphereInstance
+{
+    glm::mat4 model;        // locations 3-6
+    glm::vec4 color;        // location 7
+    glm::vec4 params;       // location 8: x = texture layer (-1 for none), y = emissive
+};
+
+// Draws every spherical body from one shared chain of unit spheres. Bodies are queued per
+// material and LOD level and each non-empty queue goes out as a single
+// glDrawElementsInstanced, so the draw count stays bounded by materials x levels however
+// many moons and minor bodies are added. The instances are written into the frame's part of
+// the stream buffer and each draw points the instance attributes at its allocation.
+class SphereRenderer
+{
+public:
+    explicit SphereRenderer(StreamBuffer& stream);
+
+    // clears the queues for a new frame
+    void begin();
+
+    void add(SphereMaterial material, int lod, const glm::mat4& model, const glm::vec4& color,
+        float textureLayer = -1.0f, float emissive = 0.0f);
+    // direct access for bulk fills (e.g. resize and write from worker threads)
+    std::vector<SphereInstance>& instances(SphereMaterial material, int lod) { return queues[material][lod]; }
+
+    // streams the material's instances and draws them with the currently bound program
+    void draw(SphereMaterial material);
+
+    SphereLodChain& getLodChain() { return lods; }
+    int getDrawCalls() const { return drawCalls; }
+    size_t getInstanceCount() const;
+    size_t getTriangleCount() const;
+
+private:
+    StreamBuffer& stream;
+    SphereLodChain lods;
+    std::vector<std::vector<SphereInstance>> queues[SPHERE_MATERIAL_COUNT];   // [material][level]
+    int drawCalls;
+};
@@ -0,0 +1,132 @@
+#include "StarCatalog.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+const double STAR_PI = 3.14159265358979323846;
+
+StarCatalog::StarCatalog(double bandHeightDegrees) :
+    bandHeight(bandHeightDegrees * STAR_PI / 180.0),
+    bandCount(static_cast<size_t>(std::ceil(STAR_PI / (bandHeightDegrees * STAR_PI / 180.0))))
+{
+}
+
+size_t StarCatalog::loadFromFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "Star catalog failed to load at path: " << path << std::endl;
+        return 0;
+    }
+
+    size_t read = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        double raDeg, decDeg;
+        float mag = 0.0f;
+        if (!(fields >> raDeg >> decDeg))
+            continue;
+        fields >> mag;
+        addStar(raDeg * STAR_PI / 180.0, decDeg * STAR_PI / 180.0, mag);
+        ++read;
+    }
+    buildIndex();
+    return read;
+}
+
+void StarCatalog::generateRandom(size_t count, uint64_t seed)
+{
+    Random rng(seed);
+    ra.reserve(ra.size() + count);
+    dec.reserve(dec.size() + count);
+    magnitude.reserve(magnitude.size() + count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double r = rng.uniform(0.0, 2.0 * STAR_PI);
+        double d = std::asin(rng.uniform(-1.0, 1.0));
+        // roughly the magnitude distribution of a faint survey catalog
+        float m = static_cast<float>(18.0 - 6.0 * std::pow(rng.uniform(), 2.5));
+        addStar(r, d, m);
+    }
+    buildIndex();
+}
+
+void StarCatalog::addStar(double r, double d, float mag)
+{
+    r = std::fmod(r, 2.0 * STAR_PI);
+    if (r < 0.0)
+        r += 2.0 * STAR_PI;
+    ra.push_back(r);
+    dec.push_back(std::clamp(d, -STAR_PI / 2.0, STAR_PI / 2.0));
+    magnitude.push_back(mag);
+}
+
+size_t StarCatalog::bandOf(double declination) const
+{
+    double offset = (declination + STAR_PI / 2.0) / bandHeight;
+    if (offset <= 0.0)
+        return 0;
+    return std::min(static_cast<size_t>(offset), bandCount - 1);
+}
+
+void StarCatalog::buildIndex()
+{
+    const size_t count = ra.size();
+    std::vector<size_t> band(count);
+    for (size_t i = 0; i < count; ++i)
+        band[i] = bandOf(dec[i]);
+
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return band[a] != band[b] ? band[a] < band[b] : ra[a] < ra[b];
+    });
+
+    auto permute = [&](auto& values) {
+        auto sorted = values;
+        for (size_t i = 0; i < count; ++i)
+            sorted[i] = values[order[i]];
+        values.swap(sorted);
+    };
+    permute(ra);
+    permute(dec);
+    permute(magnitude);
+
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double cd = std::cos(dec[i]);
+        x[i] = cd * std::cos(ra[i]);
+        y[i] = cd * std::sin(ra[i]);
+        z[i] = std::sin(dec[i]);
+    }
+
+    bandStart.assign(bandCount + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+        bandStart[band[order[i]] + 1]++;
+    for (size_t b = 0; b < bandCount; ++b)
+        bandStart[b + 1] += bandStart[b];
+}
+
+size_t StarCatalog::findRange(size_t band, double raMin, double raMax, size_t& first) const
+{
+    auto begin = ra.begin() + bandStart[band];
+    auto end = ra.begin() + bandStart[band + 1];
+    auto lo = std::lower_bound(begin, end, raMin);
+    auto hi = std::upper_bound(lo, end, raMax);
+    first = static_cast<size_t>(lo - ra.begin());
+    return static_cast<size_t>(hi - lo);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Star catalog with a sky-plane index: stars are bucketed into fixed-height declination
+// bands and sorted by right ascension inside each band, so a small RA/Dec box is found
+// with one binary search per band instead of a scan over the whole catalog.
+// Positions are equatorial J2000, angles in radians.
+class StarCatalog
+{
+public:
+    explicit StarCatalog(double bandHeightDegrees = 0.1);
+
+    // loads whitespace or comma separated "ra_deg dec_deg [mag]" lines; returns stars read
+    size_t loadFromFile(const std::string& path);
+    // fills the catalog with uniformly distributed stars (for benchmarks when no catalog is installed)
+    void generateRandom(size_t count, uint64_t seed);
+
+    void addStar(double ra, double dec, float magnitude);
+    // sorts the pending stars into the band index; call after adding stars
+    void buildIndex();
+
+    size_t size() const { return ra.size(); }
+
+    // calls visit(index) for every star inside the RA/Dec box; raMin may exceed raMax when
+    // the box wraps through RA = 0. Returns the number of stars visited.
+    template <typename F>
+    size_t query(double raMin, double raMax, double decMin, double decMax, F&& visit) const;
+
+    // star data in index order (SoA)
+    std::vector<double> ra;
+    std::vector<double> dec;
+    std::vector<float> magnitude;
+    // unit direction vectors, used for the exact separation tests
+    std::vector<double> x, y, z;
+
+private:
+    size_t bandOf(double declination) const;
+    size_t findRange(size_t band, double raMin, double raMax, size_t& first) const;
+
+    double bandHeight;
+    size_t bandCount;
+    std::vector<size_t> bandStart;   // bandCount + 1 offsets into the star arrays
+};
+
+template <typename F>
+size_t StarCatalog::query(double raMin, double raMax, double decMin, double decMax, F&& visit) const
+{
+    if (bandStart.empty())
+        return 0;
+    size_t visited = 0;
+    size_t firstBand = bandOf(decMin);
+    size_t lastBand = bandOf(decMax);
+    for (size_t band = firstBand; band <= lastBand; ++band)
+    {
+        // a wrapped box is two RA ranges
+        double ranges[2][2] = { { raMin, raMax }, { 0.0, -1.0 } };
+        if (raMin > raMax)
+        {
+            ranges[0][1] = 1e9;
+            ranges[1][0] = -1e9;
+            ranges[1][1] = raMax;
+        }
+        for (int r = 0; r < 2; ++r)
+        {
+            if (ranges[r][0] > ranges[r][1])
+                continue;
+            size_t first;
+            size_t count = findRange(band, ranges[r][0], ranges[r][1], first);
+            for (size_t i = first; i < first + count; ++i)
+            {
+                if (dec[i] >= decMin && dec[i] <= decMax)
+                    visit(i);
+            }
+            visited += count;
+        }
+    }
+    return visited;
+}
@@ -0,0 +1,207 @@
+#include "StreamBuffer.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+StreamBuffer::StreamBuffer(size_t frameBytes) :
+    frameBytes(frameBytes), buffer(0), persistent(false), uniformAlignment(256),
+    mapped(NULL), staging(NULL), region(FRAMES - 1), used(0), demand(0),
+    lastUsed(0), stalls(0), overflows(0), grows(0)
+{
+    for (int i = 0; i < FRAMES; ++i)
+        fences[i] = NULL;
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+        uniformAlignment = size_t(alignment);
+
+    create();
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (int i = 0; i < FRAMES; ++i)
+        if (fences[i])
+            glDeleteSync(static_cast<GLsync>(fences[i]));
+    destroy();
+}
+
+void StreamBuffer::create()
+{
+    persistent = false;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    // glad only loads glBufferStorage for a 4.4 context
+    if ((GLAD_GL_VERSION_4_4 || hasExtension("GL_ARB_buffer_storage")) && glBufferStorage != NULL)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, FRAMES * frameBytes, NULL, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, FRAMES * frameBytes, flags));
+        persistent = mapped != NULL;
+        if (!persistent)
+        {
+            // immutable storage can't be respecified; start over with a plain buffer
+            std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        }
+    }
+    if (!persistent)
+    {
+        glBufferData(GL_ARRAY_BUFFER, frameBytes, NULL, GL_STREAM_DRAW);
+        staging = new unsigned char[frameBytes];
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::destroy()
+{
+    if (mapped)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+    delete[] staging;
+    buffer = 0;
+    mapped = NULL;
+    staging = NULL;
+}
+
+void StreamBuffer::waitForRegion(int index)
+{
+    GLsync fence = static_cast<GLsync>(fences[index]);
+    if (!fence)
+        return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++stalls;
+        // the region can't be touched before the GPU is done with it, however long that takes
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+    }
+    if (status == GL_WAIT_FAILED)
+    {
+        std::cout << "ERROR::STREAM_BUFFER::WAIT_FAILED" << std::endl;
+        glFinish();
+    }
+    glDeleteSync(fence);
+    fences[index] = NULL;
+}
+
+void StreamBuffer::beginFrame()
+{
+    lastUsed = used;
+    used = 0;
+    if (demand > frameBytes)
+    {
+        // last frame didn't fit: once nothing reads the old buffer, replace it with one that
+        // has room to spare (the buffer name changes)
+        for (int i = 0; i < FRAMES; ++i)
+            waitForRegion(i);
+        destroy();
+        frameBytes = (demand + demand / 2 + 0xffff) & ~size_t(0xffff);
+        create();
+        region = FRAMES - 1;
+        ++grows;
+    }
+    demand = 0;
+    if (!persistent)
+    {
+        // orphan: the driver hands out fresh storage while the GPU finishes with the old
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, frameBytes, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    region = (region + 1) % FRAMES;
+    waitForRegion(region);
+}
+
+void StreamBuffer::endFrame()
+{
+    if (persistent)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(size_t bytes, size_t alignment)
+{
+    Allocation allocation;
+    allocation.pointer = NULL;
+    allocation.offset = 0;
+    allocation.size = bytes;
+
+    // aligned in the buffer, not just within the region
+    const size_t base = persistent ? size_t(region) * frameBytes : 0;
+    size_t start = (base + used + alignment - 1) / alignment * alignment - base;
+    demand += start + bytes - used;
+    if (start + bytes > frameBytes)
+    {
+        ++overflows;
+        return allocation;
+    }
+    used = start + bytes;
+    allocation.offset = base + start;
+    allocation.pointer = persistent ? mapped + allocation.offset : staging + start;
+    return allocation;
+}
+
+void StreamBuffer::commit(const Allocation& allocation)
+{
+    if (persistent || !allocation.pointer)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.offset, allocation.size, allocation.pointer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::write(const void* data, size_t bytes, size_t alignment)
+{
+    Allocation allocation = allocate(bytes, alignment);
+    if (allocation.pointer)
+    {
+        std::memcpy(allocation.pointer, data, bytes);
+        commit(allocation);
+    }
+    return allocation;
+}
+
+bool StreamBuffer::writeUniformBlock(unsigned int binding, const void* data, size_t bytes)
+{
+    Allocation allocation = write(data, bytes, uniformAlignment);
+    if (!allocation.pointer)
+        return false;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, allocation.offset, bytes);
+    return true;
+}
+
+void StreamBuffer::drawStats()
+{
+    ImGui::Text("Stream buffer (%s): %.1f / %.0f KB a frame, %zu stalls, %zu overflows, grown %zu times",
+        persistent ? "persistent" : "orphaned", lastUsed / 1024.0, frameBytes / 1024.0, stalls, overflows, grows);
+}
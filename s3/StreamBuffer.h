@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+
+// One buffer for everything that is rewritten every frame: transient vertices (orbit rings,
+// the mouse ray, sky directions), sphere instances and uniform blocks. It holds FRAMES regions and each frame writes into the
+// next one, sub-allocating from it linearly, so nothing is created or resized while drawing.
+//
+// With GL 4.4 or GL_ARB_buffer_storage the whole buffer is mapped once, persistently and
+// coherently, and allocations are plain pointers into it. A fence is set at the end of each
+// frame; a region is only rewritten once the fence of the frame that last used it has
+// passed, which with three regions has always happened unless the GPU is more than two
+// frames behind (counted as a stall). Without buffer storage the buffer is one region,
+// orphaned at the start of each frame; allocations then point into a CPU copy and commit()
+// uploads them with glBufferSubData.
+//
+// An allocation that doesn't fit in what is left of the frame's region fails (NULL pointer)
+// and is counted. The next beginFrame() then waits for the GPU to finish with the buffer and
+// replaces it with one half as large again as the failed frame asked for, so a bigger scene
+// costs one frame of missing draws, not every frame. The buffer name changes when that
+// happens: users point their attributes at getBuffer() each frame.
+class StreamBuffer
+{
+public:
+    static const int FRAMES = 3;
+
+    struct Allocation
+    {
+        void* pointer;      // NULL if the frame's region is full
+        size_t offset;      // in the buffer, for attribute offsets and buffer ranges
+        size_t size;
+    };
+
+    explicit StreamBuffer(size_t frameBytes);
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // moves on to the next region, waiting for the GPU if it still reads it; grows the buffer
+    // after a frame that didn't fit
+    void beginFrame();
+    // fences the frame's region; after the frame's last draw
+    void endFrame();
+
+    // alignment can be any size, e.g. a vertex stride, so offset / stride is a first vertex
+    Allocation allocate(size_t bytes, size_t alignment = 16);
+    // makes the written allocation visible to GL (only does anything when orphaning)
+    void commit(const Allocation& allocation);
+    // allocate, copy and commit in one; returns the allocation
+    Allocation write(const void* data, size_t bytes, size_t alignment = 16);
+    // writes a uniform block and binds it to the binding point for this frame
+    bool writeUniformBlock(unsigned int binding, const void* data, size_t bytes);
+
+    unsigned int getBuffer() const { return buffer; }
+    bool isPersistent() const { return persistent; }
+    size_t getUniformAlignment() const { return uniformAlignment; }
+
+    void drawStats();
+
+private:
+    void create();
+    void destroy();
+    // waits until the GPU is done with the region, then drops its fence
+    void waitForRegion(int index);
+
+    size_t frameBytes;
+    unsigned int buffer;
+    bool persistent;
+    size_t uniformAlignment;
+
+    unsigned char* mapped;                      // persistent mapping of all regions
+    unsigned char* staging;                     // CPU copy of the region when orphaning
+    void* fences[FRAMES];                       // GLsync of the frame that last wrote each region
+    int region;
+    size_t used;
+    size_t demand;                              // bytes the frame asked for, failed requests included
+
+    size_t lastUsed, stalls, overflows, grows;
+};
@@ -0,0 +1,402 @@
+#include "TextureCompression.h"
+
+#include "stb_image.h"
+
+#include <glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint32_t KTX_ENDIANNESS = 0x04030201;
+    // KTX 1.1 header after the identifier, in file order
+    enum
+    {
+        KTX_ENDIAN, KTX_GL_TYPE, KTX_GL_TYPE_SIZE, KTX_GL_FORMAT, KTX_GL_INTERNAL_FORMAT,
+        KTX_GL_BASE_INTERNAL_FORMAT, KTX_WIDTH, KTX_HEIGHT, KTX_DEPTH, KTX_ARRAY_ELEMENTS,
+        KTX_FACES, KTX_MIP_LEVELS, KTX_KEY_VALUE_BYTES, KTX_HEADER_WORDS
+    };
+
+    int blockBytes(GLenum format)
+    {
+        return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+    }
+
+    GLenum baseFormat(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return GL_RGB;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return GL_RGBA;
+        case GL_COMPRESSED_RED_RGTC1: return GL_RED;
+        case GL_COMPRESSED_RG_RGTC2: return GL_RG;
+        default: return 0;
+        }
+    }
+
+    size_t levelBytes(GLenum format, int width, int height)
+    {
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    // one 8-bit channel of a 4x4 block -> 8 bytes (BC4, also BC3 alpha and both halves of BC5)
+    void encodeChannelBlock(const unsigned char values[16], unsigned char* out)
+    {
+        unsigned char low = 255, high = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+        }
+        // endpoint 0 > endpoint 1 selects the eight-value palette
+        int palette[8] = { high, low };
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * high + i * low + 3) / 7;
+
+        uint64_t bits = 0;
+        if (high != low)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0, bestError = 256;
+                for (int code = 0; code < 8; ++code)
+                {
+                    int error = std::abs(palette[code] - values[i]);
+                    if (error < bestError)
+                    {
+                        best = code;
+                        bestError = error;
+                    }
+                }
+                bits |= uint64_t(best) << (3 * i);
+            }
+        }
+        out[0] = high;
+        out[1] = low;
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    uint16_t packColor(const glm::vec3& color)
+    {
+        glm::vec3 c = glm::clamp(color, 0.0f, 255.0f);
+        return uint16_t((int(c.r * 31.0f / 255.0f + 0.5f) << 11) | (int(c.g * 63.0f / 255.0f + 0.5f) << 5) | int(c.b * 31.0f / 255.0f + 0.5f));
+    }
+
+    glm::vec3 unpackColor(uint16_t packed)
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+    }
+
+    // RGB of a 4x4 block -> 8 bytes (BC1): endpoints on the colours' principal axis
+    void encodeColorBlock(const glm::vec3 colors[16], unsigned char* out)
+    {
+        glm::vec3 mean(0.0f);
+        for (int i = 0; i < 16; ++i)
+            mean += colors[i];
+        mean /= 16.0f;
+        glm::mat3 covariance(0.0f);
+        for (int i = 0; i < 16; ++i)
+        {
+            glm::vec3 d = colors[i] - mean;
+            covariance += glm::outerProduct(d, d);
+        }
+        glm::vec3 axis(1.0f);
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            glm::vec3 next = covariance * axis;
+            float length = glm::length(next);
+            if (length < 1e-6f)
+                break;
+            axis = next / length;
+        }
+        axis = glm::normalize(axis);
+
+        float low = 1e9f, high = -1e9f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = glm::dot(colors[i] - mean, axis);
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+        uint16_t color0 = packColor(mean + axis * high), color1 = packColor(mean + axis * low);
+        // color0 > color1 selects the four-colour palette
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t bits = 0;
+        if (color0 != color1)
+        {
+            glm::vec3 palette[4] = { unpackColor(color0), unpackColor(color1) };
+            palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+            palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                float bestError = 1e30f;
+                for (int code = 0; code < 4; ++code)
+                {
+                    glm::vec3 d = palette[code] - colors[i];
+                    float error = glm::dot(d, d);
+                    if (error < bestError)
+                    {
+                        best = code;
+                        bestError = error;
+                    }
+                }
+                bits |= uint32_t(best) << (2 * i);
+            }
+        }
+        out[0] = (unsigned char)color0;
+        out[1] = (unsigned char)(color0 >> 8);
+        out[2] = (unsigned char)color1;
+        out[3] = (unsigned char)(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    void encodeLevel(GLenum format, const std::vector<unsigned char>& pixels, int width, int height, int channels, unsigned char* out)
+    {
+        for (int by = 0; by < height; by += 4)
+        {
+            for (int bx = 0; bx < width; bx += 4)
+            {
+                // edge blocks repeat the last row and column
+                const unsigned char* texel[16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    int x = std::min(bx + i % 4, width - 1), y = std::min(by + i / 4, height - 1);
+                    texel[i] = &pixels[(size_t(y) * width + x) * channels];
+                }
+                unsigned char values[16];
+                glm::vec3 colors[16];
+                switch (format)
+                {
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    for (int i = 0; i < 16; ++i)
+                        values[i] = texel[i][3];
+                    encodeChannelBlock(values, out);
+                    out += 8;
+                    // fall through: the colour half is a BC1 block
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                    for (int i = 0; i < 16; ++i)
+                        colors[i] = glm::vec3(texel[i][0], texel[i][1], texel[i][2]);
+                    encodeColorBlock(colors, out);
+                    out += 8;
+                    break;
+                case GL_COMPRESSED_RG_RGTC2:
+                    for (int c = 0; c < 2; ++c)
+                    {
+                        for (int i = 0; i < 16; ++i)
+                            values[i] = texel[i][c];
+                        encodeChannelBlock(values, out);
+                        out += 8;
+                    }
+                    break;
+                default:
+                    for (int i = 0; i < 16; ++i)
+                        values[i] = texel[i][0];
+                    encodeChannelBlock(values, out);
+                    out += 8;
+                    break;
+                }
+            }
+        }
+    }
+
+    // 2x2 box filter; normal maps are renormalised so the mips stay unit length
+    std::vector<unsigned char> downsample(const std::vector<unsigned char>& pixels, int width, int height, int channels, bool normals)
+    {
+        const int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+        std::vector<unsigned char> next(size_t(nextWidth) * nextHeight * channels);
+        for (int y = 0; y < nextHeight; ++y)
+        {
+            for (int x = 0; x < nextWidth; ++x)
+            {
+                float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int dy = 0; dy < 2; ++dy)
+                {
+                    for (int dx = 0; dx < 2; ++dx)
+                    {
+                        int sx = std::min(x * 2 + dx, width - 1), sy = std::min(y * 2 + dy, height - 1);
+                        for (int c = 0; c < channels; ++c)
+                            sum[c] += pixels[(size_t(sy) * width + sx) * channels + c];
+                    }
+                }
+                for (int c = 0; c < channels; ++c)
+                    sum[c] *= 0.25f;
+                if (normals)
+                {
+                    glm::vec3 n = glm::vec3(sum[0], sum[1], sum[2]) / 127.5f - 1.0f;
+                    n = glm::length(n) > 1e-6f ? glm::normalize(n) : glm::vec3(0.0f, 0.0f, 1.0f);
+                    n = (n + 1.0f) * 127.5f;
+                    sum[0] = n.x;
+                    sum[1] = n.y;
+                    sum[2] = n.z;
+                }
+                for (int c = 0; c < channels; ++c)
+                    next[(size_t(y) * nextWidth + x) * channels + c] = (unsigned char)std::min(255.0f, sum[c] + 0.5f);
+            }
+        }
+        return next;
+    }
+
+    void writeWord(std::ofstream& file, uint32_t value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+std::string compressedTexturePath(const std::string& sourcePath)
+{
+    size_t dot = sourcePath.find_last_of('.');
+    size_t slash = sourcePath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return sourcePath + ".ktx";
+    return sourcePath.substr(0, dot) + ".ktx";
+}
+
+bool compressTexture(const std::string& sourcePath, const std::string& ktxPath, TextureUsage usage)
+{
+    const int channels = usage == TEXTURE_COLOR ? 4 : usage == TEXTURE_NORMAL ? 3 : 1;
+    int width, height, sourceChannels;
+    stbi_set_flip_vertically_on_load_thread(true);
+    unsigned char* source = stbi_load(sourcePath.c_str(), &width, &height, &sourceChannels, channels);
+    if (!source)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSION::SOURCE_LOAD_FAILED " << sourcePath << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> pixels(source, source + size_t(width) * height * channels);
+    stbi_image_free(source);
+
+    GLenum format = GL_COMPRESSED_RED_RGTC1;
+    if (usage == TEXTURE_NORMAL)
+        format = GL_COMPRESSED_RG_RGTC2;
+    else if (usage == TEXTURE_COLOR)
+    {
+        bool alpha = false;
+        for (size_t i = 3; i < pixels.size() && !alpha; i += 4)
+            alpha = pixels[i] != 255;
+        format = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+
+    CompressedImage image;
+    image.format = format;
+    image.width = width;
+    image.height = height;
+    for (int level = 0, levelWidth = width, levelHeight = height;; ++level)
+    {
+        size_t size = levelBytes(format, levelWidth, levelHeight);
+        image.levelOffset.push_back(image.data.size());
+        image.levelSize.push_back(size);
+        image.data.resize(image.data.size() + size);
+        encodeLevel(format, pixels, levelWidth, levelHeight, channels, &image.data[image.levelOffset.back()]);
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        pixels = downsample(pixels, levelWidth, levelHeight, channels, usage == TEXTURE_NORMAL);
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+    }
+
+    std::ofstream file(ktxPath, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSION::WRITE_FAILED " << ktxPath << std::endl;
+        return false;
+    }
+    // the one key: rows are stored bottom-up
+    const char orientation[] = "KTXorientation\0S=r,T=u";
+    const uint32_t orientationBytes = sizeof(orientation);
+    const uint32_t keyValueBytes = 4 + ((orientationBytes + 3) & ~3u);
+
+    file.write(reinterpret_cast<const char*>(KTX_IDENTIFIER), sizeof(KTX_IDENTIFIER));
+    const uint32_t header[KTX_HEADER_WORDS] = { KTX_ENDIANNESS, 0, 1, 0, format, baseFormat(format),
+        uint32_t(width), uint32_t(height), 0, 0, 1, uint32_t(image.levelCount()), keyValueBytes };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    writeWord(file, orientationBytes);
+    file.write(orientation, orientationBytes);
+    for (uint32_t i = orientationBytes; i % 4 != 0; ++i)
+        file.put(0);
+    // block sizes are multiples of 8, so the levels never need padding
+    for (int level = 0; level < image.levelCount(); ++level)
+    {
+        writeWord(file, uint32_t(image.levelSize[level]));
+        file.write(reinterpret_cast<const char*>(&image.data[image.levelOffset[level]]), std::streamsize(image.levelSize[level]));
+    }
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSION::WRITE_FAILED " << ktxPath << std::endl;
+        return false;
+    }
+    std::cout << "Compressed " << sourcePath << " (" << width << "x" << height << ", " << image.levelCount()
+        << " levels) into " << image.data.size() / 1024 << " KB: " << ktxPath << std::endl;
+    return true;
+}
+
+bool readCompressedTexture(const std::string& ktxPath, CompressedImage& image)
+{
+    std::ifstream file(ktxPath, std::ios::binary);
+    if (!file)
+        return false;
+    unsigned char identifier[12];
+    uint32_t header[KTX_HEADER_WORDS];
+    file.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    const GLenum format = header[KTX_GL_INTERNAL_FORMAT];
+    if (!file || std::memcmp(identifier, KTX_IDENTIFIER, sizeof(identifier)) != 0 || header[KTX_ENDIAN] != KTX_ENDIANNESS
+        || header[KTX_GL_TYPE] != 0 || baseFormat(format) == 0 || header[KTX_DEPTH] > 1
+        || header[KTX_ARRAY_ELEMENTS] != 0 || header[KTX_FACES] != 1 || header[KTX_MIP_LEVELS] == 0
+        || header[KTX_WIDTH] == 0 || header[KTX_HEIGHT] == 0)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSION::UNSUPPORTED_KTX " << ktxPath << std::endl;
+        return false;
+    }
+    file.seekg(header[KTX_KEY_VALUE_BYTES], std::ios::cur);
+
+    image = CompressedImage();
+    image.format = format;
+    image.width = int(header[KTX_WIDTH]);
+    image.height = int(header[KTX_HEIGHT]);
+    for (uint32_t level = 0; level < header[KTX_MIP_LEVELS]; ++level)
+    {
+        uint32_t size = 0;
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file || size != levelBytes(format, image.levelWidth(level), image.levelHeight(level)))
+        {
+            std::cout << "ERROR::TEXTURE_COMPRESSION::TRUNCATED_KTX " << ktxPath << std::endl;
+            return false;
+        }
+        image.levelOffset.push_back(image.data.size());
+        image.levelSize.push_back(size);
+        image.data.resize(image.data.size() + size);
+        file.read(reinterpret_cast<char*>(&image.data[image.levelOffset.back()]), size);
+        file.seekg((4 - size % 4) % 4, std::ios::cur);
+    }
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_COMPRESSION::TRUNCATED_KTX " << ktxPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void uploadCompressedTexture(const CompressedImage& image, const unsigned char* data, bool srgb)
+{
+    // the sRGB variants share the block layout
+    GLenum format = image.format;
+    if (srgb && format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+        format = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    else if (srgb && format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+        format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+    for (int level = 0; level < image.levelCount(); ++level)
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, image.levelWidth(level), image.levelHeight(level), 0,
+            GLsizei(image.levelSize[level]), data + image.levelOffset[level]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelCount() - 1);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// S3TC is in every desktop driver but not in the loader's core profile list
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// What a texture holds decides its block format:
+//  - colour maps become BC1 (BC3 when the source has alpha), 4 or 8 bits per texel
+//  - normal maps become BC5, X and Y in two BC4 channels; Z = sqrt(1 - X^2 - Y^2) in the shader
+//  - masks (specular, clouds) become BC4, a single channel at 4 bits per texel
+enum TextureUsage
+{
+    TEXTURE_COLOR,
+    TEXTURE_NORMAL,
+    TEXTURE_MASK
+};
+
+// A block-compressed 2D texture with its full mip chain, as stored in a KTX 1.1 file. Rows run
+// bottom to top like the rest of the program's textures (stbi flipped on load).
+struct CompressedImage
+{
+    GLenum format = 0;
+    int width = 0, height = 0;
+    std::vector<unsigned char> data;         // every level, back to back
+    std::vector<size_t> levelOffset, levelSize;
+
+    int levelCount() const { return static_cast<int>(levelSize.size()); }
+    int levelWidth(int level) const { return std::max(1, width >> level); }
+    int levelHeight(int level) const { return std::max(1, height >> level); }
+};
+
+// cooked textures sit next to their source: earth_normal.jpg -> earth_normal.ktx
+std::string compressedTexturePath(const std::string& sourcePath);
+
+// the offline step: decode, build the mips, encode every level and write the KTX file
+bool compressTexture(const std::string& sourcePath, const std::string& ktxPath, TextureUsage usage);
+// reads a KTX file written by compressTexture (any 2D, single-face, block-compressed KTX 1.1)
+bool readCompressedTexture(const std::string& ktxPath, CompressedImage& image);
+
+// uploads all levels into the bound GL_TEXTURE_2D; data is an offset when a PBO is bound.
+// srgb has colour blocks (BC1/BC3) decoded from sRGB when sampled.
+void uploadCompressedTexture(const CompressedImage& image, const unsigned char* data, bool srgb = false);
@@ -0,0 +1,291 @@
+#include "TextureLoader.h"
+#include "GLState.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+    GLenum channelFormat(int channels)
+    {
+        switch (channels)
+        {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 4: return GL_RGBA;
+        default: return GL_RGB;
+        }
+    }
+
+    // sRGB only exists for colour; one or two channels stay as they are
+    GLenum internalFormat(int channels, bool srgb)
+    {
+        if (srgb && channels == 3)
+            return GL_SRGB8;
+        if (srgb && channels == 4)
+            return GL_SRGB8_ALPHA8;
+        return channelFormat(channels);
+    }
+
+    template <typename T>
+    bool ready(const std::future<T>& job)
+    {
+        return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+}
+
+TextureLoader::TextureLoader(ThreadPool& pool) :
+    maxUploadBytesPerFrame(64u << 20), pool(pool),
+    loadedCount(0), requestCount(0), completionMs(0.0)
+{
+}
+
+TextureLoader::~TextureLoader()
+{
+    for (Job& job : jobs)
+    {
+        if (job.decode.valid())
+            job.image = job.decode.get();
+        if (job.copy.valid())
+            job.copy.wait();
+        if (job.PBO != 0)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job.PBO);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &job.PBO);
+        }
+        if (job.image)
+            stbi_image_free(job.image->pixels);
+    }
+    jobs.clear();
+    retireUploads(true);
+}
+
+unsigned int TextureLoader::load(const std::string& path, const glm::vec4& placeholder, bool flip, bool srgb,
+    PixelsCallback onPixels)
+{
+    if (requestCount == 0)
+        firstRequest = std::chrono::steady_clock::now();
+    ++requestCount;
+
+    // a single texel of roughly the right colour until the image arrives
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    const unsigned char texel[4] = {
+        (unsigned char)(glm::clamp(placeholder.r, 0.0f, 1.0f) * 255.0f + 0.5f),
+        (unsigned char)(glm::clamp(placeholder.g, 0.0f, 1.0f) * 255.0f + 0.5f),
+        (unsigned char)(glm::clamp(placeholder.b, 0.0f, 1.0f) * 255.0f + 0.5f),
+        (unsigned char)(glm::clamp(placeholder.a, 0.0f, 1.0f) * 255.0f + 0.5f) };
+    GLState::get().bindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(4, srgb), 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+
+    Job job;
+    job.path = path;
+    job.texture = texture;
+    job.srgb = srgb;
+    job.onPixels = std::move(onPixels);
+    // cooked textures are stored bottom-up, so they only stand in for flipped loads
+    job.decode = submitDecode(pool, path, flip, flip, bool(job.onPixels));
+    jobs.push_back(std::move(job));
+    return texture;
+}
+
+void TextureLoader::decode(const std::string& path, PixelsCallback onPixels, bool flip)
+{
+    Job job;
+    job.path = path;
+    job.onPixels = std::move(onPixels);
+    job.decode = submitDecode(pool, path, flip, false, true);
+    jobs.push_back(std::move(job));
+}
+
+std::future<std::shared_ptr<TextureLoader::Image>> TextureLoader::submitDecode(ThreadPool& pool, const std::string& path,
+    bool flip, bool cooked, bool pixels)
+{
+    return pool.submit([path, flip, cooked, pixels]() {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto image = std::make_shared<Image>();
+        if (!(cooked && readCompressedTexture(compressedTexturePath(path), image->compressed)) || pixels)
+        {
+            // the flip flag is per thread here; the global one belongs to the GL thread
+            stbi_set_flip_vertically_on_load_thread(flip);
+            image->pixels = stbi_load(path.c_str(), &image->width, &image->height, &image->channels, 0);
+        }
+        image->decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return image;
+    });
+}
+
+void TextureLoader::retireUploads(bool wait)
+{
+    for (size_t i = 0; i < uploads.size();)
+    {
+        GLenum status = glClientWaitSync(uploads[i].fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            ++i;
+            continue;
+        }
+        glDeleteSync(uploads[i].fence);
+        glDeleteBuffers(1, &uploads[i].PBO);
+        uploads[i] = uploads.back();
+        uploads.pop_back();
+    }
+}
+
+void TextureLoader::specify(Job& job)
+{
+    const Image& image = *job.image;
+    const GLenum format = channelFormat(image.channels);
+
+    // sourced from the buffer, the calls return before the driver has read it
+    const unsigned char* data = image.data();
+    if (job.PBO != 0)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job.PBO);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        data = NULL;
+    }
+    GLState::get().bindTexture(GL_TEXTURE_2D, job.texture);
+    size_t bytes;
+    if (image.isCompressed())
+    {
+        // the mips come with the file
+        uploadCompressedTexture(image.compressed, data, job.srgb);
+        bytes = image.compressed.data.size();
+        compressedStats.count++;
+        compressedStats.bytes += bytes;
+        compressedStats.ms += image.decodeMs;
+    }
+    else
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(image.channels, job.srgb), image.width, image.height, 0, format,
+            GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // drivers pad three-channel textures to four bytes per texel; the mips add a third
+        bytes = size_t(image.width) * image.height * (image.channels == 3 ? 4 : image.channels) * 4 / 3;
+        decodedStats.count++;
+        decodedStats.bytes += bytes;
+        decodedStats.ms += image.decodeMs;
+    }
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+    if (job.PBO != 0)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uploads.push_back(Upload{ job.PBO, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+        job.PBO = 0;
+    }
+
+    stbi_image_free(job.image->pixels);
+    job.image.reset();
+    ++loadedCount;
+    uploaded.push_back(std::make_pair(job.texture, bytes));
+}
+
+void TextureLoader::update()
+{
+    retireUploads(false);
+
+    const size_t queued = jobs.size();
+    size_t bytes = 0;
+    for (auto it = jobs.begin(); it != jobs.end();)
+    {
+        Job& job = *it;
+        if (job.decode.valid() && ready(job.decode))
+        {
+            job.image = job.decode.get();
+            if (!job.image->pixels && !job.image->isCompressed())
+                std::cout << "Texture failed to load at path: " << job.path << std::endl;
+            if (job.onPixels)
+            {
+                const Image& image = *job.image;
+                job.onPixels(Pixels{ image.width, image.height, image.channels, image.pixels });
+            }
+            if (job.texture == 0 || (!job.image->pixels && !job.image->isCompressed()))
+            {
+                if (job.texture != 0)
+                    uploaded.push_back(std::make_pair(job.texture, size_t(0)));
+                stbi_image_free(job.image->pixels);
+                it = jobs.erase(it);
+                continue;
+            }
+        }
+
+        // decoded: start the copy into a PBO, a bounded amount per frame
+        const size_t size = job.image ? job.image->size() : 0;
+        if (job.image && job.PBO == 0 && (bytes == 0 || bytes + size <= maxUploadBytesPerFrame))
+        {
+            glGenBuffers(1, &job.PBO);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job.PBO);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+            job.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            bytes += size;
+            if (job.mapped)
+            {
+                // the mapped pointer is plain memory, so a worker can fill it
+                std::shared_ptr<Image> image = job.image;
+                void* target = job.mapped;
+                job.copy = pool.submit([image, target, size]() { std::memcpy(target, image->data(), size); });
+            }
+            else
+            {
+                // no mapping: upload straight from client memory
+                glDeleteBuffers(1, &job.PBO);
+                job.PBO = 0;
+                specify(job);
+                it = jobs.erase(it);
+                continue;
+            }
+        }
+
+        // copied: specify the texture from the PBO
+        if (job.copy.valid() && ready(job.copy))
+        {
+            job.copy.get();
+            specify(job);
+            it = jobs.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    if (queued > 0 && jobs.empty())
+        completionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - firstRequest).count();
+}
+
+std::vector<std::pair<unsigned int, size_t>> TextureLoader::takeUploaded()
+{
+    std::vector<std::pair<unsigned int, size_t>> result;
+    result.swap(uploaded);
+    return result;
+}
+
+void TextureLoader::finish()
+{
+    const size_t budget = maxUploadBytesPerFrame;
+    maxUploadBytesPerFrame = std::numeric_limits<size_t>::max();
+    while (!jobs.empty())
+    {
+        for (Job& job : jobs)
+        {
+            if (job.decode.valid())
+                job.decode.wait();
+            if (job.copy.valid())
+                job.copy.wait();
+        }
+        update();
+    }
+    maxUploadBytesPerFrame = budget;
+    retireUploads(true);
+}
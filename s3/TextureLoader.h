@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "TextureCompression.h"
+
+#include <glad/glad.h>
+#include <glm.hpp>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Loads image files into GL textures without holding up the frame.
+//
+// load() returns a texture name straight away, holding a 1x1 placeholder colour. The file is
+// decoded on the worker pool; when the pixels are ready, update() (GL thread, once a frame)
+// maps a pixel buffer object and a worker copies the pixels into it, then the texture is
+// specified from the buffer and a fence marks when the driver is done with it. The texture
+// name never changes, so whatever holds it just starts sampling the real image. Startup only
+// pays for creating the placeholders, whatever the number or size of the images.
+//
+// When a cooked .ktx sits next to the image (see compressTexture), its blocks and mips are
+// uploaded as they are and the image is never decoded.
+//
+// Colour maps are stored sRGB-encoded and loaded with srgb set, so sampling returns linear
+// values; data maps (normals, masks, heights) are read as they are.
+class TextureLoader
+{
+public:
+    // decoded 8-bit pixels, only valid during the callback they are passed to; data is NULL
+    // if the image couldn't be read
+    struct Pixels
+    {
+        int width, height, channels;
+        const unsigned char* data;
+    };
+    typedef std::function<void(const Pixels& pixels)> PixelsCallback;
+
+    explicit TextureLoader(ThreadPool& pool);
+    ~TextureLoader();
+
+    // flip follows stbi_set_flip_vertically_on_load, which the rest of the program sets
+    // onPixels, if given, also receives the decoded image (from update(), before the upload),
+    // so a CPU user of the same file doesn't decode it again; the source is decoded for it
+    // even when a cooked .ktx is what gets uploaded
+    unsigned int load(const std::string& path, const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), bool flip = true,
+        bool srgb = false, PixelsCallback onPixels = PixelsCallback());
+
+    // decodes on the pool without creating a texture, for images used on the CPU; onPixels
+    // runs on the GL thread from update()
+    void decode(const std::string& path, PixelsCallback onPixels, bool flip = true);
+
+    // moves finished decodes into PBOs and PBOs into textures; never waits on a fence
+    void update();
+    // blocks until every queued texture is uploaded (exit paths, benchmarks)
+    void finish();
+    // textures finished since the last call with their estimated video memory (0 if the load failed)
+    std::vector<std::pair<unsigned int, size_t>> takeUploaded();
+
+    // per path: textures, estimated video memory (mips included) and worker read/decode time
+    struct PathStats
+    {
+        size_t count = 0, bytes = 0;
+        double ms = 0.0;
+    };
+
+    size_t getPendingCount() const { return jobs.size(); }
+    size_t getLoadedCount() const { return loadedCount; }
+    size_t getRequestCount() const { return requestCount; }
+    double getDecodeMs() const { return compressedStats.ms + decodedStats.ms; }
+    const PathStats& getCompressedStats() const { return compressedStats; }
+    const PathStats& getDecodedStats() const { return decodedStats; }
+    // wall time from the first load() until the last texture was uploaded
+    double getCompletionMs() const { return completionMs; }
+
+    size_t maxUploadBytesPerFrame;   // PBO copies started per frame, at least one texture
+
+private:
+    struct Image
+    {
+        int width = 0, height = 0, channels = 0;
+        unsigned char* pixels = NULL;    // stbi allocation
+        CompressedImage compressed;      // used instead when a .ktx was found
+        double decodeMs = 0.0;
+
+        bool isCompressed() const { return compressed.format != 0; }
+        size_t size() const { return isCompressed() ? compressed.data.size() : size_t(width) * height * channels; }
+        const unsigned char* data() const { return isCompressed() ? compressed.data.data() : pixels; }
+    };
+
+    struct Job
+    {
+        std::string path;
+        unsigned int texture = 0;       // 0 for decode()
+        bool srgb = false;
+        PixelsCallback onPixels;
+        std::future<std::shared_ptr<Image>> decode;
+        std::shared_ptr<Image> image;
+        unsigned int PBO = 0;
+        void* mapped = NULL;
+        std::future<void> copy;          // worker memcpy into the mapped PBO
+    };
+
+    struct Upload
+    {
+        unsigned int PBO;
+        GLsync fence;
+    };
+
+    static std::future<std::shared_ptr<Image>> submitDecode(ThreadPool& pool, const std::string& path, bool flip, bool cooked,
+        bool pixels);
+    void specify(Job& job);
+    void retireUploads(bool wait);
+
+    ThreadPool& pool;
+    std::list<Job> jobs;
+    std::vector<Upload> uploads;     // PBOs the driver may still be reading
+    std::vector<std::pair<unsigned int, size_t>> uploaded;
+
+    size_t loadedCount, requestCount;
+    PathStats compressedStats, decodedStats;
+    double completionMs;
+    std::chrono::steady_clock::time_point firstRequest;
+};
@@ -0,0 +1,109 @@
+#include "TextureRegistry.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+
+#include <algorithm>
+
+TextureRegistry::TextureRegistry(ThreadPool& pool) :
+    budgetBytes(size_t(512) << 20), loader(pool), frame(0),
+    residentBytes(0), hits(0), misses(0), evictions(0)
+{
+}
+
+TextureRegistry::~TextureRegistry()
+{
+    // outstanding handles only keep the path and name; the textures go with the registry
+    for (auto& entry : entries)
+        GLState::get().deleteTextures(1, &entry.second->id);
+}
+
+std::string TextureRegistry::normalizePath(const std::string& path)
+{
+    std::string key = path;
+    std::replace(key.begin(), key.end(), '\\', '/');
+    return key;
+}
+
+TextureRegistry::Handle TextureRegistry::acquire(const std::string& path, const glm::vec4& placeholder, bool srgb,
+    TextureLoader::PixelsCallback onPixels)
+{
+    const std::string key = normalizePath(path);
+    auto found = entries.find(key);
+    if (found != entries.end())
+    {
+        ++hits;
+        found->second->lastReferenced = frame;
+        if (onPixels)
+            loader.decode(key, std::move(onPixels));
+        return found->second;
+    }
+
+    ++misses;
+    auto entry = std::make_shared<Entry>();
+    entry->path = key;
+    entry->id = loader.load(key, placeholder, true, srgb, std::move(onPixels));
+    entry->lastReferenced = frame;
+    entries[key] = entry;
+    byId[entry->id] = entry.get();
+    return entry;
+}
+
+void TextureRegistry::update()
+{
+    ++frame;
+    loader.update();
+    for (const auto& uploaded : loader.takeUploaded())
+    {
+        auto found = byId.find(uploaded.first);
+        if (found == byId.end())
+            continue;
+        found->second->bytes = uploaded.second;
+        found->second->loaded = true;
+        residentBytes += uploaded.second;
+    }
+
+    // the map holds one reference itself
+    for (auto& entry : entries)
+        if (entry.second.use_count() > 1)
+            entry.second->lastReferenced = frame;
+
+    while (residentBytes > budgetBytes)
+    {
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->second.use_count() > 1 || !it->second->loaded)
+                continue;
+            if (victim == entries.end() || it->second->lastReferenced < victim->second->lastReferenced)
+                victim = it;
+        }
+        if (victim == entries.end())
+            break;
+        GLState::get().deleteTextures(1, &victim->second->id);
+        residentBytes -= victim->second->bytes;
+        byId.erase(victim->second->id);
+        entries.erase(victim);
+        ++evictions;
+    }
+}
+
+void TextureRegistry::drawStats()
+{
+    size_t referenced = 0;
+    for (const auto& entry : entries)
+        if (entry.second.use_count() > 1)
+            ++referenced;
+    ImGui::Text("Textures: %zu (%zu in use), %.1f / %.0f MB, %zu hits, %zu evicted", entries.size(), referenced,
+        residentBytes / (1024.0 * 1024.0), budgetBytes / (1024.0 * 1024.0), hits, evictions);
+
+    if (loader.getPendingCount() > 0)
+        ImGui::Text("  %zu/%zu loaded, %zu decoding", loader.getLoadedCount(), loader.getRequestCount(), loader.getPendingCount());
+    else
+        ImGui::Text("  all loaded in %.0f ms (%.0f ms decoding)", loader.getCompletionMs(), loader.getDecodeMs());
+    const TextureLoader::PathStats& compressed = loader.getCompressedStats();
+    const TextureLoader::PathStats& decoded = loader.getDecodedStats();
+    ImGui::Text("  KTX: %zu, %.1f MB, %.0f ms; JPEG: %zu, %.1f MB, %.0f ms", compressed.count,
+        compressed.bytes / (1024.0 * 1024.0), compressed.ms, decoded.count, decoded.bytes / (1024.0 * 1024.0), decoded.ms);
+}
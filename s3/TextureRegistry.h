@@ -0,0 +1,61 @@
+#pragma once
+
+#include "TextureLoader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// The one place image files become GL textures. Every texture is keyed by its path, so a
+// file is decoded and uploaded once however many models and bodies use it.
+//
+// acquire() hands out a shared handle; the handle count is the reference count. A texture no
+// handle refers to stays cached (acquiring it again is free) until the textures together
+// exceed budgetBytes, then the least recently referenced unreferenced ones are deleted.
+// Loading goes through the TextureLoader, so a new texture shows its placeholder at first.
+class TextureRegistry
+{
+public:
+    struct Entry
+    {
+        std::string path;
+        unsigned int id = 0;
+        size_t bytes = 0;            // estimated video memory, known once uploaded
+        bool loaded = false;
+        uint64_t lastReferenced = 0;
+    };
+    typedef std::shared_ptr<const Entry> Handle;
+
+    explicit TextureRegistry(ThreadPool& pool);
+    ~TextureRegistry();
+
+    // srgb for colour maps (see TextureLoader); a path keeps the encoding it was first acquired with.
+    // onPixels gets the decoded image for use on the CPU: from the texture's own decode when
+    // this acquire loads it, from a separate decode when the texture was already there
+    Handle acquire(const std::string& path, const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
+        bool srgb = false, TextureLoader::PixelsCallback onPixels = TextureLoader::PixelsCallback());
+
+    // runs the loader, records finished sizes and evicts over budget (GL thread, once a frame)
+    void update();
+    void drawStats();
+
+    TextureLoader& getLoader() { return loader; }
+
+    size_t size() const { return entries.size(); }
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+    size_t getEvictions() const { return evictions; }
+
+    size_t budgetBytes;
+
+private:
+    static std::string normalizePath(const std::string& path);
+
+    TextureLoader loader;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+    std::unordered_map<unsigned int, Entry*> byId;
+    uint64_t frame;
+    size_t residentBytes, hits, misses, evictions;
+};
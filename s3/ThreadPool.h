@@ -0,0 +1,126 @@
+// ThreadPool.h
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads fed from a single task queue. Used for the CPU-heavy
+// batch jobs (transfer grids, screening, mesh and texture work) so they don't block the render loop.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // queues a task and returns a future for its result
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([packaged] { (*packaged)(); });
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    // runs body(i) for every i in [begin, end) split into chunks across the workers and waits
+    // for completion. The calling thread works on chunks as well so nested use cannot deadlock.
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, F&& body, size_t grain = 1)
+    {
+        if (end <= begin)
+            return;
+        size_t count = end - begin;
+        size_t chunk = std::max(grain, count / (size() * 4 + 1) + 1);
+        size_t chunkCount = (count + chunk - 1) / chunk;
+
+        struct Progress { std::atomic<size_t> next{ 0 }; std::atomic<size_t> done{ 0 }; };
+        auto progress = std::make_shared<Progress>();
+        // helpers that start after the last chunk was claimed never touch body, so the
+        // reference capture stays valid even if they outlive this call
+        auto runChunks = [progress, chunkCount, chunk, begin, end, &body] {
+            for (size_t c = progress->next++; c < chunkCount; c = progress->next++)
+            {
+                size_t first = begin + c * chunk;
+                size_t last = std::min(end, first + chunk);
+                for (size_t i = first; i < last; ++i)
+                    body(i);
+                progress->done++;
+            }
+        };
+
+        size_t helpers = std::min<size_t>(size(), chunkCount - 1);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.emplace(runChunks);
+            }
+            wake.notify_one();
+        }
+        runChunks();
+        // only wait for chunks that are already being worked on, never for queued helpers
+        while (progress->done.load() < chunkCount)
+            std::this_thread::yield();
+    }
+
+private:
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
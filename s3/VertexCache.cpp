@@ -0,0 +1,130 @@
+#include "VertexCache.h"
+
+#include <algorithm>
+
+std::vector<unsigned int> optimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return indices;
+
+    // vertex -> triangles adjacency (CSR)
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (unsigned int v : indices)
+        ++adjacencyStart[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+    std::vector<int> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = static_cast<int>(adjacencyStart[v + 1] - adjacencyStart[v]);
+
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    int timeStamp = cacheSize + 1;
+    size_t cursor = 0;
+    long fanning = 0;
+
+    while (fanning >= 0)
+    {
+        // emit every live triangle around the fanning vertex
+        candidates.clear();
+        for (unsigned int a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; ++a)
+        {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (timeStamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timeStamp++;
+            }
+            emitted[t] = true;
+        }
+
+        // next fanning vertex: the candidate that will still be in the cache after its
+        // remaining triangles are emitted, preferring the oldest such entry
+        long next = -1;
+        int best = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] <= 0)
+                continue;
+            int priority = 0;
+            if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = timeStamp - cacheTime[v];
+            if (priority > best)
+            {
+                best = priority;
+                next = v;
+            }
+        }
+
+        // dead end: back up through recently used vertices, then scan forward
+        while (next < 0 && !deadEnd.empty())
+        {
+            unsigned int d = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[d] > 0)
+                next = d;
+        }
+        while (next < 0 && cursor < vertexCount)
+        {
+            if (liveTriangles[cursor] > 0)
+                next = static_cast<long>(cursor);
+            ++cursor;
+        }
+        fanning = next;
+    }
+    return output;
+}
+
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+    // FIFO cache: a vertex is a hit if it entered within the last cacheSize misses
+    std::vector<long> enteredAt(vertexCount, -1000000000L);
+    long misses = 0;
+    for (unsigned int v : indices)
+    {
+        if (misses - enteredAt[v] > cacheSize)
+        {
+            enteredAt[v] = misses;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    unsigned int next = 0;
+    for (unsigned int& v : indices)
+    {
+        if (remap[v] == unused)
+            remap[v] = next++;
+        v = remap[v];
+    }
+    // unreferenced vertices go to the end
+    for (unsigned int& r : remap)
+        if (r == unused)
+            r = next++;
+    return remap;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Post-transform vertex cache tools for indexed triangle lists.
+
+// Tipsify (Sander, Nehab, Barczak 2007): reorders triangles so consecutive ones reuse
+// recently transformed vertices. Linear time; cacheSize is the target FIFO size.
+std::vector<unsigned int> optimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize = 16);
+
+// average cache miss ratio (transformed vertices per triangle) for a FIFO cache;
+// 0.5 is the ideal for large closed meshes, 3.0 the worst case
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize = 16);
+
+// renumbers vertices in first-use order so the vertex fetches follow the index order;
+// returns remap[oldIndex] = newIndex and rewrites indices in place
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
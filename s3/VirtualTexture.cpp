@@ -0,0 +1,629 @@
+#include "VirtualTexture.h"
+#include "GLState.h"
+
+#include <glad/glad.h>
+#include "imgui.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+    const char PACK_MAGIC[4] = { 'S', '3', 'V', 'T' };
+    const int32_t PACK_VERSION = 1;
+    const size_t PACK_HEADER_BYTES = 4 + 6 * sizeof(int32_t);
+
+    int nextPowerOfTwo(int value)
+    {
+        int result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    bool ready(const std::future<std::vector<unsigned char>>& job)
+    {
+        return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+}
+
+VirtualTexture::VirtualTexture(ThreadPool& pool, const std::string& sourcePath, const std::string& packPath) :
+    feedbackDivisor(8), maxUploadsPerFrame(8), cacheSlotsPerSide(16),
+    pool(pool), sourcePath(sourcePath), packPath(packPath),
+    tile(0), border(0), levelCount(0), tileBytes(0),
+    slotsPerSide(0), physicalTexture(0), indirectionTexture(0), frame(0),
+    feedbackFBO(0), feedbackTexture(0), feedbackWidth(0), feedbackHeight(0), feedbackIndex(0),
+    previousFramebuffer(0),
+    tilesUploaded(0), tilesEvicted(0), tilesRequested(0)
+{
+    feedbackPBO[0] = feedbackPBO[1] = 0;
+    feedbackFence[0] = feedbackFence[1] = 0;
+    previousViewport[0] = previousViewport[1] = previousViewport[2] = previousViewport[3] = 0;
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    if (cooking.valid())
+        cooking.wait();
+    close();
+}
+
+void VirtualTexture::waitForJobs()
+{
+    for (auto& job : loading)
+        job.second.wait();
+    loading.clear();
+}
+
+void VirtualTexture::close()
+{
+    waitForJobs();
+    if (physicalTexture != 0)
+    {
+        GLState::get().deleteTextures(1, &physicalTexture);
+        GLState::get().deleteTextures(1, &indirectionTexture);
+        physicalTexture = indirectionTexture = 0;
+    }
+    if (feedbackFBO != 0)
+    {
+        glDeleteFramebuffers(1, &feedbackFBO);
+        GLState::get().deleteTextures(1, &feedbackTexture);
+        glDeleteBuffers(2, feedbackPBO);
+        feedbackFBO = feedbackTexture = 0;
+        feedbackPBO[0] = feedbackPBO[1] = 0;
+        feedbackWidth = feedbackHeight = 0;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        if (feedbackFence[i])
+            glDeleteSync(feedbackFence[i]);
+        feedbackFence[i] = 0;
+    }
+    slots.clear();
+    resident.clear();
+    entries.clear();
+    tilesX.clear();
+    tilesY.clear();
+    levelOffset.clear();
+    levelCount = 0;
+}
+
+bool VirtualTexture::open()
+{
+    close();
+
+    std::ifstream file(packPath, std::ios::binary);
+    if (!file)
+        return false;
+    char magic[4];
+    int32_t header[6];
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || std::memcmp(magic, PACK_MAGIC, 4) != 0 || header[0] != PACK_VERSION)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::BAD_PACK " << packPath << std::endl;
+        return false;
+    }
+    tile = header[1];
+    border = header[2];
+    const int levels = header[3];
+    if (tile <= 0 || border < 0 || levels <= 0 || levels > 24 || header[4] <= 0 || header[5] <= 0)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::BAD_PACK " << packPath << std::endl;
+        return false;
+    }
+
+    tileBytes = size_t(tile + 2 * border) * (tile + 2 * border) * 3;
+    size_t tileCount = 0;
+    for (int level = 0; level < levels; ++level)
+    {
+        tilesX.push_back(level == 0 ? header[4] : std::max(1, tilesX.back() >> 1));
+        tilesY.push_back(level == 0 ? header[5] : std::max(1, tilesY.back() >> 1));
+        levelOffset.push_back(tileCount);
+        tileCount += size_t(tilesX.back()) * tilesY.back();
+    }
+    if (tilesX.back() != 1 || tilesY.back() != 1)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::BAD_PACK " << packPath << std::endl;
+        tilesX.clear();
+        tilesY.clear();
+        levelOffset.clear();
+        return false;
+    }
+    levelCount = levels;
+
+    // physical cache: a square of slots, each a tile with its border
+    const int slotSize = tile + 2 * border;
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    slotsPerSide = std::max(2, std::min(cacheSlotsPerSide, maxTextureSize / slotSize));
+    slots.assign(size_t(slotsPerSide) * slotsPerSide, Slot{ NO_TILE, 0, false });
+
+    glGenTextures(1, &physicalTexture);
+    GLState::get().bindTexture(GL_TEXTURE_2D, physicalTexture);
+    // tiles are the sRGB-encoded colour map; sampling decodes them
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, slotsPerSide * slotSize, slotsPerSide * slotSize, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // indirection: one texel per tile, one mip level per pyramid level
+    glGenTextures(1, &indirectionTexture);
+    GLState::get().bindTexture(GL_TEXTURE_2D, indirectionTexture);
+    for (int level = 0; level < levelCount; ++level)
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, tilesX[level], tilesY[level], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+
+    entries.resize(levelCount);
+    for (int level = 0; level < levelCount; ++level)
+        entries[level].assign(size_t(tilesX[level]) * tilesY[level] * 4, 0);
+
+    // the coarsest tile is the fallback for everything and never leaves the cache
+    std::vector<unsigned char> top = readTile(levelOffset[levelCount - 1]);
+    if (top.empty())
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::TILE_READ_FAILED " << packPath << std::endl;
+        close();
+        return false;
+    }
+    upload(tileKey(levelCount - 1, 0, 0), top, true);
+    return true;
+}
+
+void VirtualTexture::cookAsync()
+{
+    if (cooking.valid())
+        return;
+    std::string source = sourcePath, pack = packPath;
+    cooking = pool.submit([source, pack]() { return cookVirtualTexture(source, pack); });
+}
+
+size_t VirtualTexture::tileIndex(int level, int x, int y) const
+{
+    return levelOffset[level] + size_t(y) * tilesX[level] + x;
+}
+
+std::vector<unsigned char> VirtualTexture::readTile(size_t index) const
+{
+    // each call opens its own stream, so any number of workers can read at once
+    std::vector<unsigned char> texels(tileBytes);
+    std::ifstream file(packPath, std::ios::binary);
+    file.seekg(std::streamoff(PACK_HEADER_BYTES + index * tileBytes));
+    file.read(reinterpret_cast<char*>(texels.data()), std::streamsize(tileBytes));
+    if (!file)
+        texels.clear();
+    return texels;
+}
+
+void VirtualTexture::upload(uint64_t key, const std::vector<unsigned char>& texels, bool pinned)
+{
+    // a free slot, else the least recently seen tile that wasn't needed this frame
+    int slot = -1;
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        const Slot& candidate = slots[i];
+        if (candidate.key == NO_TILE)
+        {
+            slot = int(i);
+            break;
+        }
+        if (candidate.pinned || candidate.lastUsed >= frame)
+            continue;
+        if (slot < 0 || candidate.lastUsed < slots[slot].lastUsed)
+            slot = int(i);
+    }
+    if (slot < 0)
+        return;
+
+    Slot& target = slots[slot];
+    if (target.key != NO_TILE)
+    {
+        const uint64_t evicted = target.key;
+        resident.erase(evicted);
+        target.key = NO_TILE;
+        refreshIndirection(int(evicted >> 48), int(evicted & 0xFFFFFF), int((evicted >> 24) & 0xFFFFFF));
+        ++tilesEvicted;
+    }
+
+    const int slotSize = tile + 2 * border;
+    GLState::get().bindTexture(GL_TEXTURE_2D, physicalTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsPerSide) * slotSize, (slot / slotsPerSide) * slotSize,
+        slotSize, slotSize, GL_RGB, GL_UNSIGNED_BYTE, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+
+    target.key = key;
+    target.lastUsed = frame;
+    target.pinned = pinned;
+    resident[key] = slot;
+    refreshIndirection(int(key >> 48), int(key & 0xFFFFFF), int((key >> 24) & 0xFFFFFF));
+    ++tilesUploaded;
+}
+
+void VirtualTexture::refreshIndirection(int level, int x, int y)
+{
+    // walk down from the changed tile: each tile points at its own slot when resident and
+    // otherwise inherits its parent's entry, which is already up to date
+    GLState::get().bindTexture(GL_TEXTURE_2D, indirectionTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int l = level; l >= 0; --l)
+    {
+        const int x0 = x * tilesX[l] / tilesX[level], x1 = (x + 1) * tilesX[l] / tilesX[level];
+        const int y0 = y * tilesY[l] / tilesY[level], y1 = (y + 1) * tilesY[l] / tilesY[level];
+        for (int ty = y0; ty < y1; ++ty)
+        {
+            for (int tx = x0; tx < x1; ++tx)
+            {
+                unsigned char* entry = &entries[l][(size_t(ty) * tilesX[l] + tx) * 4];
+                auto found = resident.find(tileKey(l, tx, ty));
+                if (found != resident.end())
+                {
+                    entry[0] = (unsigned char)(found->second % slotsPerSide);
+                    entry[1] = (unsigned char)(found->second / slotsPerSide);
+                    entry[2] = (unsigned char)l;
+                    entry[3] = 255;
+                }
+                else if (l + 1 < levelCount)
+                {
+                    const int px = tx * tilesX[l + 1] / tilesX[l], py = ty * tilesY[l + 1] / tilesY[l];
+                    std::memcpy(entry, &entries[l + 1][(size_t(py) * tilesX[l + 1] + px) * 4], 4);
+                }
+            }
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, tilesX[l]);
+        glTexSubImage2D(GL_TEXTURE_2D, l, x0, y0, x1 - x0, y1 - y0, GL_RGBA, GL_UNSIGNED_BYTE,
+            &entries[l][(size_t(y0) * tilesX[l] + x0) * 4]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VirtualTexture::request(int level, int x, int y)
+{
+    // keep the tile and its resident ancestors fresh, and ask for the coarsest missing one;
+    // detail streams in a level at a time, so the fallback is never more than one level off
+    int missingLevel = -1, missingX = 0, missingY = 0;
+    for (int l = level; l < levelCount; ++l)
+    {
+        auto found = resident.find(tileKey(l, x, y));
+        if (found != resident.end())
+            slots[found->second].lastUsed = frame;
+        else
+        {
+            missingLevel = l;
+            missingX = x;
+            missingY = y;
+        }
+        if (l + 1 < levelCount)
+        {
+            x = x * tilesX[l + 1] / tilesX[l];
+            y = y * tilesY[l + 1] / tilesY[l];
+        }
+    }
+    if (missingLevel < 0)
+        return;
+
+    const uint64_t key = tileKey(missingLevel, missingX, missingY);
+    if (loading.count(key) || loading.size() >= size_t(pool.size()) * 2 + 2)
+        return;
+    const size_t index = tileIndex(missingLevel, missingX, missingY);
+    loading[key] = pool.submit([this, index]() { return readTile(index); });
+    ++tilesRequested;
+}
+
+void VirtualTexture::processFeedback(const unsigned char* pixels, int count)
+{
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < count; ++i)
+    {
+        const unsigned char* p = pixels + i * 4;
+        if (p[3] == 0)
+            continue;
+        const int level = std::min(int(p[3]) - 1, levelCount - 1);
+        const int x = p[0] | ((p[2] & 15) << 8);
+        const int y = p[1] | ((p[2] >> 4) << 8);
+        if (x < tilesX[level] && y < tilesY[level])
+            keys.push_back(tileKey(level, x, y));
+    }
+
+    // coarse levels first, so the in-flight limit never starves the fallbacks
+    std::sort(keys.begin(), keys.end(), std::greater<uint64_t>());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for (uint64_t key : keys)
+        request(int(key >> 48), int(key & 0xFFFFFF), int((key >> 24) & 0xFFFFFF));
+}
+
+void VirtualTexture::update()
+{
+    if (cooking.valid() && cooking.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        if (cooking.get())
+            open();
+        else
+            std::cout << "ERROR::VIRTUAL_TEXTURE::COOK_FAILED " << sourcePath << std::endl;
+    }
+    if (!isOpen())
+        return;
+    ++frame;
+
+    // feedback that has made it into a PBO by now, without waiting for any that hasn't
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!feedbackFence[i])
+            continue;
+        GLenum status = glClientWaitSync(feedbackFence[i], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            continue;
+        glDeleteSync(feedbackFence[i]);
+        feedbackFence[i] = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackPBO[i]);
+        const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            size_t(feedbackWidth) * feedbackHeight * 4, GL_MAP_READ_BIT);
+        if (pixels)
+        {
+            processFeedback(pixels, feedbackWidth * feedbackHeight);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // finished reads go into the cache, a few per frame to bound the upload cost
+    int uploads = 0;
+    for (auto it = loading.begin(); it != loading.end() && uploads < maxUploadsPerFrame;)
+    {
+        if (!ready(it->second))
+        {
+            ++it;
+            continue;
+        }
+        std::vector<unsigned char> texels = it->second.get();
+        if (!texels.empty())
+        {
+            upload(it->first, texels, false);
+            ++uploads;
+        }
+        it = loading.erase(it);
+    }
+}
+
+void VirtualTexture::beginFeedback(int screenWidth, int screenHeight)
+{
+    const int width = std::max(1, screenWidth / std::max(1, feedbackDivisor));
+    const int height = std::max(1, screenHeight / std::max(1, feedbackDivisor));
+    if (feedbackFBO == 0 || width != feedbackWidth || height != feedbackHeight)
+    {
+        if (feedbackFBO == 0)
+        {
+            glGenFramebuffers(1, &feedbackFBO);
+            glGenTextures(1, &feedbackTexture);
+            glGenBuffers(2, feedbackPBO);
+        }
+        // readbacks in flight were sized for the old target
+        for (int i = 0; i < 2; ++i)
+        {
+            if (feedbackFence[i])
+                glDeleteSync(feedbackFence[i]);
+            feedbackFence[i] = 0;
+        }
+        feedbackWidth = width;
+        feedbackHeight = height;
+
+        GLState::get().bindTexture(GL_TEXTURE_2D, feedbackTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLState::get().bindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER::VIRTUAL_TEXTURE_FEEDBACK_NOT_COMPLETE" << std::endl;
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackPBO[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size_t(width) * height * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFBO);
+    glViewport(0, 0, feedbackWidth, feedbackHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // no depth buffer here; nearer surfaces simply overwrite, which is close enough
+    GLState::get().disable(GL_DEPTH_TEST);
+}
+
+void VirtualTexture::endFeedback()
+{
+    // the copy into the PBO runs on the GPU; update() maps it once the fence has passed
+    if (!feedbackFence[feedbackIndex])
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackPBO[feedbackIndex]);
+        glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        feedbackFence[feedbackIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        feedbackIndex ^= 1;
+    }
+    GLState::get().enable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
+
+void VirtualTexture::bind(const Shader& shader, int unit, bool feedback) const
+{
+    GLState::get().bindTexture(unit, GL_TEXTURE_2D, physicalTexture);
+    GLState::get().bindTexture(unit + 1, GL_TEXTURE_2D, indirectionTexture);
+    GLState::get().activeTexture(0);
+
+    shader.setInt("vtPhysical", unit);
+    shader.setInt("vtIndirection", unit + 1);
+    shader.setVec2("vtTiles", glm::vec2(tilesX[0], tilesY[0]));
+    shader.setFloat("vtTileSize", float(tile));
+    shader.setFloat("vtBorder", float(border));
+    shader.setFloat("vtPhysicalSize", float(slotsPerSide * (tile + 2 * border)));
+    shader.setInt("vtMaxLevel", levelCount - 1);
+    // screen-space derivatives in the feedback target are feedbackDivisor times larger
+    shader.setFloat("vtLodBias", feedback ? -std::log2(float(std::max(1, feedbackDivisor))) : 0.0f);
+}
+
+void VirtualTexture::drawPanel()
+{
+    ImGui::Begin("Virtual Texture");
+
+    ImGui::TextWrapped("%s", packPath.c_str());
+    if (isOpen())
+    {
+        const int slotSize = tile + 2 * border;
+        const double physicalMB = double(slotsPerSide) * slotSize * slotsPerSide * slotSize * 3 / (1024.0 * 1024.0);
+        size_t indirectionTexels = 0;
+        for (int level = 0; level < levelCount; ++level)
+            indirectionTexels += size_t(tilesX[level]) * tilesY[level];
+
+        ImGui::Text("%d levels, %dx%d tiles of %d px (%dx%d texels)", levelCount, tilesX[0], tilesY[0], tile,
+            tilesX[0] * tile, tilesY[0] * tile);
+        ImGui::Text("Cache: %zu / %zu slots, %.1f MB", resident.size(), slots.size(), physicalMB);
+        ImGui::Text("Indirection: %.1f KB", indirectionTexels * 4 / 1024.0);
+        ImGui::Text("Loading: %zu", loading.size());
+        ImGui::Text("Requested %zu, uploaded %zu, evicted %zu", tilesRequested, tilesUploaded, tilesEvicted);
+        ImGui::Text("Feedback: %dx%d", feedbackWidth, feedbackHeight);
+        ImGui::SliderInt("Feedback divisor", &feedbackDivisor, 2, 32);
+        ImGui::SliderInt("Uploads per frame", &maxUploadsPerFrame, 1, 64);
+    }
+    else
+        ImGui::Text("No tile pack; the source texture is used as is.");
+
+    ImGui::SliderInt("Cache slots per side", &cacheSlotsPerSide, 4, 64);
+    if (isCooking())
+        ImGui::Text("Cooking...");
+    else if (ImGui::Button("Cook from source"))
+    {
+        close();
+        cookAsync();
+    }
+    ImGui::SameLine();
+    if (!isCooking() && ImGui::Button("Reopen"))
+        open();
+
+    ImGui::End();
+}
+
+bool cookVirtualTexture(const std::string& sourcePath, const std::string& packPath, int tileSize, int border)
+{
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* source = stbi_load(sourcePath.c_str(), &width, &height, &channels, 3);
+    if (!source)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::SOURCE_LOAD_FAILED " << sourcePath << std::endl;
+        return false;
+    }
+
+    // level 0: the source resampled (bilinear) to whole power-of-two tile counts
+    const int tiles0X = nextPowerOfTwo((width + tileSize - 1) / tileSize);
+    const int tiles0Y = nextPowerOfTwo((height + tileSize - 1) / tileSize);
+    int levelWidth = tiles0X * tileSize, levelHeight = tiles0Y * tileSize;
+    std::vector<unsigned char> level(size_t(levelWidth) * levelHeight * 3);
+    for (int y = 0; y < levelHeight; ++y)
+    {
+        const float sy = std::max(0.0f, (y + 0.5f) * height / levelHeight - 0.5f);
+        const int y0 = std::min(int(sy), height - 1), y1 = std::min(y0 + 1, height - 1);
+        const float fy = sy - y0;
+        for (int x = 0; x < levelWidth; ++x)
+        {
+            const float sx = std::max(0.0f, (x + 0.5f) * width / levelWidth - 0.5f);
+            const int x0 = std::min(int(sx), width - 1), x1 = (x0 + 1) % width;
+            const float fx = sx - x0;
+            for (int c = 0; c < 3; ++c)
+            {
+                const float top = source[(size_t(y0) * width + x0) * 3 + c] * (1.0f - fx) + source[(size_t(y0) * width + x1) * 3 + c] * fx;
+                const float bottom = source[(size_t(y1) * width + x0) * 3 + c] * (1.0f - fx) + source[(size_t(y1) * width + x1) * 3 + c] * fx;
+                level[(size_t(y) * levelWidth + x) * 3 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+    stbi_image_free(source);
+
+    std::ofstream file(packPath, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::PACK_WRITE_FAILED " << packPath << std::endl;
+        return false;
+    }
+    int levelCount = 1;
+    for (int tx = tiles0X, ty = tiles0Y; tx > 1 || ty > 1; tx = std::max(1, tx >> 1), ty = std::max(1, ty >> 1))
+        ++levelCount;
+    const int32_t header[6] = { PACK_VERSION, tileSize, border, levelCount, tiles0X, tiles0Y };
+    file.write(PACK_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    const int slotSize = tileSize + 2 * border;
+    std::vector<unsigned char> texels(size_t(slotSize) * slotSize * 3);
+    for (int l = 0; l < levelCount; ++l)
+    {
+        const int tilesX = levelWidth / tileSize, tilesY = levelHeight / tileSize;
+        for (int ty = 0; ty < tilesY; ++ty)
+        {
+            for (int tx = 0; tx < tilesX; ++tx)
+            {
+                // the border repeats the neighbours, so bilinear filtering never crosses a slot edge
+                for (int y = 0; y < slotSize; ++y)
+                {
+                    const int sy = std::max(0, std::min(levelHeight - 1, ty * tileSize + y - border));
+                    for (int x = 0; x < slotSize; ++x)
+                    {
+                        const int sx = ((tx * tileSize + x - border) % levelWidth + levelWidth) % levelWidth;
+                        std::memcpy(&texels[(size_t(y) * slotSize + x) * 3], &level[(size_t(sy) * levelWidth + sx) * 3], 3);
+                    }
+                }
+                file.write(reinterpret_cast<const char*>(texels.data()), std::streamsize(texels.size()));
+            }
+        }
+
+        if (l + 1 == levelCount)
+            break;
+        // box filter down to the next level, halving only the axes that still have tiles to spare
+        const int nextWidth = std::max(tileSize, levelWidth >> 1), nextHeight = std::max(tileSize, levelHeight >> 1);
+        const int factorX = levelWidth / nextWidth, factorY = levelHeight / nextHeight;
+        std::vector<unsigned char> next(size_t(nextWidth) * nextHeight * 3);
+        for (int y = 0; y < nextHeight; ++y)
+        {
+            for (int x = 0; x < nextWidth; ++x)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    int sum = 0;
+                    for (int dy = 0; dy < factorY; ++dy)
+                        for (int dx = 0; dx < factorX; ++dx)
+                            sum += level[((size_t(y) * factorY + dy) * levelWidth + x * factorX + dx) * 3 + c];
+                    next[(size_t(y) * nextWidth + x) * 3 + c] = (unsigned char)((sum + factorX * factorY / 2) / (factorX * factorY));
+                }
+            }
+        }
+        level.swap(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    if (!file)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE::PACK_WRITE_FAILED " << packPath << std::endl;
+        return false;
+    }
+    std::cout << "Cooked " << packPath << ": " << levelCount << " levels, " << tiles0X << "x" << tiles0Y << " tiles" << std::endl;
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Shader.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Virtual texturing for planet maps too large to keep in video memory.
+//
+// The map is cooked once into a tile pack (.s3vt): a mip pyramid cut into tiles of
+// tileSize^2 texels plus a border on each side, stored raw so any tile can be read with one
+// seek. At runtime only a fixed-size physical cache texture holds tiles, so video memory
+// stays the same for an 8k or a 64k map:
+//
+//  - the surfaces using the texture are drawn once more into a small feedback target that
+//    records, per pixel, the tile and mip level the real draw will want
+//  - the feedback is read back through a PBO a frame later and missing tiles are read from
+//    the pack on the worker pool, coarser ancestors first
+//  - finished tiles are copied into free (or least recently seen) cache slots and an
+//    indirection texture, one texel per tile and one mip level per pyramid level, points
+//    each tile at the finest resident tile that covers it
+//
+// The coarsest level is always resident, so every lookup finds something.
+class VirtualTexture
+{
+public:
+    VirtualTexture(ThreadPool& pool, const std::string& sourcePath, const std::string& packPath);
+    ~VirtualTexture();
+
+    // opens the pack and allocates the cache (GL thread); false if there is no pack yet
+    bool open();
+    void close();
+    bool isOpen() const { return levelCount > 0; }
+
+    // cooks the pack from the source image on the pool; update() opens it when done
+    void cookAsync();
+    bool isCooking() const { return cooking.valid(); }
+
+    // reads back older feedback, queues and uploads tiles, refreshes the indirection table
+    void update();
+
+    // feedback pass: draw the surfaces between these with a program that includes the
+    // feedback shader and has bind() applied; the previous framebuffer is restored
+    void beginFeedback(int screenWidth, int screenHeight);
+    void endFeedback();
+
+    // binds the cache and indirection textures to units `unit` and `unit + 1` and sets the
+    // vt* uniforms; feedback programs also get the lower feedback resolution as a LOD bias
+    void bind(const Shader& shader, int unit, bool feedback = false) const;
+
+    void drawPanel();
+
+    int tileSize() const { return tile; }
+    int feedbackDivisor;         // feedback target is the screen size divided by this
+    int maxUploadsPerFrame;
+    int cacheSlotsPerSide;       // takes effect on the next open()
+
+private:
+    struct Slot
+    {
+        uint64_t key;            // tile in this slot, NO_TILE if free
+        uint64_t lastUsed;
+        bool pinned;
+    };
+
+    static const uint64_t NO_TILE = ~0ull;
+    static uint64_t tileKey(int level, int x, int y) { return (uint64_t(level) << 48) | (uint64_t(y) << 24) | uint64_t(x); }
+
+    size_t tileIndex(int level, int x, int y) const;
+    std::vector<unsigned char> readTile(size_t index) const;
+    void upload(uint64_t key, const std::vector<unsigned char>& texels, bool pinned);
+    void request(int level, int x, int y);
+    void processFeedback(const unsigned char* pixels, int count);
+    // recomputes the indirection entries of a tile and everything below it
+    void refreshIndirection(int level, int x, int y);
+    void waitForJobs();
+
+    ThreadPool& pool;
+    std::string sourcePath, packPath;
+
+    // pack layout
+    int tile, border, levelCount;
+    std::vector<int> tilesX, tilesY;
+    std::vector<size_t> levelOffset;     // index of the level's first tile in the pack
+    size_t tileBytes;
+
+    // cache
+    int slotsPerSide;
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, int> resident;
+    std::unordered_map<uint64_t, std::future<std::vector<unsigned char>>> loading;
+    std::vector<std::vector<unsigned char>> entries;   // indirection texels per level
+    unsigned int physicalTexture, indirectionTexture;
+    uint64_t frame;
+
+    // feedback, double-buffered readback
+    unsigned int feedbackFBO, feedbackTexture;
+    int feedbackWidth, feedbackHeight;
+    unsigned int feedbackPBO[2];
+    GLsync feedbackFence[2];
+    int feedbackIndex;
+    int previousFramebuffer, previousViewport[4];
+
+    std::future<bool> cooking;
+
+    // stats
+    size_t tilesUploaded, tilesEvicted, tilesRequested;
+};
+
+// Writes the tile pack for an image: the source is resampled to a power-of-two number of
+// tiles per side and halved per level down to a single tile; x wraps and y clamps at the
+// borders, as an equirectangular map needs. The whole source is decoded in memory, so
+// this is an offline step (see --cook-virtual-texture).
+bool cookVirtualTexture(const std::string& sourcePath, const std::string& packPath, int tileSize = 128, int border = 4);
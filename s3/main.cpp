@@ -4,34 +4,77 @@
 #include "glm.hpp"
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
+#include <gtc/color_space.hpp>
 
 #include "Shader.h"
+#include "ShaderCache.h"
 #include "Camera.h"
 #include "Model.h"
 #include "Sphere.h"
+#include "SphereRenderer.h"
+#include "SphereBenchmark.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+#include "DepthMode.h"
+#include "Frustum.h"
+#include "OcclusionCuller.h"
+#include "PostProcess.h"
+#include "SceneFramebuffer.h"
 
 #include "spaceobject.h"
 #include "sun.h"
 #include "planet.h"
 
+#include "ThreadPool.h"
+#include "Porkchop.h"
+#include "Occultation.h"
+#include "Conjunction.h"
+#include "SceneGenerator.h"
+#include "SkyView.h"
+#include "PlanetTerrain.h"
+#include "VirtualTexture.h"
+#include "TextureRegistry.h"
+#include "TextureCompression.h"
+
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
-std::vector<glm::vec3> generateCircleVertices(float radius, int numSegments, glm::vec3 offset);
+void generateCircleVertices(float radius, int numSegments, glm::vec3 offset, glm::vec3* vertices);
 bool RaySphereIntersect(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, const glm::vec3& sphereCenter, float sphereRadius);
-void drawOrbitLine(float radius, int segments);
+void drawOrbitLine(StreamBuffer& stream, float radius, int segments);
+
+// render queue draws: the contexts live across the frame loop and are refreshed each frame
+struct EarthDraw
+{
+    Shader* shader;
+    const glm::mat4* model;
+    const VirtualTexture* virtualTexture;   // NULL when the colour map isn't virtual
+    OcclusionCuller* occlusion;
+    unsigned int indexCount;
+};
+struct SphereDraw
+{
+    SphereRenderer* renderer;
+    Shader* litShader;
+    glm::vec3 lightPos;                     // for SPHERE_LIT
+};
+void drawEarth(const void* context, uint32_t occlusionId);
+void drawSpheres(const void* context, uint32_t material);
 // settings
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
 bool wireframeMode = false;
+bool occlusionCulling = true;
 
 enum CullMode {
     CULL_BACK = GL_BACK,
@@ -39,8 +82,8 @@ enum CullMode {
 };
 
 void setCullMode(CullMode mode) {
-    glEnable(GL_CULL_FACE); // Enable face culling
-    glCullFace(mode);       // Set the cull mode
+    GLState::get().enable(GL_CULL_FACE); // Enable face culling
+    GLState::get().cullFace(mode);       // Set the cull mode
 }
 
 
@@ -63,15 +106,73 @@ bool smoothShading = true;
 float marsOffset = 0;
 float marsRotation = 90.0f;
 
-int main()
+// panels
+bool showPorkchop = false;
+bool showOccultations = false;
+bool showConjunctions = false;
+bool showSceneGenerator = false;
+bool showSkyView = false;
+bool showSphereBenchmark = false;
+bool showFlyover = false;
+bool showPostProcess = false;
+bool showVirtualTexture = false;
+
+// generated scene
+SceneGeneratorSettings sceneSettings;
+float sceneDaysPerSecond = 10.0f;
+
+// offline asset steps run from the command line instead of opening the window
+struct AssetArguments
 {
+    std::string virtualSource, virtualPack;
+    std::vector<std::pair<std::string, TextureUsage>> compress;
+
+    bool empty() const { return virtualSource.empty() && compress.empty(); }
+};
+
+bool parseSceneArguments(int argc, char** argv, std::string& scenePath, std::string& outputPath, bool& benchmark,
+    AssetArguments& assets);
+
+int main(int argc, char** argv)
+{
+    // stress scenes: --generate-scene <file> writes a scene and exits, --scene <file> loads one,
+    // --scene-benchmark times generation and propagation at 10 to 1M bodies;
+    // --cook-virtual-texture <image> <pack> writes a virtual texture tile pack and
+    // --compress-texture <image> <color|normal|mask> a block-compressed .ktx next to the image
+    std::string scenePath, sceneOutputPath;
+    bool sceneBenchmark = false;
+    AssetArguments assets;
+    if (!parseSceneArguments(argc, argv, scenePath, sceneOutputPath, sceneBenchmark, assets))
+        return -1;
+    if (!assets.empty())
+    {
+        bool ok = assets.virtualSource.empty() || cookVirtualTexture(assets.virtualSource, assets.virtualPack);
+        for (const auto& texture : assets.compress)
+            ok = compressTexture(texture.first, compressedTexturePath(texture.first), texture.second) && ok;
+        return ok ? 0 : -1;
+    }
+    if (sceneBenchmark)
+    {
+        ThreadPool pool;
+        benchmarkScenes(sceneSettings, pool);
+        return 0;
+    }
+    if (!sceneOutputPath.empty())
+    {
+        Scene generated = generateScene(sceneSettings);
+        if (!generated.save(sceneOutputPath))
+            return -1;
+        std::cout << "Wrote " << generated.size() << " bodies to " << sceneOutputPath << std::endl;
+        return 0;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    // no window multisampling: the 3D view is multisampled in its own framebuffer
 
     // glfw window creation
     // --------------------
@@ -103,8 +204,8 @@ int main()
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_MULTISAMPLE);
+    GLState::get().enable(GL_DEPTH_TEST);
+    GLState::get().enable(GL_MULTISAMPLE);
 
 
     std::vector<SpaceObject*> spaceObjects = {
@@ -120,25 +221,102 @@ int main()
         new Sun("Sun", 0.0f, 0, 10.0f, glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), 1.0f, "resources/textures/sun.jpg", "", "", "")
     };
 
+    // J2000 mean elements (a, e, I, L, long. perihelion, long. node) from the JPL approximate ephemerides
+    spaceObjects[0]->setOrbit(OrbitalElements::fromLongitudes(0.38709927, 0.20563593, 7.00497902, 252.25032350, 77.45779628, 48.33076593));
+    spaceObjects[1]->setOrbit(OrbitalElements::fromLongitudes(0.72333566, 0.00677672, 3.39467605, 181.97909950, 131.60246718, 76.67984255));
+    spaceObjects[2]->setOrbit(OrbitalElements::fromLongitudes(1.00000261, 0.01671123, -0.00001531, 100.46457166, 102.93768193, 0.0));
+    spaceObjects[3]->setOrbit(OrbitalElements::fromLongitudes(1.52371034, 0.09339410, 1.84969142, -4.55343205, -23.94362959, 49.55953891));
+    spaceObjects[4]->setOrbit(OrbitalElements::fromLongitudes(5.20288700, 0.04838624, 1.30439695, 34.39644051, 14.72847983, 100.47390909));
+    spaceObjects[5]->setOrbit(OrbitalElements::fromLongitudes(9.53667594, 0.05386179, 2.48599187, 49.95424423, 92.59887831, 113.66242448));
+    spaceObjects[6]->setOrbit(OrbitalElements::fromLongitudes(19.18916464, 0.04725744, 0.77263783, 313.23810451, 170.95427630, 74.01692503));
+    spaceObjects[7]->setOrbit(OrbitalElements::fromLongitudes(30.06992276, 0.00859048, 1.77004347, -55.12002969, 44.96476227, 131.78422574));
+
+    // worker threads for batch jobs
+    ThreadPool workerPool;
+    Porkchop porkchop(workerPool);
+    OccultationSearch occultations(workerPool);
+    ConjunctionScreening conjunctions(workerPool);
+
+    Scene scene;
+    double sceneDays = 0.0;
+
+    // sky from Earth's surface: the Sun, the planets and any generated heliocentric bodies
+    SkyView skyView(workerPool);
+    PlanetTerrain planetTerrain(workerPool);
+    skyView.generateStars(100000, 1);
+    auto refreshSkyBodies = [&]() {
+        std::vector<OrbitalElements> orbits(1);   // default elements sit at the Sun
+        for (int i = 0; i < 8; ++i)
+            orbits.push_back(spaceObjects[i]->getOrbit());
+        for (const SceneBody& body : scene.bodies)
+            if (body.parent < 0 && body.orbit.isValid())
+                orbits.push_back(body.orbit);
+        skyView.setBodies(orbits);
+    };
+    double sceneUpdateMs = 0.0, sceneInstanceMs = 0.0, sceneGenerateMs = 0.0;
+    static char scenePathBuffer[256] = "scene.s3scene";
+    if (!scenePath.empty() && scene.load(scenePath))
+    {
+        scene.uploadTextures(workerPool);
+        std::strncpy(scenePathBuffer, scenePath.c_str(), sizeof(scenePathBuffer) - 1);
+    }
+    refreshSkyBodies();
+
+    // the sphere's colour map streams from a tile pack when one has been cooked; the flyover
+    // still samples earthTexture
+    VirtualTexture earthVirtualTexture(workerPool, "resources/textures/planets/earth/earth_diffuse.jpg",
+        "resources/textures/planets/earth/earth_diffuse.s3vt");
+    earthVirtualTexture.open();
+
 
 
     // build and compile shaders
     // -------------------------
-    Shader ourShader("lighting.vs", "lighting.fs");
-    Shader earthShader("shaders/earth.vs", "shaders/earth.fs");
-    Shader skyboxShader("skybox.vs", "skybox.fs");
-    Shader sunShader("shaders/sun.vs", "shaders/sun.fs");
-
-    Shader moonShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader marsShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader jupiterShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader saturnShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader uranusShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader neptuneShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader venusShader("shaders/sun.vs", "shaders/sun.fs");
-    Shader mercuryShader("shaders/sun.vs", "shaders/sun.fs");
+    // identical programs are compiled once and shared
+    ShaderCache shaderCache;
+    std::shared_ptr<Shader> ourShader = shaderCache.get("lighting.vs", "lighting.fs");
+    std::shared_ptr<Shader> skyboxShader = shaderCache.get("skybox.vs", "skybox.fs");
+    std::shared_ptr<Shader> circleShader = shaderCache.get("circle.vs", "circle.fs");
+    // the terrain keeps its own depth range and never needs LOG_DEPTH
+    std::shared_ptr<Shader> terrainShader = shaderCache.get("shaders/terrain.vs", "shaders/terrain.fs");
+
+    // programs that write depth in the solar-system view are rebuilt (or fetched from the
+    // cache) with LOG_DEPTH whenever the depth mode switches to logarithmic
+    SceneDepth sceneDepth;
+    SceneFramebuffer sceneFramebuffer;
+    PostProcess postProcess(shaderCache);
+    DepthMode shaderDepthMode = DEPTH_MODE_COUNT;
+    bool shaderVirtualTexture = false;
+    std::shared_ptr<Shader> earthShader, earthFeedbackShader, emissiveShader, instancedEmissiveShader, bodyShader, occlusionShader;
+    auto loadDepthShaders = [&]() {
+        std::vector<std::string> defines = sceneDepth.shaderDefines();
+        earthFeedbackShader = shaderCache.get("shaders/earth.vs", "shaders/vt_feedback.fs", defines);
+        shaderVirtualTexture = earthVirtualTexture.isOpen();
+        std::vector<std::string> earthDefines = defines;
+        if (shaderVirtualTexture)
+            earthDefines.push_back("VIRTUAL_TEXTURE");
+        earthShader = shaderCache.get("shaders/earth.vs", "shaders/earth.fs", earthDefines);
+        // the sun, moon and planets all use the flat emissive program
+        emissiveShader = shaderCache.get("shaders/sun.vs", "shaders/sun.fs", defines);
+        instancedEmissiveShader = shaderCache.get("shaders/emissive.vs", "shaders/emissive.fs", defines);
+        bodyShader = shaderCache.get("shaders/body.vs", "shaders/body.fs", defines);
+        // sampler units never change; set once per program
+        earthShader->use();
+        earthShader->setInt("earthTexture", 0);
+        earthShader->setInt("earthNormalMap", 1);
+        earthShader->setInt("earthCloudTexture", 2);
+        earthShader->setInt("earthSpecular", 3);
+        bodyShader->use();
+        bodyShader->setInt("diffuseTextures", 0);
+        occlusionShader = shaderCache.get("shaders/occlusion.vs", "shaders/occlusion.fs", defines);
+        shaderDepthMode = sceneDepth.activeMode();
+    };
+    loadDepthShaders();
 
-    Shader circleShader("circle.vs", "circle.fs"); // Assuming you have a Shader class for loading shaders
+    // everything rewritten per frame (the frame uniforms, sphere instances, sky directions,
+    // orbit rings, the mouse ray) is written into one triple-buffered stream buffer; it starts
+    // with room for the default sky and grows with the scene
+    StreamBuffer streamBuffer(size_t(4) << 20);
 
 
     float skyboxVertices[] = {
@@ -198,7 +376,7 @@ int main()
     unsigned int skyboxVAO, skyboxVBO;
     glGenVertexArrays(1, &skyboxVAO);
     glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
+    GLState::get().bindVertexArray(skyboxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
@@ -207,17 +385,27 @@ int main()
     // load textures
 // -------------
 
-    unsigned int moonTexture = loadTexture("resources/textures/planets/moon/moon_diffuse.jpg");
-
-    unsigned int earthTexture = loadTexture("resources/textures/planets/earth/earth_diffuse.jpg");
-    unsigned int earthNormal = loadTexture("resources/textures/planets/earth/earth_normal.jpg");
-    unsigned int earthCloudTexture = loadTexture("resources/textures/planets/earth/earth_clouds.jpg");
-    unsigned int earthSpecular = loadTexture("resources/textures/planets/earth/earth_specular.jpg");
+    // decoded on the worker pool and uploaded over the next frames; until then each texture
+    // holds a placeholder texel (a flat normal for the normal map, no clouds, no specular)
+    TextureRegistry textureRegistry(workerPool);
+    TextureRegistry::Handle moonTexture = textureRegistry.acquire("resources/textures/planets/moon/moon_diffuse.jpg",
+        glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), true);
+
+    TextureRegistry::Handle earthTexture = textureRegistry.acquire("resources/textures/planets/earth/earth_diffuse.jpg", glm::vec4(0.2f, 0.3f, 0.5f, 1.0f), true);
+    TextureRegistry::Handle earthNormal = textureRegistry.acquire("resources/textures/planets/earth/earth_normal.jpg", glm::vec4(0.5f, 0.5f, 1.0f, 1.0f));
+    TextureRegistry::Handle earthCloudTexture = textureRegistry.acquire("resources/textures/planets/earth/earth_clouds.jpg", glm::vec4(0.0f));
+    // no elevation map ships with the textures; the inverted ocean mask of the specular map
+    // raises the continents and the terrain's noise adds the relief. The terrain gets the
+    // texture's own decode and uses noise alone until it arrives
+    TextureRegistry::Handle earthSpecular = textureRegistry.acquire("resources/textures/planets/earth/earth_specular.jpg", glm::vec4(0.0f),
+        false, [&planetTerrain](const TextureLoader::Pixels& pixels) { planetTerrain.setHeightmap(pixels, true); });
 
     // sun material
     // ------------
+    // emissive intensities are radiance relative to the reference white (1 = white at 0 EV);
+    // the HDR target keeps anything brighter and the bloom spreads it
     glm::vec3 sunEmissiveColor = glm::vec3(1.0f, 1.0f, 0.2f);
-    float sunEmissiveIntensity = 1.0f;
+    float sunEmissiveIntensity = 20.0f;
 
     glm::vec3 moonEmissiveColor = glm::vec3(1.0f, 1.0f, 1.0f);
     float moonEmissiveIntensity = 0.5f;
@@ -255,8 +443,8 @@ int main()
     // --------------------
 
 
-    skyboxShader.use();
-    skyboxShader.setInt("skybox", 0);
+    skyboxShader->use();
+    skyboxShader->setInt("skybox", 0);
     
 
     // load models
@@ -266,7 +454,6 @@ int main()
     glm::mat4 earthModelMatrix = glm::translate(glm::mat4(1.0f), earthPosition);
 
     // sun object
-    Sphere sun(.05f, 36, 16, true, 3);
     glm::vec3 sunPosition = glm::vec3(10.0f, 0.0f, 0.0f); // Position the sun at the center
     glm::mat4 sunModelMatrix = glm::translate(glm::mat4(1.0f), sunPosition);
 
@@ -275,36 +462,66 @@ int main()
 
 
     glm::vec3 moonPosition = glm::vec3(1.395f, 0.0f, 0.0f);
-    Sphere moon(0.025f, 24, 9, true, 3);
     glm::mat4 moonModelMatrix = glm::translate(glm::mat4(1.0f), moonPosition);
 
 
     // Mars
-    Sphere mars(0.05f, numSectors / 2, numStacks / 2, smoothShading, 3);
     glm::vec3 marsPosition = glm::vec3(10.0f - spaceObjects[3]->getOrbitRadius(), 0.0f, 0.0f);
 
     glm::mat4 marsModelMatrix = glm::translate(glm::mat4(1.0f), marsPosition);
 
     // Jupiter
-    Sphere jupiter(0.3f, numSectors, numStacks, smoothShading, 3);
     glm::vec3 jupiterPosition = glm::vec3(10.0f - spaceObjects[4]->getOrbitRadius(), 0.0f, 0.0f);
     glm::mat4 jupiterModelMatrix = glm::translate(glm::mat4(1.0f), jupiterPosition);
 
     // Saturn
-    Sphere saturn(0.25f, numSectors, numStacks, smoothShading, 3);
     glm::vec3 saturnPosition = glm::vec3(10.0f - spaceObjects[5]->getOrbitRadius(), 0.0f, 0.0f);
     glm::mat4 saturnModelMatrix = glm::translate(glm::mat4(1.0f), saturnPosition);
 
     // Uranus
-    Sphere uranus(0.2f, numSectors, numStacks, smoothShading, 3);
     glm::vec3 uranusPosition = glm::vec3(10.0f - spaceObjects[6]->getOrbitRadius(), 0.0f, 0.0f);
     glm::mat4 uranusModelMatrix = glm::translate(glm::mat4(1.0f), uranusPosition);
 
     // Neptune
-    Sphere neptune(0.2f, numSectors, numStacks, smoothShading, 3);
     glm::vec3 neptunePosition = glm::vec3(10.0f - spaceObjects[7]->getOrbitRadius(), 0.0f, 0.0f);
     glm::mat4 neptuneModelMatrix = glm::translate(glm::mat4(1.0f), neptunePosition);
 
+    // one unit sphere for every body except the Earth; display radii go into the instance matrices
+    SphereRenderer sphereRenderer(streamBuffer);
+    const float sunRadius = 0.05f, moonRadius = 0.025f, marsRadius = 0.05f, jupiterRadius = 0.3f;
+    const float saturnRadius = 0.25f, uranusRadius = 0.2f, neptuneRadius = 0.2f;
+    // current LOD level per body, kept between frames for hysteresis
+    int emissiveLod[7] = { 0 };
+    std::vector<unsigned char> sceneLod;
+    SphereBenchmark sphereBenchmark;
+
+    // the bodies' draws go through a sorted queue; each body shader's textures are one set
+    RenderQueue renderQueue;
+    const uint16_t earthTextureSet = renderQueue.addTextureSet({
+        { 0, GL_TEXTURE_2D, earthTexture->id }, { 1, GL_TEXTURE_2D, earthNormal->id },
+        { 2, GL_TEXTURE_2D, earthCloudTexture->id }, { 3, GL_TEXTURE_2D, earthSpecular->id } });
+    const uint16_t sceneTextureSet = renderQueue.addTextureSet({});
+    EarthDraw earthDraw;
+    SphereDraw sphereDraw = { &sphereRenderer, NULL, glm::vec3(0.0f) };
+
+    // bounding spheres culled against the view each frame; the body set is shared by the
+    // sphere draws, the orbit lines and picking
+    BoundingSpheres bodyBounds, sceneBounds;
+    std::vector<unsigned char> bodyVisible, sceneVisible;
+    const size_t moonBounds = spaceObjects.size();      // after one entry per space object
+    const size_t orbitBounds = moonBounds + 1;          // one ring per space object
+    size_t visibleBodies = 0, visibleOrbits = 0, visibleSceneBodies = 0;
+
+    // occlusion queries for the drawn bodies (by bounds index) and for the scene's planetary
+    // systems (by the index of the heliocentric body at their root); systems smaller than
+    // occlusionMinPixels on screen aren't worth a query
+    OcclusionCuller bodyOcclusion, sceneOcclusion;
+    const size_t occludeeBounds[] = { 2, 3, 4, 5, 6, 7, 8, moonBounds };
+    std::vector<size_t> sceneRoot;
+    std::vector<glm::vec3> systemMin, systemMax;
+    const float occlusionMinPixels = 4.0f;
+    size_t occludedSceneBodies = 0;
+
 
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -327,15 +544,15 @@ int main()
     const size_t maxFrames = 60;
     int currentCullModeIdx = 0; // 0 for GL_BACK, 1 for GL_FRONT
 
-    unsigned int circleVAO, circleVBO;
-    glGenVertexArrays(1, &circleVAO);
-    glGenBuffers(1, &circleVBO);
-    glBindVertexArray(circleVAO);
-
-
-
-
-
+    // transient lines read their vertices straight from the stream buffer; each draw picks its
+    // allocation with the first-vertex argument
+    unsigned int lineVAO;
+    glGenVertexArrays(1, &lineVAO);
+    GLState::get().bindVertexArray(lineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+    GLState::get().bindVertexArray(0);
 
     // render loop
     // -----------
@@ -356,13 +573,21 @@ int main()
             frameTimes.erase(frameTimes.begin());
         }
 
-        setCullMode(CULL_BACK);
+        GLState::get().beginFrame();
+        streamBuffer.beginFrame();
         // Calculate the average FPS
         float averageFPS = frameTimes.size() / totalTime;
 
         // input
         // -----
+        glm::vec3 cameraBefore = camera.Position;
         processInput(window);
+        // during a flyover the movement keys steer the terrain eye and the scene camera stays put
+        if (planetTerrain.isActive())
+        {
+            planetTerrain.move(camera.Position - cameraBefore);
+            camera.Position = cameraBefore;
+        }
         
         for (auto& planet : spaceObjects) {
             planet->update(deltaTime);
@@ -373,33 +598,59 @@ int main()
 
         // render
         // ------
-        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glEnable(GL_CULL_FACE);
-
-        switch (currentCullModeIdx) {
-        case 0:
-            glCullFace(GL_BACK);
-            break;
-        case 1:
-            glCullFace(GL_FRONT);
-            break;
-        default:
-            // You can set a default cull face or handle this case as needed
-            glCullFace(GL_BACK);
-            break;
-        }
+        textureRegistry.update();
+        earthVirtualTexture.update();
+        if (sceneDepth.activeMode() != shaderDepthMode || earthVirtualTexture.isOpen() != shaderVirtualTexture)
+            loadDepthShaders();
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        sceneDepth.apply();
+        sceneFramebuffer.begin(framebufferWidth, framebufferHeight, sceneDepth.clearDepth());
+
+        setCullMode(currentCullModeIdx == 1 ? CULL_FRONT : CULL_BACK);
 
         // don't forget to enable shader before setting uniforms
-        ourShader.use();
+        ourShader->use();
 
         // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 5000.0f); // Increase zFar to 5000.0f
+        glm::mat4 projection = sceneDepth.projection(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT);
 
         glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
+
+        FrameUniforms frameUniforms;
+        frameUniforms.view = view;
+        frameUniforms.projection = projection;
+        frameUniforms.viewProjection = projection * view;
+        frameUniforms.cameraPosition = glm::vec4(camera.Position, 1.0f);
+        frameUniforms.lightPosition = glm::vec4(sunPosition, 1.0f);
+        frameUniforms.lightColor = glm::vec4(sunEmissiveColor, sunEmissiveIntensity);
+        frameUniforms.depthParams = glm::vec4(sceneDepth.logCoefficient(), 0.0f, 0.0f, 0.0f);
+        streamBuffer.writeUniformBlock(FRAME_UNIFORM_BINDING, &frameUniforms, sizeof(frameUniforms));
+
+        // the benchmark draws (and clears) before anything of this frame is rendered
+        if (sphereBenchmark.requested())
+            sphereBenchmark.run(*emissiveShader, camera.Position, camera.Front, projection[1][1], (float)SCR_HEIGHT);
+
+        // frustum culling of the fixed bodies: each space object where it is drawn, the moon,
+        // then the orbit rings around the origin
+        Frustum frustum(projection * view);
+        bodyBounds.resize(orbitBounds + spaceObjects.size());
+        for (size_t i = 0; i < spaceObjects.size(); ++i)
+        {
+            bodyBounds.set(i, spaceObjects[i]->getPosition(), spaceObjects[i]->getRadius());
+            bodyBounds.set(orbitBounds + i, glm::vec3(0.0f), spaceObjects[i]->getOrbitRadius());
+        }
+        bodyBounds.set(2, earthPosition, sphere.getRadius());
+        bodyBounds.set(3, marsPosition, marsRadius);
+        bodyBounds.set(4, jupiterPosition, jupiterRadius);
+        bodyBounds.set(5, saturnPosition, saturnRadius);
+        bodyBounds.set(6, uranusPosition, uranusRadius);
+        bodyBounds.set(7, neptunePosition, neptuneRadius);
+        bodyBounds.set(8, sunPosition, sunRadius);
+        bodyBounds.set(moonBounds, moonPosition, moonRadius);
+        bodyVisible.resize(bodyBounds.size());
+        visibleBodies = cullSpheres(frustum, bodyBounds, 0, orbitBounds, bodyVisible.data());
+        visibleOrbits = cullSpheres(frustum, bodyBounds, orbitBounds, bodyBounds.size(), bodyVisible.data());
 
         double mouseX, mouseY;
         glfwGetCursorPos(window, &mouseX, &mouseY);
@@ -415,103 +666,216 @@ int main()
         glm::vec3 rayWorld = glm::vec3(glm::inverse(view) * rayEye);
         rayWorld = glm::normalize(rayWorld);
 
-        // Render the ray
-        glLineWidth(2.0f);
-        glBegin(GL_LINES);
-        glVertex3f(camera.Position.x, camera.Position.y, camera.Position.z);
-        glVertex3f(camera.Position.x + rayWorld.x * 100.0f, camera.Position.y + rayWorld.y * 100.0f, camera.Position.z + rayWorld.z * 100.0f);
-            
+        // the ray goes into the stream buffer now and is drawn with the orbit rings
+        const glm::vec3 rayVertices[2] = { camera.Position, camera.Position + rayWorld * 100.0f };
+        StreamBuffer::Allocation rayLine = streamBuffer.write(rayVertices, sizeof(rayVertices), sizeof(glm::vec3));
+
         // render the loaded model
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
-        ourShader.setMat4("model", model);
+        ourShader->setMat4("model", model);
         //ourModel.Draw(ourShader);
 
 
-        earthShader.use();
-        earthShader.setMat4("projection", projection);
-        earthShader.setMat4("view", view);
-        earthShader.setMat4("model", earthModelMatrix);
-        earthShader.setInt("earthTexture", 0);
-        earthShader.setInt("earthNormalMap", 1);
-        earthShader.setInt("earthCloudTexture", 2);
-        earthShader.setInt("earthSpecular", 3);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, earthTexture);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, earthNormal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, earthCloudTexture);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, earthSpecular);
-
-        sphere.draw();
-
-
-        // Update the sun's model matrix
-        sunModelMatrix = glm::translate(glm::mat4(1.0f), sunPosition);
-
-        // Render the sun
-        sunShader.use();
-        sunShader.setMat4("model", sunModelMatrix);
-        sunShader.setMat4("view", view);
-        sunShader.setMat4("projection", projection);
-        sunShader.setVec3("emissiveColor", sunEmissiveColor * sunEmissiveIntensity);
-        sun.draw();
-
-
-
-        // Render the moon
-        moonShader.use();
-        moonShader.setMat4("model", moonModelMatrix);
-        moonShader.setMat4("view", view);
-        moonShader.setMat4("projection", projection);
-        moonShader.setVec3("emissiveColor", moonEmissiveColor * moonEmissiveIntensity); // Set moon's emissive color
-        moon.draw();
-
-        marsShader.use();
-        marsShader.setMat4("model", spaceObjects[3]->getModelMatrix(marsModelMatrix));
-        marsShader.setMat4("view", view);
-        marsShader.setMat4("projection", projection);
-        marsShader.setVec3("emissiveColor", marsEmissiveColor * marsEmissiveIntensity);
-        mars.draw();
-
-
-
-        // Jupiter
-        jupiterShader.use();
-        jupiterShader.setMat4("model", spaceObjects[4]->getModelMatrix(jupiterModelMatrix));
-        jupiterShader.setMat4("view", view);
-        jupiterShader.setMat4("projection", projection);
-        jupiterShader.setVec3("emissiveColor", jupiterEmissiveColor* jupiterEmissiveIntensity);
-        jupiter.draw();
-
-        // Saturn
-        saturnShader.use();
-        saturnShader.setMat4("model", spaceObjects[5]->getModelMatrix(saturnModelMatrix));
-        saturnShader.setMat4("view", view);
-        saturnShader.setMat4("projection", projection);
-        saturnShader.setVec3("emissiveColor", saturnEmissiveColor* saturnEmissiveIntensity);
-        saturn.draw();
-
-        // Uranus
-        uranusShader.use();
-        uranusShader.setMat4("model", spaceObjects[6]->getModelMatrix(uranusModelMatrix));
-        uranusShader.setMat4("view", view);
-        uranusShader.setMat4("projection", projection);
-        uranusShader.setVec3("emissiveColor", uranusEmissiveColor* uranusEmissiveIntensity);
-        uranus.draw();
-
-        // Neptune
-        neptuneShader.use();
-        neptuneShader.setMat4("model", spaceObjects[7]->getModelMatrix(neptuneModelMatrix));
-        neptuneShader.setMat4("view", view);
-        neptuneShader.setMat4("projection", projection);
-        neptuneShader.setVec3("emissiveColor", neptuneEmissiveColor* neptuneEmissiveIntensity);
-        neptune.draw();
+        // from the surface only the sky is drawn
+        skyView.update(deltaTime, spaceObjects[2]->getOrbit());
+        if (skyView.isActive())
+        {
+            skyView.render(streamBuffer, projection, camera.Front, camera.Up);
+        }
+        else if (planetTerrain.isActive())
+        {
+            // the terrain has its own near and far planes
+            SceneDepth::restore();
+            planetTerrain.update(camera.Front, camera.Up, camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT);
+            planetTerrain.render(*terrainShader, sunPosition - earthPosition, earthTexture->id);
+        }
+        else
+        {
+            bodyOcclusion.enabled = sceneOcclusion.enabled = occlusionCulling;
+            bodyOcclusion.collect();
+            sceneOcclusion.collect();
+
+            // virtual texture feedback: which tiles of the colour map the sphere will sample
+            if (shaderVirtualTexture && bodyVisible[2])
+            {
+                earthVirtualTexture.beginFeedback(framebufferWidth, framebufferHeight);
+                earthFeedbackShader->use();
+                earthFeedbackShader->setMat4("model", earthModelMatrix);
+                earthVirtualTexture.bind(*earthFeedbackShader, 4, true);
+                sphere.draw();
+                earthVirtualTexture.endFeedback();
+            }
+
+            // the body draws are queued here and issued sorted by state after the scene is prepared
+            renderQueue.begin();
+            if (bodyVisible[2])
+            {
+                earthDraw = { earthShader.get(), &earthModelMatrix, shaderVirtualTexture ? &earthVirtualTexture : NULL,
+                    &bodyOcclusion, sphere.getIndexCount() };
+                renderQueue.submit(RENDER_PASS_OPAQUE, earthShader.get(), earthTextureSet, sphere.getVAO(),
+                    glm::length(earthPosition - camera.Position), drawEarth, &earthDraw, 2);
+            }
+
+
+            // Update the sun's model matrix
+            sunModelMatrix = glm::translate(glm::mat4(1.0f), sunPosition);
+
+            // the sun, moon and planets are one instanced draw
+            sphereRenderer.begin();
+            SphereLodChain& lodChain = sphereRenderer.getLodChain();
+            const float projectionScale = projection[1][1];
+            // the picked colours are sRGB; the scene is lit and blended in linear light
+            auto addEmissive = [&](int index, size_t bounds, const glm::mat4& modelMatrix, float radius, const glm::vec3& color, float intensity) {
+                if (!bodyVisible[bounds] || !bodyOcclusion.isVisible(bounds))
+                    return;
+                float pixels = projectedRadius(glm::vec3(modelMatrix[3]), radius, camera.Position, projectionScale, (float)SCR_HEIGHT);
+                emissiveLod[index] = lodChain.select(pixels, emissiveLod[index]);
+                sphereRenderer.add(SPHERE_EMISSIVE, emissiveLod[index], glm::scale(modelMatrix, glm::vec3(radius)),
+                    glm::vec4(glm::convertSRGBToLinear(color) * intensity, 1.0f));
+            };
+            addEmissive(0, 8, sunModelMatrix, sunRadius, sunEmissiveColor, sunEmissiveIntensity);
+            addEmissive(1, moonBounds, moonModelMatrix, moonRadius, moonEmissiveColor, moonEmissiveIntensity);
+            addEmissive(2, 3, spaceObjects[3]->getModelMatrix(marsModelMatrix), marsRadius, marsEmissiveColor, marsEmissiveIntensity);
+            addEmissive(3, 4, spaceObjects[4]->getModelMatrix(jupiterModelMatrix), jupiterRadius, jupiterEmissiveColor, jupiterEmissiveIntensity);
+            addEmissive(4, 5, spaceObjects[5]->getModelMatrix(saturnModelMatrix), saturnRadius, saturnEmissiveColor, saturnEmissiveIntensity);
+            addEmissive(5, 6, spaceObjects[6]->getModelMatrix(uranusModelMatrix), uranusRadius, uranusEmissiveColor, uranusEmissiveIntensity);
+            addEmissive(6, 7, spaceObjects[7]->getModelMatrix(neptuneModelMatrix), neptuneRadius, neptuneEmissiveColor, neptuneEmissiveIntensity);
+            renderQueue.submit(RENDER_PASS_OPAQUE, instancedEmissiveShader.get(), 0, 0, 0.0f, drawSpheres, &sphereDraw, SPHERE_EMISSIVE);
+
+            // generated scene
+            if (!scene.empty())
+            {
+                auto updateStart = std::chrono::steady_clock::now();
+                sceneDays += deltaTime * sceneDaysPerSecond;
+                scene.update(sceneDays, workerPool);
+                auto instanceStart = std::chrono::steady_clock::now();
+
+                // pick LODs and count per level for each block of bodies, then write the instances
+                // straight into the per-level queues at prefix-summed offsets
+                const int levelCount = lodChain.levelCount();
+                const size_t block = 16384;
+                const size_t blockCount = (scene.size() + block - 1) / block;
+                sceneLod.resize(scene.size(), 0);
+                sceneBounds.resize(scene.size());
+                sceneVisible.resize(scene.size());
+                if (sceneRoot.size() != scene.size())
+                {
+                    // parents precede their moons
+                    sceneRoot.resize(scene.size());
+                    for (size_t i = 0; i < scene.size(); ++i)
+                        sceneRoot[i] = scene.bodies[i].parent < 0 ? i : sceneRoot[scene.bodies[i].parent];
+                }
+                std::vector<size_t> blockOffsets(blockCount * levelCount, 0);
+                std::vector<size_t> blockVisible(blockCount, 0), blockOccluded(blockCount, 0);
+                workerPool.parallelFor(0, blockCount, [&](size_t b) {
+                    size_t first = b * block, last = std::min(scene.size(), (b + 1) * block);
+                    for (size_t i = first; i < last; ++i)
+                        sceneBounds.set(i, scene.positions[i], scene.bodies[i].radius);
+                    blockVisible[b] = cullSpheres(frustum, sceneBounds, first, last, sceneVisible.data());
+                    for (size_t i = first; i < last; ++i)
+                    {
+                        if (!sceneVisible[i])
+                            continue;
+                        if (!sceneOcclusion.isVisible(sceneRoot[i]))
+                        {
+                            sceneVisible[i] = 0;
+                            ++blockOccluded[b];
+                            continue;
+                        }
+                        float pixels = projectedRadius(scene.positions[i], scene.bodies[i].radius, camera.Position, projectionScale, (float)SCR_HEIGHT);
+                        sceneLod[i] = static_cast<unsigned char>(lodChain.select(pixels, sceneLod[i]));
+                        ++blockOffsets[b * levelCount + sceneLod[i]];
+                    }
+                });
+                for (int level = 0; level < levelCount; ++level)
+                {
+                    size_t total = 0;
+                    for (size_t b = 0; b < blockCount; ++b)
+                    {
+                        size_t count = blockOffsets[b * levelCount + level];
+                        blockOffsets[b * levelCount + level] = total;
+                        total += count;
+                    }
+                    sphereRenderer.instances(SPHERE_LIT, level).resize(total);
+                }
+                visibleSceneBodies = occludedSceneBodies = 0;
+                for (size_t b = 0; b < blockCount; ++b)
+                {
+                    visibleSceneBodies += blockVisible[b];
+                    occludedSceneBodies += blockOccluded[b];
+                }
+                workerPool.parallelFor(0, blockCount, [&](size_t b) {
+                    for (size_t i = b * block; i < std::min(scene.size(), (b + 1) * block); ++i)
+                    {
+                        if (!sceneVisible[i])
+                            continue;
+                        const SceneBody& body = scene.bodies[i];
+                        SphereInstance& instance = sphereRenderer.instances(SPHERE_LIT, sceneLod[i])[blockOffsets[b * levelCount + sceneLod[i]]++];
+                        instance.model = glm::scale(glm::translate(glm::mat4(1.0f), scene.positions[i]), glm::vec3(body.radius));
+                        instance.color = glm::vec4(body.color, 1.0f);
+                        instance.params = glm::vec4(static_cast<float>(body.texture), body.emissive, 0.0f, 0.0f);
+                    }
+                });
+
+                renderQueue.setTextureSet(sceneTextureSet, { { 0, GL_TEXTURE_2D_ARRAY, scene.textureArray } });
+                sphereDraw.litShader = bodyShader.get();
+                sphereDraw.lightPos = scene.positions[0];
+                renderQueue.submit(RENDER_PASS_OPAQUE, bodyShader.get(), sceneTextureSet, 0, 0.0f, drawSpheres, &sphereDraw, SPHERE_LIT);
+
+                auto instanceEnd = std::chrono::steady_clock::now();
+                sceneUpdateMs = std::chrono::duration<double, std::milli>(instanceStart - updateStart).count();
+                sceneInstanceMs = std::chrono::duration<double, std::milli>(instanceEnd - instanceStart).count();
+            }
+
+            renderQueue.execute();
+
+            // bounding boxes against this frame's depth; the answers are used next frame
+            bodyOcclusion.beginQueries(*occlusionShader, camera.Position, sceneDepth.nearPlane());
+            for (size_t bounds : occludeeBounds)
+            {
+                if (!bodyVisible[bounds])
+                    continue;
+                glm::vec3 center(bodyBounds.x[bounds], bodyBounds.y[bounds], bodyBounds.z[bounds]);
+                bodyOcclusion.query(bounds, center - bodyBounds.radius[bounds], center + bodyBounds.radius[bounds]);
+            }
+            bodyOcclusion.endQueries();
+
+            if (!scene.empty() && sceneOcclusion.enabled)
+            {
+                // one box around each planetary system
+                systemMin.resize(scene.size());
+                systemMax.resize(scene.size());
+                for (size_t i = 0; i < scene.size(); ++i)
+                {
+                    size_t root = sceneRoot[i];
+                    glm::vec3 extent(scene.bodies[i].radius);
+                    if (root == i)
+                    {
+                        systemMin[i] = scene.positions[i] - extent;
+                        systemMax[i] = scene.positions[i] + extent;
+                        continue;
+                    }
+                    systemMin[root] = glm::min(systemMin[root], scene.positions[i] - extent);
+                    systemMax[root] = glm::max(systemMax[root], scene.positions[i] + extent);
+                }
+
+                sceneOcclusion.beginQueries(*occlusionShader, camera.Position, sceneDepth.nearPlane());
+                for (size_t i = 0; i < scene.size(); ++i)
+                {
+                    if (sceneRoot[i] != i)
+                        continue;
+                    glm::vec3 center = (systemMin[i] + systemMax[i]) * 0.5f;
+                    float radius = glm::length(systemMax[i] - center);
+                    if (!frustum.intersectsSphere(center, radius) ||
+                        projectedRadius(center, radius, camera.Position, projection[1][1], (float)SCR_HEIGHT) < occlusionMinPixels)
+                        continue;
+                    sceneOcclusion.query(i, systemMin[i], systemMax[i]);
+                }
+                sceneOcclusion.endQueries();
+            }
+        }
 
         const char* cullModeItems[] = { "Front face", "Back Face" };
 
@@ -546,6 +910,15 @@ int main()
                 if (ImGui::MenuItem("Toggle Labels")) { /* Show or hide labels */ }
                 if (ImGui::MenuItem("Change Perspective")) { /* Switch viewing perspective */ }
                 if (ImGui::MenuItem("Show Orbits")) { /* Show or hide orbits */ }
+                ImGui::MenuItem("Porkchop Plot", NULL, &showPorkchop);
+                ImGui::MenuItem("Occultation Search", NULL, &showOccultations);
+                ImGui::MenuItem("Conjunction Screening", NULL, &showConjunctions);
+                ImGui::MenuItem("Scene Generator", NULL, &showSceneGenerator);
+                ImGui::MenuItem("Sky View", NULL, &showSkyView);
+                ImGui::MenuItem("Sphere Benchmark", NULL, &showSphereBenchmark);
+                ImGui::MenuItem("Surface Flyover", NULL, &showFlyover);
+                ImGui::MenuItem("HDR and Bloom", NULL, &showPostProcess);
+                ImGui::MenuItem("Virtual Texture", NULL, &showVirtualTexture);
                 ImGui::EndMenu();
             }
             if (ImGui::BeginMenu("Help")) {
@@ -570,25 +943,47 @@ int main()
         ImGui::SliderInt("Sectors", &numSectors, 3, 50);
         ImGui::Checkbox("Smooth shading", &smoothShading);
         ImGui::ColorEdit3("Emissive Color", glm::value_ptr(sunEmissiveColor));
-        ImGui::SliderFloat("Emissive Intensity", &sunEmissiveIntensity, 0.0f, 10.0f);
+        ImGui::SliderFloat("Emissive Intensity", &sunEmissiveIntensity, 0.01f, 1000.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        if (ImGui::TreeNode("Moon and planets")) {
+            ImGui::SliderFloat("Moon", &moonEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Mars", &marsEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Jupiter", &jupiterEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Saturn", &saturnEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Uranus", &uranusEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Neptune", &neptuneEmissiveIntensity, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::TreePop();
+        }
         ImGui::EndChild();
 
         // Add some spacing between child windows
         ImGui::Spacing();
 
         // Set a size for the second child window
-        ImGui::BeginChild("Program", ImVec2(0, 100), true);
+        ImGui::BeginChild("Program", ImVec2(0, 380), true);
         ImGui::Checkbox("Wireframe Mode", &wireframeMode);
         ImGui::Combo("Cull Mode", &currentCullModeIdx, cullModeItems, IM_ARRAYSIZE(cullModeItems));
         ImGui::SliderFloat("Mars orbit offset", &marsOffset, -5.0f, 5.0f);
-
-        // Change the actual OpenGL cull mode based on the selection
-        if (currentCullModeIdx == 0) {
-            setCullMode(CULL_BACK);
-        }
-        else if (currentCullModeIdx == 1) {
-            setCullMode(CULL_FRONT);
-        }
+        int depthMode = sceneDepth.mode;
+        const char* depthModeItems[] = { "Standard", "Reversed-Z", "Logarithmic" };
+        if (ImGui::Combo("Depth", &depthMode, depthModeItems, IM_ARRAYSIZE(depthModeItems)))
+            sceneDepth.mode = static_cast<DepthMode>(depthMode);
+        if (sceneDepth.mode != sceneDepth.activeMode())
+            ImGui::Text("No glClipControl (GL 4.5), using logarithmic depth");
+        ImGui::Text("Shader programs: %zu compiled for %zu requests", shaderCache.compileCount(), shaderCache.requestCount());
+        textureRegistry.drawStats();
+        renderQueue.drawStats();
+        GLState::get().drawStats();
+        streamBuffer.drawStats();
+        ImGui::Text("Sphere draws: %d for %zu bodies, %zu triangles", sphereRenderer.getDrawCalls(),
+            sphereRenderer.getInstanceCount(), sphereRenderer.getTriangleCount());
+        ImGui::SliderFloat("LOD error (px)", &sphereRenderer.getLodChain().tolerance, 0.1f, 4.0f);
+        ImGui::Text("Culled: %zu/%zu bodies, %zu/%zu orbits, %zu/%zu scene bodies",
+            orbitBounds - visibleBodies, orbitBounds, spaceObjects.size() - visibleOrbits, spaceObjects.size(),
+            scene.size() - std::min(visibleSceneBodies, scene.size()), scene.size());
+        ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+        ImGui::Text("Occluded: %zu bodies, %zu scene bodies (%zu queries)",
+            bodyOcclusion.getOccludedCount(), occludedSceneBodies,
+            bodyOcclusion.getQueryCount() + sceneOcclusion.getQueryCount());
 
         ImGui::EndChild();
 
@@ -612,18 +1007,108 @@ int main()
 
         ImGui::End();
 
+        porkchop.update();
+        if (showPorkchop) {
+            porkchop.drawPanel(spaceObjects);
+        }
+
+        occultations.update();
+        if (showOccultations) {
+            occultations.drawPanel(spaceObjects[2]->getOrbit());
+        }
+
+        conjunctions.update();
+        if (showConjunctions) {
+            conjunctions.drawPanel();
+        }
+
+        if (showPostProcess) {
+            postProcess.drawPanel();
+        }
+
+        if (showVirtualTexture) {
+            earthVirtualTexture.drawPanel();
+        }
+
+        if (showSkyView) {
+            skyView.drawPanel();
+        }
+
+        if (showSphereBenchmark) {
+            sphereBenchmark.drawPanel();
+        }
+
+        if (showFlyover) {
+            planetTerrain.drawPanel();
+        }
+
+        if (showSceneGenerator) {
+            ImGui::Begin("Scene Generator");
+            int seed = static_cast<int>(sceneSettings.seed);
+            if (ImGui::InputInt("Seed", &seed))
+                sceneSettings.seed = static_cast<uint64_t>(seed);
+            ImGui::InputInt("Bodies", &sceneSettings.bodyCount, 100, 10000);
+            ImGui::SliderInt("Moons per body", &sceneSettings.moonsPerBody, 0, 16);
+            ImGui::SliderInt("Textures", &sceneSettings.textureCount, 0, 64);
+            ImGui::SliderInt("Texture size", &sceneSettings.textureResolution, 16, 4096);
+            const char* distributions[] = { "Uniform", "Log-uniform", "Belt" };
+            int distribution = sceneSettings.distribution;
+            if (ImGui::Combo("Orbits", &distribution, distributions, IM_ARRAYSIZE(distributions)))
+                sceneSettings.distribution = static_cast<OrbitDistribution>(distribution);
+            ImGui::DragFloatRange2("Orbit range (AU)", &sceneSettings.minOrbit, &sceneSettings.maxOrbit, 0.1f, 0.01f, 1000.0f);
+            ImGui::SliderFloat("Max eccentricity", &sceneSettings.maxEccentricity, 0.0f, 0.9f);
+            ImGui::SliderFloat("Max inclination", &sceneSettings.maxInclination, 0.0f, 90.0f);
+            sceneSettings.bodyCount = std::max(sceneSettings.bodyCount, 0);
+
+            if (ImGui::Button("Generate")) {
+                auto start = std::chrono::steady_clock::now();
+                scene.releaseTextures();
+                scene = generateScene(sceneSettings);
+                scene.uploadTextures(workerPool);
+                sceneOcclusion.reset();
+                sceneRoot.clear();
+                sceneDays = 0.0;
+                refreshSkyBodies();
+                sceneGenerateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Clear")) {
+                scene.releaseTextures();
+                scene = Scene();
+                sceneOcclusion.reset();
+                sceneRoot.clear();
+                refreshSkyBodies();
+            }
+
+            ImGui::InputText("File", scenePathBuffer, sizeof(scenePathBuffer));
+            if (ImGui::Button("Save"))
+                scene.save(scenePathBuffer);
+            ImGui::SameLine();
+            if (ImGui::Button("Load") && scene.load(scenePathBuffer)) {
+                scene.uploadTextures(workerPool);
+                sceneOcclusion.reset();
+                sceneRoot.clear();
+                sceneDays = 0.0;
+                refreshSkyBodies();
+            }
+
+            ImGui::SliderFloat("Days per second", &sceneDaysPerSecond, 0.0f, 365.0f);
+            ImGui::Text("%zu bodies, %zu textures", scene.size(), scene.textures.size());
+            ImGui::Text("Generate + upload: %.2f ms", sceneGenerateMs);
+            ImGui::Text("Propagate: %.2f ms, cull + instance build: %.2f ms", sceneUpdateMs, sceneInstanceMs);
+            ImGui::End();
+        }
+
 
         static int prevStacks = numStacks;
         if (numStacks != prevStacks) {
             sphere.setStackCount(numStacks);
-            sphere.buildVerticesSmooth();
             prevStacks = numStacks;
         }
 
         static int prevSectors = numSectors;
         if (numSectors != prevSectors) {
             sphere.setSectorCount(numSectors);
-            sphere.buildVerticesSmooth();
             prevSectors = numSectors;
         }
 
@@ -638,12 +1123,15 @@ int main()
         glm::vec3 rayDirection = rayWorld;     // Assuming rayWorld is the ray direction
 
 
-        // Check for intersection with each planet
-        for (const auto& planet : spaceObjects) {
+        // Check for intersection with each planet; bodies outside the view can't be under the cursor
+        for (size_t i = 0; i < spaceObjects.size(); ++i) {
+            if (!bodyVisible[i])
+                continue;
             // Check if the current space object is a planet
-            if (auto* p = dynamic_cast<Planet*>(planet)) {
-                // Perform ray-sphere intersection test
-                if (RaySphereIntersect(rayOrigin, rayDirection, p->getPosition(), p->getRadius())) {
+            if (auto* p = dynamic_cast<Planet*>(spaceObjects[i])) {
+                // Perform ray-sphere intersection test against the sphere as drawn
+                glm::vec3 center(bodyBounds.x[i], bodyBounds.y[i], bodyBounds.z[i]);
+                if (RaySphereIntersect(rayOrigin, rayDirection, center, bodyBounds.radius[i])) {
                     // Collision detected, handle it (e.g., show information about the planet)
                     ImGui::OpenPopup(p->getName().c_str());
                     if (ImGui::BeginPopupModal(p->getName().c_str(), NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
@@ -653,28 +1141,38 @@ int main()
                 }
             }
         }
-        sunShader.use();
+        emissiveShader->use();
+        GLState::get().bindVertexArray(lineVAO);
+        // the stream buffer is replaced when it grows
+        glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        // the ray and the rings are streamed in world space, drawn in grey
+        emissiveShader->setMat4("model", glm::mat4(1.0f));
+        emissiveShader->setVec3("emissiveColor", glm::convertSRGBToLinear(glm::vec3(0.5f)));
+        glLineWidth(2.0f);
+        if (rayLine.pointer)
+            glDrawArrays(GL_LINES, static_cast<GLint>(rayLine.offset / sizeof(glm::vec3)), 2);
         // for each planet that has orbiting enabled, draw the orbit line
-        for (const auto& planet : spaceObjects) {
-            if (auto* p = dynamic_cast<Planet*>(planet)) {
-                if (p->getOrbiting()) {
-					drawOrbitLine(p->getOrbitRadius(), 24);
+        for (size_t i = 0; i < spaceObjects.size(); ++i) {
+            if (auto* p = dynamic_cast<Planet*>(spaceObjects[i])) {
+                if (p->getOrbiting() && bodyVisible[orbitBounds + i]) {
+					drawOrbitLine(streamBuffer, p->getOrbitRadius(), 24);
 				}
 			}
 		}
    
 
 
+        SceneDepth::restore();
+        sceneFramebuffer.end();
+        postProcess.render(sceneFramebuffer.getTexture(), sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight());
+
         // Rendering ImGui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-        if (wireframeMode) {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        }
-        else {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        }
+        GLState::get().polygonMode(wireframeMode ? GL_LINE : GL_FILL);
+        streamBuffer.endFrame();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -691,36 +1189,51 @@ int main()
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &skyboxVAO);
+    GLState::get().deleteVertexArrays(1, &skyboxVAO);
     glDeleteBuffers(1, &skyboxVBO);
+    shaderCache.clear();
+    GLState::get().deleteVertexArrays(1, &lineVAO);
 
     glfwTerminate();
     return 0;
 }
 
-void drawOrbitLine( float radius, int segments) {
-
-    glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f);
-
-    unsigned int orbitVAO, orbitVBO;
+// the Earth sphere, skipped by the GPU if its occlusion query found it hidden; the queue has
+// bound the program, the Earth's textures and the sphere VAO
+void drawEarth(const void* context, uint32_t occlusionId)
+{
+    const EarthDraw& draw = *static_cast<const EarthDraw*>(context);
+    draw.shader->setMat4("model", *draw.model);
+    if (draw.virtualTexture)
+        draw.virtualTexture->bind(*draw.shader, 4);
+    draw.occlusion->beginConditional(occlusionId);
+    glDrawElements(GL_TRIANGLES, draw.indexCount, GL_UNSIGNED_INT, 0);
+    draw.occlusion->endConditional();
+}
 
-    std::vector<glm::vec3> orbitVertices = generateCircleVertices(radius, segments, center);
-    
-    glGenVertexArrays(1, &orbitVAO);
-    glGenBuffers(1, &orbitVBO);
-    glBindVertexArray(orbitVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
-    glBufferData(GL_ARRAY_BUFFER, orbitVertices.size() * sizeof(glm::vec3), orbitVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+// one material's instanced spheres, with the program bound by the queue
+void drawSpheres(const void* context, uint32_t material)
+{
+    const SphereDraw& draw = *static_cast<const SphereDraw*>(context);
+    if (material == SPHERE_LIT)
+        draw.litShader->setVec3("lightPos", draw.lightPos);
+    draw.renderer->draw(static_cast<SphereMaterial>(material));
+}
 
+// draws a ring around the origin from the stream buffer; the line VAO has to be bound
+void drawOrbitLine(StreamBuffer& stream, float radius, int segments) {
 
+    glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f);
 
+    // the vertices are generated straight into this frame's part of the stream buffer
+    StreamBuffer::Allocation orbit = stream.allocate(segments * sizeof(glm::vec3), sizeof(glm::vec3));
+    if (!orbit.pointer)
+        return;
+    generateCircleVertices(radius, segments, center, static_cast<glm::vec3*>(orbit.pointer));
+    stream.commit(orbit);
 
     // Render the orbit circle
-    glBindVertexArray(orbitVAO);
-    glDrawArrays(GL_LINE_LOOP, 0, segments);
-
+    glDrawArrays(GL_LINE_LOOP, static_cast<GLint>(orbit.offset / sizeof(glm::vec3)), segments);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -801,47 +1314,7 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 
 
 
-// the loadTexture function is to load a texture from a file path into a texture object in OpenGL
-unsigned int loadTexture(const char* path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true); // Flip the textures on the y-axis
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-std::vector<glm::vec3> generateCircleVertices(float radius, int numSegments, glm::vec3 offset) {
-    std::vector<glm::vec3> vertices;
+void generateCircleVertices(float radius, int numSegments, glm::vec3 offset, glm::vec3* vertices) {
 
     // define the angle between each segment
     float angleIncrement = 2.0f * glm::pi<float>() / numSegments;
@@ -853,9 +1326,8 @@ std::vector<glm::vec3> generateCircleVertices(float radius, int numSegments, glm
         float x = radius * glm::cos(angle) + offset.x;
         float y = offset.y;
         float z = radius * glm::sin(angle) + offset.z;
-        vertices.push_back(glm::vec3(x, y, z));
+        vertices[i] = glm::vec3(x, y, z);
     }
-    return vertices;
 }
 
 
@@ -885,3 +1357,76 @@ bool RaySphereIntersect(const glm::vec3& rayOrigin, const glm::vec3& rayDirectio
 
     return true;
 }
+
+// reads the stress scene options; the generator settings go straight into sceneSettings
+// ---------------------------------------------------------------------------------------
+bool parseSceneArguments(int argc, char** argv, std::string& scenePath, std::string& outputPath, bool& benchmark,
+    AssetArguments& assets)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--scene-benchmark") {
+            benchmark = true;
+            continue;
+        }
+        if (arg == "--cook-virtual-texture") {
+            if (i + 2 >= argc) {
+                std::cout << "Usage: --cook-virtual-texture <image> <pack>" << std::endl;
+                return false;
+            }
+            assets.virtualSource = argv[++i];
+            assets.virtualPack = argv[++i];
+            continue;
+        }
+        if (arg == "--compress-texture") {
+            if (i + 2 >= argc) {
+                std::cout << "Usage: --compress-texture <image> <color|normal|mask>" << std::endl;
+                return false;
+            }
+            std::string image = argv[++i], usage = argv[++i];
+            if (usage == "color") assets.compress.push_back(std::make_pair(image, TEXTURE_COLOR));
+            else if (usage == "normal") assets.compress.push_back(std::make_pair(image, TEXTURE_NORMAL));
+            else if (usage == "mask") assets.compress.push_back(std::make_pair(image, TEXTURE_MASK));
+            else {
+                std::cout << "Unknown texture usage " << usage << " (color, normal, mask)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--scene")
+            scenePath = value;
+        else if (arg == "--generate-scene")
+            outputPath = value;
+        else if (arg == "--seed")
+            sceneSettings.seed = std::strtoull(value, NULL, 10);
+        else if (arg == "--bodies")
+            sceneSettings.bodyCount = std::atoi(value);
+        else if (arg == "--moons")
+            sceneSettings.moonsPerBody = std::atoi(value);
+        else if (arg == "--textures")
+            sceneSettings.textureCount = std::atoi(value);
+        else if (arg == "--texture-size")
+            sceneSettings.textureResolution = std::atoi(value);
+        else if (arg == "--orbits") {
+            std::string name = value;
+            if (name == "uniform") sceneSettings.distribution = ORBITS_UNIFORM;
+            else if (name == "log") sceneSettings.distribution = ORBITS_LOG_UNIFORM;
+            else if (name == "belt") sceneSettings.distribution = ORBITS_BELT;
+            else {
+                std::cout << "Unknown orbit distribution " << name << " (uniform, log, belt)" << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cout << "Unknown argument " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
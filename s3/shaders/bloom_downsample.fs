@@ -0,0 +1,51 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 texelSize;     // of the source
+uniform bool firstLevel;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Karis average: weighting each block by 1 / (1 + luma) keeps single very bright pixels
+// from flickering in and out of the glow
+vec3 block(vec3 a, vec3 b, vec3 c, vec3 d, out float weight)
+{
+    vec3 sum = (a + b + c + d) * 0.25;
+    weight = firstLevel ? 1.0 / (1.0 + luminance(sum)) : 1.0;
+    return sum * weight;
+}
+
+// 13 bilinear taps as five overlapping 2x2 blocks (Jimenez, "Next Generation Post
+// Processing in Call of Duty: Advanced Warfare")
+void main()
+{
+    vec2 t = texelSize;
+    vec3 a = texture(source, TexCoords + t * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(source, TexCoords + t * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(source, TexCoords + t * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(source, TexCoords + t * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(source, TexCoords).rgb;
+    vec3 f = texture(source, TexCoords + t * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(source, TexCoords + t * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(source, TexCoords + t * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(source, TexCoords + t * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(source, TexCoords + t * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(source, TexCoords + t * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(source, TexCoords + t * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(source, TexCoords + t * vec2( 1.0, -1.0)).rgb;
+
+    float w0, w1, w2, w3, w4;
+    vec3 sum = block(j, k, l, m, w0) * 0.5
+             + block(a, b, d, e, w1) * 0.125
+             + block(b, c, e, f, w2) * 0.125
+             + block(d, e, g, h, w3) * 0.125
+             + block(e, f, h, i, w4) * 0.125;
+    float weight = w0 * 0.5 + (w1 + w2 + w3 + w4) * 0.125;
+    FragColor = max(sum / weight, 0.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+out vec3 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 texelSize;     // of the source (the smaller level)
+uniform float radius;
+
+// 3x3 tent; the result is added onto the larger level by blending
+void main()
+{
+    vec2 t = texelSize * radius;
+    vec3 sum = texture(source, TexCoords).rgb * 4.0;
+    sum += (texture(source, TexCoords + vec2(-t.x, 0.0)).rgb + texture(source, TexCoords + vec2(t.x, 0.0)).rgb
+          + texture(source, TexCoords + vec2(0.0, -t.y)).rgb + texture(source, TexCoords + vec2(0.0, t.y)).rgb) * 2.0;
+    sum += texture(source, TexCoords + vec2(-t.x, -t.y)).rgb + texture(source, TexCoords + vec2(t.x, -t.y)).rgb
+         + texture(source, TexCoords + vec2(-t.x, t.y)).rgb + texture(source, TexCoords + vec2(t.x, t.y)).rgb;
+    FragColor = sum / 16.0;
+}
@@ -0,0 +1,39 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec3 Normal;
+in vec3 FragPos;
+in vec3 Color;
+flat in float Layer;
+flat in float Emissive;
+
+uniform sampler2DArray diffuseTextures;
+uniform vec3 lightPos;
+
+#ifdef LOG_DEPTH
+in float LogDepth;
+flat in float LogDepthScale;
+#endif
+
+void main()
+{
+#ifdef LOG_DEPTH
+    gl_FragDepth = log2(LogDepth) * LogDepthScale;
+#endif
+    vec3 albedo = Color;
+    if (Layer >= 0.0)
+        albedo *= texture(diffuseTextures, vec3(TexCoord, Layer)).rgb;
+
+    // self-luminous bodies aren't shaded
+    if (Emissive > 0.0)
+    {
+        FragColor = vec4(albedo * Emissive, 1.0);
+        return;
+    }
+
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(normalize(Normal), lightDir), 0.0);
+    FragColor = vec4(albedo * (0.05 + diff), 1.0);
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+// per instance
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aColor;
+layout (location = 8) in vec4 aParams;   // texture layer, emissive
+
+out vec2 TexCoord;
+out vec3 Normal;
+out vec3 FragPos;
+out vec3 Color;
+flat out float Layer;
+flat out float Emissive;
+
+#ifdef LOG_DEPTH
+out float LogDepth;
+flat out float LogDepthScale;
+#endif
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    // uniform scale only, so the model matrix can transform normals directly
+    Normal = mat3(aModel) * aNormal;
+    TexCoord = aTexCoord;
+    // scene colours are sRGB like the textures; lighting works on linear values
+    Color = pow(aColor.rgb, vec3(2.2));
+    Layer = aParams.x;
+    Emissive = aParams.y;
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
+#ifdef LOG_DEPTH
+    // logarithmic depth (DepthMode.h): precision spread evenly over orders of magnitude
+    LogDepth = 1.0 + gl_Position.w;
+    LogDepthScale = 0.5 * depthParams.x;
+    gl_Position.z = (log2(max(1e-6, LogDepth)) * depthParams.x - 1.0) * gl_Position.w;
+#endif
+}
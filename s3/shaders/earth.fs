@@ -4,21 +4,75 @@ out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 Normal;
 in vec3 ViewDir; // Make sure to pass the view direction from the vertex shader
+in vec3 Position;
 
 uniform sampler2D earthTexture;
 uniform sampler2D earthNormalMap;
 uniform sampler2D earthCloudTexture;
 uniform sampler2D earthSpecularMap;
 
-uniform vec3 lightDirection;
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
 uniform float heightScale; // Controls the amount of parallax
 
+#ifdef VIRTUAL_TEXTURE
+// Virtual texture (VirtualTexture.h): the colour map comes from a cache of tiles, found
+// through an indirection texture with one texel per tile and one mip level per pyramid level
+uniform sampler2D vtPhysical;
+uniform sampler2D vtIndirection;
+uniform vec2 vtTiles;          // tiles per side at level 0
+uniform float vtTileSize;
+uniform float vtBorder;
+uniform float vtPhysicalSize;
+uniform int vtMaxLevel;
+uniform float vtLodBias;
+
+vec4 sampleVirtual(vec2 uv)
+{
+    // mip level the texture would have picked, from the level-0 texel footprint
+    vec2 texel = uv * vtTiles * vtTileSize;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtLodBias;
+    int level = clamp(int(floor(lod + 0.5)), 0, vtMaxLevel);
+
+    vec2 tiles = max(floor(vtTiles / float(1 << level)), vec2(1.0));
+    vec2 tileCoord = clamp(uv * tiles, vec2(0.0), tiles - 0.001);
+    vec4 entry = texelFetch(vtIndirection, ivec2(tileCoord), level);
+
+    // the resident tile may be coarser than asked for: locate uv inside it instead
+    int actual = int(entry.b * 255.0 + 0.5);
+    vec2 actualTiles = max(floor(vtTiles / float(1 << actual)), vec2(1.0));
+    vec2 inTile = fract(clamp(uv * actualTiles, vec2(0.0), actualTiles - 0.001));
+    vec2 slot = floor(entry.rg * 255.0 + 0.5);
+    vec2 physical = (slot * (vtTileSize + 2.0 * vtBorder) + vtBorder + inTile * vtTileSize) / vtPhysicalSize;
+    return textureLod(vtPhysical, physical, 0.0);
+}
+#endif
+
 // Atmospheric scattering parameters
 const float atmosphereThickness = 0.01; // Adjust to control the thickness of the atmosphere
 const vec3 atmosphereColor = vec3(0.5, 0.7, 1.0); // Adjust to control the color of the atmosphere
 
+#ifdef LOG_DEPTH
+in float LogDepth;
+flat in float LogDepthScale;
+#endif
+
 void main()
 {
+#ifdef LOG_DEPTH
+    gl_FragDepth = log2(LogDepth) * LogDepthScale;
+#endif
+    vec3 lightDirection = normalize(lightPosition.xyz - Position);
+
     // Parallax mapping for clouds
     vec3 viewDir = normalize(ViewDir);
     float height = texture(earthCloudTexture, TexCoords).r;
@@ -30,8 +84,14 @@ void main()
 
     vec4 cloudColor = vec4(1.0, 1.0, 1.0, cloudHeight * cloudIntensity);
 
+#ifdef VIRTUAL_TEXTURE
+    vec4 earthColor = sampleVirtual(TexCoords);
+#else
     vec4 earthColor = texture(earthTexture, TexCoords);
-    vec3 normal = normalize(texture(earthNormalMap, TexCoords).rgb * 2.0 - 1.0);
+#endif
+    // X and Y only, so BC5 (two-channel) normal maps work; Z is always the positive root
+    vec2 normalXY = texture(earthNormalMap, TexCoords).rg * 2.0 - 1.0;
+    vec3 normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 
     // Specular lighting
     float specularIntensity = texture(earthSpecularMap, TexCoords).r;
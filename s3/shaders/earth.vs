@@ -9,9 +9,22 @@ out vec2 TexCoords;
 out vec3 ViewDir;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 cameraPos; // Add this line
+
+#ifdef LOG_DEPTH
+out float LogDepth;
+flat out float LogDepthScale;
+#endif
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
 
 void main()
 {
@@ -19,6 +32,12 @@ void main()
     Position = vec3(model * vec4(aPos, 1.0));
     TexCoords = aTexCoords;
     vec4 worldPos = model * vec4(aPos, 1.0); // Convert to world space
-    ViewDir = normalize(cameraPos - worldPos.xyz); // Calculate view direction
-    gl_Position = projection * view * worldPos;
+    ViewDir = normalize(cameraPosition.xyz - worldPos.xyz); // Calculate view direction
+    gl_Position = viewProjection * worldPos;
+#ifdef LOG_DEPTH
+    // logarithmic depth (DepthMode.h): precision spread evenly over orders of magnitude
+    LogDepth = 1.0 + gl_Position.w;
+    LogDepthScale = 0.5 * depthParams.x;
+    gl_Position.z = (log2(max(1e-6, LogDepth)) * depthParams.x - 1.0) * gl_Position.w;
+#endif
 }
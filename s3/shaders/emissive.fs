@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+
+#ifdef LOG_DEPTH
+in float LogDepth;
+flat in float LogDepthScale;
+#endif
+
+void main()
+{
+#ifdef LOG_DEPTH
+    gl_FragDepth = log2(LogDepth) * LogDepthScale;
+#endif
+    FragColor = vec4(Color, 1.0);
+}
@@ -4,12 +4,21 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 Position;
 
-uniform vec3 cameraPos;
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
 uniform samplerCube skybox;
 
 void main()
 {    
-    vec3 I = normalize(Position - cameraPos);
+    vec3 I = normalize(Position - cameraPosition.xyz);
     vec3 R = reflect(I, normalize(Normal));
     R.y = -R.y; // Invert the y-component of the reflection vector
     FragColor = vec4(texture(skybox, R).rgb, 1.0);
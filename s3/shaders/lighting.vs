@@ -10,17 +10,32 @@ out vec3 Position;   // Position vector in world space
 
 // Uniforms (matrices)
 uniform mat4 model;        // Model matrix: local space -> world space
-uniform mat4 view;         // View matrix: world space -> camera space
-uniform mat4 projection;   // Projection matrix: camera space -> clip space
+// Quantized meshes store positions as fractions of their bounds (see VertexLayout)
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+
+// Camera and light, shared by every program
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
 
 void main()
 {
+    vec3 localPos = positionOffset + aPos * positionScale;
+
     // Transform the normal vector from local space to world space
     Normal = mat3(transpose(inverse(model))) * aNormal;
 
     // Transform the position vector from local space to world space
-    Position = vec3(model * vec4(aPos, 1.0));
+    Position = vec3(model * vec4(localPos, 1.0));
 
     // Transform the vertex position through all transformation matrices
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(localPos, 1.0);
 }
@@ -0,0 +1,14 @@
+#version 330 core
+
+#ifdef LOG_DEPTH
+in float LogDepth;
+flat in float LogDepthScale;
+#endif
+
+// depth test only; colour writes are off during the query pass
+void main()
+{
+#ifdef LOG_DEPTH
+    gl_FragDepth = log2(LogDepth) * LogDepthScale;
+#endif
+}
@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+#ifdef LOG_DEPTH
+out float LogDepth;
+flat out float LogDepthScale;
+#endif
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+    vec4 depthParams;
+};
+
+void main()
+{
+    gl_Position = viewProjection * vec4(mix(boxMin, boxMax, aPos), 1.0);
+#ifdef LOG_DEPTH
+    // logarithmic depth (DepthMode.h): precision spread evenly over orders of magnitude
+    LogDepth = 1.0 + gl_Position.w;
+    LogDepthScale = 0.5 * depthParams.x;
+    gl_Position.z = (log2(max(1e-6, LogDepth)) * depthParams.x - 1.0) * gl_Position.w;
+#endif
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec3 Color;
+in float Altitude;
+
+void main()
+{
+    // below the horizon
+    if (Altitude < 0.0)
+        discard;
+    FragColor = vec4(Color, 1.0);
+}
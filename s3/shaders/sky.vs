@@ -0,0 +1,33 @@
+#version 330 core
+
+layout (location = 0) in float aX;
+layout (location = 1) in float aY;
+layout (location = 2) in float aZ;
+layout (location = 3) in vec4 aStyle;   // rgb, magnitude
+
+out vec3 Color;
+out float Altitude;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform float magnitudeLimit;
+
+void main()
+{
+    vec3 direction = vec3(aX, aY, aZ);
+    Altitude = direction.y;
+
+    // fainter than the limit, or no direction at all: push outside the clip volume
+    float magnitude = aStyle.w;
+    if (magnitude > magnitudeLimit || dot(direction, direction) < 0.5)
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    // each magnitude is ~2.5x dimmer; bright objects also get bigger points
+    float brightness = clamp(pow(2.512, magnitudeLimit - magnitude - 4.0) * 0.25, 0.05, 1.0);
+    gl_PointSize = clamp(4.0 - 0.5 * magnitude, 1.0, 6.0);
+    Color = aStyle.rgb * brightness;
+    gl_Position = projection * view * vec4(direction, 1.0);
+}
@@ -3,7 +3,15 @@ out vec4 FragColor;
 
 uniform vec3 emissiveColor;
 
+#ifdef LOG_DEPTH
+in float LogDepth;
+flat in float LogDepthScale;
+#endif
+
 void main()
 {
+#ifdef LOG_DEPTH
+    gl_FragDepth = log2(LogDepth) * LogDepthScale;
+#endif
     FragColor = vec4(emissiveColor, 1.0);
 }
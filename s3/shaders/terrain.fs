@@ -0,0 +1,37 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 Direction;
+in float Distance;
+
+uniform sampler2D surfaceTexture;
+uniform vec3 lightDirection;    // towards the sun
+
+const float PI = 3.14159265359;
+
+void main()
+{
+    // same equirectangular layout as the sphere's texture coordinates
+    vec3 d = normalize(Direction);
+    float angle = atan(-d.z, -d.x);
+    if (angle < 0.0)
+        angle += 2.0 * PI;
+    vec2 uv = vec2(1.0 - angle / (2.0 * PI), acos(clamp(-d.y, -1.0, 1.0)) / PI);
+
+    // take the derivatives from a copy of u with its seam on the far side, so the mip level
+    // doesn't collapse along the date line
+    float seamless = fract(uv.x + 0.5) - 0.5;
+    bool useSeamless = fwidth(seamless) < fwidth(uv.x);
+    vec2 dx = vec2(useSeamless ? dFdx(seamless) : dFdx(uv.x), dFdx(uv.y));
+    vec2 dy = vec2(useSeamless ? dFdy(seamless) : dFdy(uv.x), dFdy(uv.y));
+    vec3 albedo = textureGrad(surfaceTexture, uv, dx, dy).rgb;
+
+    float diffuse = max(dot(normalize(Normal), lightDirection), 0.0);
+    vec3 color = albedo * (0.05 + 0.95 * diffuse);
+
+    // a little haze towards the horizon
+    float haze = 1.0 - exp(-Distance / 400.0);
+    color = mix(color, vec3(0.45, 0.6, 0.85) * (0.1 + 0.9 * max(dot(d, lightDirection), 0.0)), haze * 0.6);
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;         // relative to the chunk centre, km
+layout (location = 1) in vec3 aMorph;       // offset to the vertex's place on the parent grid
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec3 aDirection;   // from the planet centre, for texturing
+
+out vec3 Normal;
+out vec3 Direction;
+out float Distance;
+
+uniform mat4 viewProjection;   // eye at the origin
+uniform vec3 chunkOffset;      // chunk centre minus eye, km
+uniform vec2 morphRange;       // start, end distance of the blend to the parent grid
+
+void main()
+{
+    vec3 position = chunkOffset + aPos;
+    float morph = clamp((length(position) - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+    position += aMorph * morph;
+
+    Normal = aNormal;
+    Direction = aDirection;
+    Distance = length(position);
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
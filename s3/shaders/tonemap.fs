@@ -0,0 +1,42 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform sampler2D bloom;
+uniform vec2 bloomTexelSize;
+uniform float bloomStrength;
+uniform float bloomNormalization;   // 1 / levels: the top level holds the sum of all of them
+uniform float exposure;     // EV
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 acesFilm(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+// the piecewise sRGB transfer function; the default framebuffer isn't GL_FRAMEBUFFER_SRGB
+// since ImGui draws into it afterwards in display values
+vec3 linearToSrgb(vec3 x)
+{
+    return mix(x * 12.92, 1.055 * pow(x, vec3(1.0 / 2.4)) - 0.055, step(vec3(0.0031308), x));
+}
+
+void main()
+{
+    vec3 color = texture(scene, TexCoords).rgb;
+
+    // last tent upsample of the glow, straight from the half-resolution level
+    vec2 t = bloomTexelSize;
+    vec3 glow = texture(bloom, TexCoords).rgb * 4.0;
+    glow += (texture(bloom, TexCoords + vec2(-t.x, 0.0)).rgb + texture(bloom, TexCoords + vec2(t.x, 0.0)).rgb
+           + texture(bloom, TexCoords + vec2(0.0, -t.y)).rgb + texture(bloom, TexCoords + vec2(0.0, t.y)).rgb) * 2.0;
+    glow += texture(bloom, TexCoords + vec2(-t.x, -t.y)).rgb + texture(bloom, TexCoords + vec2(t.x, -t.y)).rgb
+          + texture(bloom, TexCoords + vec2(-t.x, t.y)).rgb + texture(bloom, TexCoords + vec2(t.x, t.y)).rgb;
+    color = mix(color, glow / 16.0 * bloomNormalization, bloomStrength);
+
+    // the scene is linear (colour textures are sampled through sRGB formats), so exposure and
+    // the tone curve act on light; the result is encoded for the display
+    FragColor = vec4(linearToSrgb(acesFilm(color * exp2(exposure))), 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// Feedback pass of the virtual texture (VirtualTexture.h), drawn with the surface's own
+// vertex shader: each pixel records the tile and level the real draw will sample, packed
+// as x (12 bits), y (12 bits) and level + 1 in alpha, so 0 means "nothing here"
+uniform vec2 vtTiles;
+uniform float vtTileSize;
+uniform int vtMaxLevel;
+uniform float vtLodBias;
+
+void main()
+{
+    vec2 texel = TexCoords * vtTiles * vtTileSize;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtLodBias;
+    int level = clamp(int(floor(lod + 0.5)), 0, vtMaxLevel);
+
+    vec2 tiles = max(floor(vtTiles / float(1 << level)), vec2(1.0));
+    ivec2 tile = ivec2(clamp(TexCoords * tiles, vec2(0.0), tiles - 0.001));
+    FragColor = vec4(float(tile.x & 255), float(tile.y & 255),
+        float((tile.x >> 8) | ((tile.y >> 8) << 4)), float(level + 1)) / 255.0;
+}
@@ -3,6 +3,7 @@
 #define SPACEOBJECT_H
 
 #include "glm.hpp"
+#include "Orbit.h"
 #include <string>
 
 class SpaceObject {
@@ -24,10 +25,16 @@ public:
     float getRadius() const { return radius; }
     const std::string& getName() const { return name; }
 
+    // heliocentric ephemeris (AU, AU/day, days since J2000); bodies without elements sit at the origin
+    void setOrbit(const OrbitalElements& elements) { orbit = elements; }
+    const OrbitalElements& getOrbit() const { return orbit; }
+    void getStateAt(double days, glm::dvec3& r, glm::dvec3& v) const { orbitalState(orbit, days, r, v); }
+
 protected:
     glm::vec3 position;
     float radius;
     std::string name;
+    OrbitalElements orbit;
 };
 
 #endif // SPACEOBJECT_H
\ No newline at end of file